@@ -0,0 +1,60 @@
+#define _GNU_SOURCE
+#include <string.h>
+
+#include "adapt.h"
+#include "dlog.h"
+
+void adapt_init(struct adapt_t * adapt, uint64_t min_period) {
+    memset(adapt, 0, sizeof(*adapt));
+    pthread_mutex_init(&adapt->lock, NULL);
+    adapt->min_period = min_period;
+}
+
+void adapt_add(struct adapt_t * adapt, int c, float threshold, uint64_t floor) {
+    adapt->channel[c] = (struct adapt_channel_t) {
+        enabled: (threshold > 0) && (adapt->min_period) && (floor > adapt->min_period),
+        threshold: threshold,
+        floor: floor,
+        period: floor,
+    };
+}
+
+uint64_t adapt_update(struct adapt_t * adapt, int c, float change, uint64_t interval) {
+    struct adapt_channel_t * channel = &adapt->channel[c];
+    uint64_t period;
+
+    if (!channel->enabled)
+        return 0;
+    pthread_mutex_lock(&adapt->lock);
+    if (interval < SCHEDULE_MIN_PERIOD_USEC) {
+        /* too close to the reading before to tell */
+    } else if (change * (float)channel->floor / (float)interval >= channel->threshold) {
+        channel->calm = 0;
+        if (channel->period > adapt->min_period) {
+            channel->period = adapt->min_period;
+            channel->speedups++;
+        }
+    } else if ((++channel->calm >= ADAPT_SETTLE) && (channel->period < channel->floor)) {
+        channel->calm = 0;
+        channel->period = (channel->period * 2 < channel->floor) ? channel->period * 2 : channel->floor;
+        channel->slowdowns++;
+    }
+    period = channel->period;
+    pthread_mutex_unlock(&adapt->lock);
+    return period;
+}
+
+void adapt_log_stats(struct adapt_t * adapt, const char * name, int c, const char * channel_name) {
+    struct adapt_channel_t * channel = &adapt->channel[c];
+
+    if (!channel->enabled)
+        return;
+    pthread_mutex_lock(&adapt->lock);
+    daemon_log(LOG_INFO, "%s %s adaptive %llu.%03llu .. %llu.%03llu ms, at %llu.%03llu ms, %llu speedups, %llu slowdowns",
+               name, channel_name,
+               (unsigned long long)adapt->min_period / 1000, (unsigned long long)adapt->min_period % 1000,
+               (unsigned long long)channel->floor / 1000, (unsigned long long)channel->floor % 1000,
+               (unsigned long long)channel->period / 1000, (unsigned long long)channel->period % 1000,
+               (unsigned long long)channel->speedups, (unsigned long long)channel->slowdowns);
+    pthread_mutex_unlock(&adapt->lock);
+}
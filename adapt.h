@@ -0,0 +1,50 @@
+#ifndef ADAPT_H_INCLUDED
+#define ADAPT_H_INCLUDED
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#include "schedule.h"
+
+/* Adaptive sampling rate, per channel. The threshold is a move over
+ * the channel's floor period, a change between two readings is scaled
+ * to it by the time that passed between them, so a steady ramp counts
+ * the same at any period, after an overrun as well. A reading taken
+ * under SCHEDULE_MIN_PERIOD_USEC after the one before (a channel that
+ * was just sped up starts over at once) is too close to tell, it leaves
+ * the channel as it is. A reading that moved by the threshold or more takes the
+ * channel to the fastest period at once, ADAPT_SETTLE readings in a row
+ * under it double the period again, up to the floor.
+ */
+
+#ifndef ADAPT_SETTLE
+#define ADAPT_SETTLE 3
+#endif
+
+struct adapt_channel_t {
+    bool enabled;
+    float threshold;            /* in the units of the output */
+    uint64_t floor;             /* the slowest period, usec */
+    uint64_t period;
+    unsigned int calm;          /* readings under the threshold in a row */
+    uint64_t speedups;
+    uint64_t slowdowns;
+};
+
+struct adapt_t {
+    uint64_t min_period;        /* the fastest, usec */
+    struct adapt_channel_t channel[SCHEDULE_MAX_ENTRIES];
+    /* stats are logged from another thread */
+    pthread_mutex_t lock;
+};
+
+void adapt_init(struct adapt_t * adapt, uint64_t min_period);
+/* the channel starts at floor, a threshold of 0 or a floor not over
+   min_period leaves it fixed */
+void adapt_add(struct adapt_t * adapt, int c, float threshold, uint64_t floor);
+/* the period after a reading that moved by change in interval usec, as
+   measured, since the one before, 0 for a fixed channel */
+uint64_t adapt_update(struct adapt_t * adapt, int c, float change, uint64_t interval);
+void adapt_log_stats(struct adapt_t * adapt, const char * name, int c, const char * channel);
+
+#endif // ADAPT_H_INCLUDED
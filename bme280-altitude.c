@@ -0,0 +1,41 @@
+#include <math.h>
+#include <pthread.h>
+#include "bme280-altitude.h"
+
+/* (BME280_ALTITUDE_RATIO_MAX - BME280_ALTITUDE_RATIO_MIN) * STEPS + 2,
+   spelled out in integers for the array size */
+#define BME280_ALTITUDE_ENTRIES (BME280_ALTITUDE_STEPS * 825 / 1000 + 2)
+
+static float altitude_table[BME280_ALTITUDE_ENTRIES];
+static pthread_once_t altitude_once = PTHREAD_ONCE_INIT;
+
+static void altitude_table_init() {
+    for (int i = 0; i < BME280_ALTITUDE_ENTRIES; i++) {
+        double ratio = BME280_ALTITUDE_RATIO_MIN + (double)i / BME280_ALTITUDE_STEPS;
+        altitude_table[i] = 44330.0 * (1.0 - pow(ratio, 0.1903));
+    }
+}
+
+static inline float altitude_lookup(float ratio) {
+    float x;
+    int i;
+
+    if ((ratio < BME280_ALTITUDE_RATIO_MIN) || (ratio >= BME280_ALTITUDE_RATIO_MAX))
+        return 44330.0 * (1.0 - pow(ratio, 0.1903));
+    x = (ratio - BME280_ALTITUDE_RATIO_MIN) * BME280_ALTITUDE_STEPS;
+    i = (int)x;
+    return altitude_table[i] + (x - i) * (altitude_table[i + 1] - altitude_table[i]);
+}
+
+float bme280_altitude(u32 pressure, float sea_level) {
+    pthread_once(&altitude_once, altitude_table_init);
+    return altitude_lookup((float)pressure / (sea_level * 100.0f));
+}
+
+void bme280_altitude_batch(const u32 * pressure, float * altitude, size_t count, float sea_level) {
+    float scale = 1.0f / (sea_level * 100.0f);
+
+    pthread_once(&altitude_once, altitude_table_init);
+    for (size_t i = 0; i < count; i++)
+        altitude[i] = altitude_lookup((float)pressure[i] * scale);
+}
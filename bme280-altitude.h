@@ -0,0 +1,28 @@
+#ifndef BME280_ALTITUDE_H_INCLUDED
+#define BME280_ALTITUDE_H_INCLUDED
+#include <stddef.h>
+#include "bme280.h"
+
+/* Barometric altitude, 44330 * (1 - (P / P0) ^ 0.1903), without a pow()
+ * per sample. The curve is tabulated once over the pressure ratio P / P0
+ * and interpolated linearly; ratios outside the table (more than 600 m
+ * under sea level or above about 10 km) go through pow().
+ *
+ * With BME280_ALTITUDE_STEPS steps per unit of ratio the interpolation
+ * error is at most 44330 / 8 * 0.1903 * 0.8097 * 0.25^-1.81 / STEPS^2,
+ * 0.010 m for the default; float rounding adds up to about 0.005 m. P is in Pa and P0 in hPa as for
+ * bme280_readAltitude, which stays the libm reference.
+ */
+
+#ifndef BME280_ALTITUDE_STEPS
+#define BME280_ALTITUDE_STEPS 1024
+#endif
+#define BME280_ALTITUDE_RATIO_MIN 0.25f
+#define BME280_ALTITUDE_RATIO_MAX 1.075f
+
+float bme280_altitude(u32 pressure, float sea_level);
+/* the same for count samples, for recomputing a history after the
+   sea level pressure has been corrected */
+void bme280_altitude_batch(const u32 * pressure, float * altitude, size_t count, float sea_level);
+
+#endif // BME280_ALTITUDE_H_INCLUDED
@@ -0,0 +1,198 @@
+#include <string.h>
+#include "bme280-batch.h"
+
+typedef s32 bme280_vs32_t __attribute__((vector_size(BME280_BATCH_LANES * sizeof(s32))));
+typedef u32 bme280_vu32_t __attribute__((vector_size(BME280_BATCH_LANES * sizeof(u32))));
+/* the division runs on 4 lanes at a time, 4 doubles fill an AVX register */
+#define BME280_BATCH_DIV_LANES 4
+typedef s32 bme280_vs32x4_t __attribute__((vector_size(BME280_BATCH_DIV_LANES * sizeof(s32))));
+typedef s64 bme280_vs64x4_t __attribute__((vector_size(BME280_BATCH_DIV_LANES * sizeof(s64))));
+typedef double bme280_vf64x4_t __attribute__((vector_size(BME280_BATCH_DIV_LANES * sizeof(double))));
+
+#if defined(__x86_64__) && defined(__GNUC__) && !defined(__clang__) && !defined(BME280_BATCH_NO_CLONES)
+#define BME280_BATCH_TARGETS __attribute__((target_clones("avx2", "default")))
+#else
+#define BME280_BATCH_TARGETS
+#endif
+
+#define BME280_BATCH_INLINE static inline __attribute__((always_inline))
+
+/* Trimming parameters spread over all lanes once per call. Keeping them
+   in locals also tells the compiler the output stores can not change
+   them, else every field is reloaded for every block. */
+struct bme280_batch_cal_t {
+    bme280_vs32_t T1, T2, T3;
+    bme280_vs32_t P1, P2, P3, P4, P5, P6, P7, P8, P9;
+    bme280_vs32_t H1, H2, H3, H4, H5, H6;
+};
+
+BME280_BATCH_INLINE
+void bme280_batch_cal(struct bme280_batch_cal_t * v, const struct bme280_calibration_param_t * cal) {
+    const bme280_vs32_t zero = {};
+
+    v->T1 = zero + (s32)cal->dig_T1;
+    v->T2 = zero + (s32)cal->dig_T2;
+    v->T3 = zero + (s32)cal->dig_T3;
+    v->P1 = zero + (s32)cal->dig_P1;
+    v->P2 = zero + (s32)cal->dig_P2;
+    v->P3 = zero + (s32)cal->dig_P3;
+    v->P4 = zero + (s32)cal->dig_P4;
+    v->P5 = zero + (s32)cal->dig_P5;
+    v->P6 = zero + (s32)cal->dig_P6;
+    v->P7 = zero + (s32)cal->dig_P7;
+    v->P8 = zero + (s32)cal->dig_P8;
+    v->P9 = zero + (s32)cal->dig_P9;
+    v->H1 = zero + (s32)cal->dig_H1;
+    v->H2 = zero + (s32)cal->dig_H2;
+    v->H3 = zero + (s32)cal->dig_H3;
+    v->H4 = zero + (s32)cal->dig_H4;
+    v->H5 = zero + (s32)cal->dig_H5;
+    v->H6 = zero + (s32)cal->dig_H6;
+}
+
+/* Helpers take and return vectors through pointers, vector arguments
+   would tie the ABI to the instruction set of each clone */
+
+/* Unsigned 32 bit division in double lanes. For a < 2^32 and b >= 1 the
+   rounded double quotient stays below floor(a / b) + 1, so truncating
+   it gives exactly the integer quotient. Quotients at or above 2^31 are
+   shifted down by 2^31 for the signed conversion and back up after. */
+BME280_BATCH_INLINE
+void bme280_batch_udiv(bme280_vu32_t * q, const bme280_vu32_t * a, const bme280_vu32_t * b) {
+    const bme280_vs32x4_t bias = {INT32_MIN, INT32_MIN, INT32_MIN, INT32_MIN};
+    const bme280_vf64x4_t two31 = {2147483648.0, 2147483648.0, 2147483648.0, 2147483648.0};
+
+    for (int h = 0; h < BME280_BATCH_LANES; h += BME280_BATCH_DIV_LANES) {
+        bme280_vs32x4_t ia, ib, iq;
+        bme280_vf64x4_t fa, fb, fq;
+        bme280_vs64x4_t big;
+
+        memcpy(&ia, (const u32 *)a + h, sizeof(ia));
+        memcpy(&ib, (const u32 *)b + h, sizeof(ib));
+        fa = __builtin_convertvector(ia ^ bias, bme280_vf64x4_t) + two31;
+        fb = __builtin_convertvector(ib ^ bias, bme280_vf64x4_t) + two31;
+        fq = fa / fb;
+        big = (fq >= two31);
+        fq -= (bme280_vf64x4_t)((bme280_vs64x4_t)two31 & big);
+        iq = __builtin_convertvector(fq, bme280_vs32x4_t);
+        iq ^= __builtin_convertvector(big, bme280_vs32x4_t) & bias;
+        memcpy((u32 *)q + h, &iq, sizeof(iq));
+    }
+}
+
+/* Each step mirrors the scalar reference in bme280.c, including its
+   casts, so that the results match bit for bit */
+BME280_BATCH_INLINE
+void bme280_batch_t_fine(bme280_vs32_t * t_fine, const struct bme280_batch_cal_t * cal, const bme280_vs32_t * ut) {
+    bme280_vs32_t d = (*ut >> 4) - cal->T1;
+    bme280_vs32_t x1 = (((*ut >> 3) - (cal->T1 << 1)) * cal->T2) >> 11;
+    bme280_vs32_t x2 = (((d * d) >> 12) * cal->T3) >> 14;
+
+    *t_fine = x1 + x2;
+}
+
+BME280_BATCH_INLINE
+void bme280_batch_pressure(bme280_vu32_t * pressure, const struct bme280_batch_cal_t * cal,
+                           const bme280_vs32_t * t_fine, const bme280_vs32_t * up) {
+    bme280_vs32_t x1 = (*t_fine >> 1) - 64000;
+    bme280_vs32_t q = x1 >> 2;
+    bme280_vs32_t x2 = ((q * q) >> 11) * cal->P6;
+    bme280_vs32_t invalid;
+    bme280_vs32_t small;
+    bme280_vu32_t p, a, b;
+
+    x2 = x2 + ((x1 * cal->P5) << 1);
+    x2 = (x2 >> 2) + (cal->P4 << 16);
+    x1 = (((cal->P3 * ((q * q) >> 13)) >> 3) + ((cal->P2 * x1) >> 1)) >> 18;
+    x1 = ((32768 + x1) * cal->P1) >> 15;
+
+    p = ((bme280_vu32_t)(1048576 - *up) - (bme280_vu32_t)(x2 >> 12)) * 3125;
+    invalid = (x1 == 0);
+    small = (p < 0x80000000);
+    /* (p << 1) / x1 below 2^31, (p / x1) * 2 above, x1 == 0 is invalid */
+    a = p << (1 & small);
+    b = (bme280_vu32_t)x1 | ((bme280_vu32_t)invalid & 1);
+    bme280_batch_udiv(&p, &a, &b);
+    p = p << (1 & ~small);
+
+    x1 = (cal->P9 * (bme280_vs32_t)(((p >> 3) * (p >> 3)) >> 13)) >> 12;
+    x2 = ((bme280_vs32_t)(p >> 2) * cal->P8) >> 13;
+    p = (bme280_vu32_t)((bme280_vs32_t)p + ((x1 + x2 + cal->P7) >> 4));
+    *pressure = p & (bme280_vu32_t)~invalid;
+}
+
+BME280_BATCH_INLINE
+void bme280_batch_humidity(bme280_vu32_t * humidity, const struct bme280_batch_cal_t * cal,
+                           const bme280_vs32_t * t_fine, const bme280_vs32_t * uh) {
+    bme280_vs32_t x = *t_fine - 76800;
+    bme280_vs32_t a = (((*uh << 14) - (cal->H4 << 20) - (cal->H5 * x)) + 16384) >> 15;
+    bme280_vs32_t b = ((((((x * cal->H6) >> 10) * (((x * cal->H3) >> 11) + 32768)) >> 10) +
+                        2097152) * cal->H2 + 8192) >> 14;
+
+    x = a * b;
+    x = x - (((((x >> 15) * (x >> 15)) >> 7) * cal->H1) >> 4);
+    x = x & ~(x < 0);
+    x = (x & ~(x > 419430400)) | (419430400 & (x > 419430400));
+    *humidity = (bme280_vu32_t)(x >> 12);
+}
+
+BME280_BATCH_INLINE
+void bme280_batch_lanes(const struct bme280_batch_cal_t * cal, const s32 * up, const s32 * ut, const s32 * uh,
+                        u32 * p, s32 * t, u32 * h, s32 * tf) {
+    bme280_vs32_t v_up, v_ut, v_uh, v_tf, v_t;
+    bme280_vu32_t v_p, v_h;
+
+    memcpy(&v_ut, ut, sizeof(v_ut));
+    memcpy(&v_up, up, sizeof(v_up));
+    bme280_batch_t_fine(&v_tf, cal, &v_ut);
+    v_t = (v_tf * 5 + 128) >> 8;
+    bme280_batch_pressure(&v_p, cal, &v_tf, &v_up);
+    memcpy(t, &v_t, sizeof(v_t));
+    memcpy(p, &v_p, sizeof(v_p));
+    if (tf)
+        memcpy(tf, &v_tf, sizeof(v_tf));
+    if (uh) {
+        memcpy(&v_uh, uh, sizeof(v_uh));
+        bme280_batch_humidity(&v_h, cal, &v_tf, &v_uh);
+        memcpy(h, &v_h, sizeof(v_h));
+    }
+}
+
+BME280_BATCH_TARGETS
+void bme280_compensate_batch(const struct bme280_calibration_param_t * cal_param,
+                             const s32 * uncomp_pressure, const s32 * uncomp_temperature, const s32 * uncomp_humidity,
+                             u32 * pressure, s32 * temperature, u32 * humidity, s32 * t_fine, size_t count) {
+    const s32 * uh = (humidity) ? uncomp_humidity : NULL;
+    struct bme280_batch_cal_t cal;
+    size_t i;
+
+    bme280_batch_cal(&cal, cal_param);
+    for (i = 0; i + BME280_BATCH_LANES <= count; i += BME280_BATCH_LANES) {
+        bme280_batch_lanes(&cal, uncomp_pressure + i, uncomp_temperature + i, uh ? uh + i : NULL,
+                           pressure + i, temperature + i, humidity ? humidity + i : NULL, t_fine ? t_fine + i : NULL);
+    }
+
+    /* the tail goes through a padded block, padding lanes repeat the
+       last frame so they stay on the valid path */
+    if (i < count) {
+        size_t n = count - i;
+        s32 up[BME280_BATCH_LANES], ut[BME280_BATCH_LANES], h_in[BME280_BATCH_LANES], tf[BME280_BATCH_LANES];
+        s32 t[BME280_BATCH_LANES];
+        u32 p[BME280_BATCH_LANES], h[BME280_BATCH_LANES];
+
+        for (size_t l = 0; l < BME280_BATCH_LANES; l++) {
+            size_t k = i + ((l < n) ? l : n - 1);
+
+            up[l] = uncomp_pressure[k];
+            ut[l] = uncomp_temperature[k];
+            h_in[l] = uh ? uh[k] : 0;
+        }
+        bme280_batch_lanes(&cal, up, ut, uh ? h_in : NULL, p, t, h, tf);
+        memcpy(pressure + i, p, n * sizeof(*p));
+        memcpy(temperature + i, t, n * sizeof(*t));
+        if (humidity)
+            memcpy(humidity + i, h, n * sizeof(*h));
+        if (t_fine)
+            memcpy(t_fine + i, tf, n * sizeof(*tf));
+    }
+}
@@ -0,0 +1,28 @@
+#ifndef BME280_BATCH_H_INCLUDED
+#define BME280_BATCH_H_INCLUDED
+#include <stddef.h>
+#include "bme280.h"
+
+/* Compensation of many raw frames at once, for backfill and reprocessing
+ * of archived data. Frames are given as separate arrays (structure of
+ * arrays) so BME280_BATCH_LANES of them go through each step together.
+ * The results are bit for bit those of bme280_compensate_temperature_int32,
+ * bme280_compensate_pressure_int32 and bme280_compensate_humidity_int32.
+ *
+ * The arithmetic is written with GCC vector extensions: SSE2 or AVX2 on
+ * x86-64 (picked at run time), NEON on ARM when the compiler targets it.
+ * The pressure division, for which there is no integer SIMD instruction,
+ * is done exactly in double lanes.
+ */
+
+#ifndef BME280_BATCH_LANES
+#define BME280_BATCH_LANES 8
+#endif
+
+/* uncomp_humidity and humidity may be NULL (BMP280 frames), t_fine may
+   be NULL or receive the per frame t_fine */
+void bme280_compensate_batch(const struct bme280_calibration_param_t * cal,
+                             const s32 * uncomp_pressure, const s32 * uncomp_temperature, const s32 * uncomp_humidity,
+                             u32 * pressure, s32 * temperature, u32 * humidity, s32 * t_fine, size_t count);
+
+#endif // BME280_BATCH_H_INCLUDED
@@ -0,0 +1,275 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+
+#include "bme280.h"
+#include "bme280-batch.h"
+#include "bme280-altitude.h"
+#include "bme280-i2c.h"
+
+/* Scalar against batch compensation of BME280 raw frames. Checks that
+ * both give the same bits, on the datasheet trimming values and on a
+ * few random ones, then times them. Then times each compensation
+ * backend and gives its worst error against the unrounded double
+ * formulas, and the table altitude against the pow() one.
+ *
+ *   bme280-bench [frames] [rounds]
+ */
+
+static const struct bme280_calibration_param_t datasheet_cal = {
+    dig_T1: 27504, dig_T2: 26435, dig_T3: -1000,
+    dig_P1: 36477, dig_P2: -10685, dig_P3: 3024, dig_P4: 2855, dig_P5: 140,
+    dig_P6: -7, dig_P7: 15500, dig_P8: -14600, dig_P9: 6000,
+    dig_H1: 75, dig_H2: 362, dig_H3: 0, dig_H4: 313, dig_H5: 50, dig_H6: 30,
+};
+
+struct frames_t {
+    size_t count;
+    s32 * up, * ut, * uh;
+    u32 * p, * h;
+    s32 * t, * tf;
+};
+
+static double now_sec() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void random_cal(struct bme280_calibration_param_t * cal) {
+    *cal = datasheet_cal;
+    cal->dig_T1 = 26000 + rand() % 3000;
+    cal->dig_T2 = 25000 + rand() % 3000;
+    cal->dig_T3 = -(rand() % 2000);
+    cal->dig_P1 = 35000 + rand() % 3000;
+    cal->dig_P2 = -(10000 + rand() % 2000);
+    cal->dig_P3 = rand() % 4000;
+    cal->dig_P4 = rand() % 9000 - 1000;
+    cal->dig_P5 = rand() % 400 - 200;
+    cal->dig_P6 = rand() % 20 - 10;
+    cal->dig_P7 = rand() % 20000;
+    cal->dig_P8 = -(rand() % 20000);
+    cal->dig_P9 = rand() % 8000;
+    cal->dig_H1 = rand() % 256;
+    cal->dig_H2 = 300 + rand() % 150;
+    cal->dig_H3 = rand() % 256;
+    cal->dig_H4 = 250 + rand() % 150;
+    cal->dig_H5 = rand() % 100;
+    cal->dig_H6 = rand() % 128;
+}
+
+static void frames_alloc(struct frames_t * f, size_t count) {
+    f->count = count;
+    f->up = malloc(count * sizeof(s32));
+    f->ut = malloc(count * sizeof(s32));
+    f->uh = malloc(count * sizeof(s32));
+    f->p = malloc(count * sizeof(u32));
+    f->h = malloc(count * sizeof(u32));
+    f->t = malloc(count * sizeof(s32));
+    f->tf = malloc(count * sizeof(s32));
+    if (!f->up || !f->ut || !f->uh || !f->p || !f->h || !f->t || !f->tf) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+    /* 20 bit temperature and pressure, 16 bit humidity, around the
+       datasheet example with room to both sides */
+    for (size_t i = 0; i < count; i++) {
+        f->ut[i] = 519888 + (rand() % 200001) - 100000;
+        f->up[i] = 415148 + (rand() % 400001) - 200000;
+        f->uh[i] = rand() % 65536;
+    }
+}
+
+static void scalar(struct bme280_t * bme280, struct frames_t * f) {
+    for (size_t i = 0; i < f->count; i++) {
+        f->t[i] = bme280_compensate_temperature_int32(bme280, f->ut[i]);
+        f->tf[i] = bme280->cal_param.t_fine;
+        f->p[i] = bme280_compensate_pressure_int32(bme280, f->up[i]);
+        f->h[i] = bme280_compensate_humidity_int32(bme280, f->uh[i]);
+    }
+}
+
+static void batch(struct bme280_t * bme280, struct frames_t * f) {
+    bme280_compensate_batch(&bme280->cal_param, f->up, f->ut, f->uh, f->p, f->t, f->h, f->tf, f->count);
+}
+
+/* unrounded double compensation, T in DegC, P in Pa, H in %RH */
+struct reference_t {
+    double * t, * p, * h;
+};
+
+static void reference(struct bme280_t * bme280, const struct frames_t * f, struct reference_t * ref) {
+    ref->t = malloc(f->count * sizeof(double));
+    ref->p = malloc(f->count * sizeof(double));
+    ref->h = malloc(f->count * sizeof(double));
+    if (!ref->t || !ref->p || !ref->h) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+    for (size_t i = 0; i < f->count; i++) {
+        ref->t[i] = bme280_compensate_temperature_double(bme280, f->ut[i]);
+        ref->p[i] = bme280_compensate_pressure_double(bme280, f->up[i]);
+        ref->h[i] = bme280_compensate_humidity_double(bme280, f->uh[i]);
+    }
+}
+
+static void backend(struct bme280_t * bme280, struct frames_t * f) {
+    for (size_t i = 0; i < f->count; i++)
+        bme280_compensate_pressure_temperature_humidity(bme280, f->up[i], f->ut[i], f->uh[i],
+                &f->p[i], &f->t[i], &f->h[i]);
+}
+
+/* against the double formulas on every frame, humidity is clamped to
+   0 .. 100 %rH by both */
+static void max_error(const struct frames_t * f, const struct reference_t * ref, double err[3]) {
+    err[0] = err[1] = err[2] = 0;
+    for (size_t i = 0; i < f->count; i++) {
+        double t = fabs(f->t[i] / 100.0 - ref->t[i]);
+        double p = fabs(f->p[i] - ref->p[i]);
+        double h = fabs(f->h[i] / 1024.0 - ref->h[i]);
+        if (t > err[0]) err[0] = t;
+        if (p > err[1]) err[1] = p;
+        if (h > err[2]) err[2] = h;
+    }
+}
+
+/* pressures from sea level to about 9 km, on a few sea level pressures */
+static void altitude(size_t count, int rounds) {
+    static const float sea_levels[] = {980.0, 1013.25, 1024.25, 1045.0};
+    u32 * pressure = malloc(count * sizeof(u32));
+    float * alt = malloc(count * sizeof(float));
+    double err = 0, t0, t_pow, t_table, t_batch;
+    volatile float sink = 0;
+
+    if (!pressure || !alt) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+    for (size_t i = 0; i < count; i++)
+        pressure[i] = 30000 + rand() % 80000;
+    for (size_t k = 0; k < sizeof(sea_levels) / sizeof(sea_levels[0]); k++) {
+        bme280_altitude_batch(pressure, alt, count, sea_levels[k]);
+        for (size_t i = 0; i < count; i++) {
+            double ref = 44330.0 * (1.0 - pow(pressure[i] / (sea_levels[k] * 100.0), 0.1903));
+            double e = fabs(bme280_altitude(pressure[i], sea_levels[k]) - ref);
+            if (e > err) err = e;
+            e = fabs(alt[i] - ref);
+            if (e > err) err = e;
+        }
+    }
+
+    t0 = now_sec();
+    for (int r = 0; r < rounds; r++)
+        for (size_t i = 0; i < count; i++)
+            sink += bme280_readAltitude(pressure[i], 1013.25);
+    t_pow = (now_sec() - t0) / rounds;
+    t0 = now_sec();
+    for (int r = 0; r < rounds; r++)
+        for (size_t i = 0; i < count; i++)
+            sink += bme280_altitude(pressure[i], 1013.25);
+    t_table = (now_sec() - t0) / rounds;
+    t0 = now_sec();
+    for (int r = 0; r < rounds; r++)
+        bme280_altitude_batch(pressure, alt, count, 1013.25);
+    t_batch = (now_sec() - t0) / rounds;
+
+    printf("\naltitude, max error %.4f m\n", err);
+    printf("pow    %8.2f ns/sample\n", t_pow * 1e9 / count);
+    printf("table  %8.2f ns/sample, %.2fx\n", t_table * 1e9 / count, t_pow / t_table);
+    printf("batch  %8.2f ns/sample, %.2fx\n", t_batch * 1e9 / count, t_pow / t_batch);
+    free(pressure);
+    free(alt);
+}
+
+static size_t compare(const struct frames_t * a, const struct frames_t * b) {
+    size_t bad = 0;
+
+    for (size_t i = 0; i < a->count; i++) {
+        if ((a->t[i] != b->t[i]) || (a->p[i] != b->p[i]) || (a->h[i] != b->h[i]) || (a->tf[i] != b->tf[i])) {
+            if (bad < 5)
+                fprintf(stderr, "frame %zu: T %d/%d P %u/%u H %u/%u\n", i, a->t[i], b->t[i], a->p[i], b->p[i],
+                        a->h[i], b->h[i]);
+            bad++;
+        }
+    }
+    return bad;
+}
+
+int main(int argc, char ** argv) {
+    size_t count = (argc > 1) ? strtoul(argv[1], NULL, 0) : 1 << 20;
+    int rounds = (argc > 2) ? atoi(argv[2]) : 10;
+    struct bme280_t bme280 = {};
+    struct frames_t a, b;
+    size_t bad = 0;
+    double t0, t_scalar, t_batch;
+
+    srand(1);
+    frames_alloc(&a, count);
+    b = a;
+    b.p = malloc(count * sizeof(u32));
+    b.h = malloc(count * sizeof(u32));
+    b.t = malloc(count * sizeof(s32));
+    b.tf = malloc(count * sizeof(s32));
+
+    for (int c = 0; c < 4; c++) {
+        if (c == 0)
+            bme280.cal_param = datasheet_cal;
+        else
+            random_cal(&bme280.cal_param);
+        bme280_compute_coefficients(&bme280);
+        scalar(&bme280, &a);
+        batch(&bme280, &b);
+        bad += compare(&a, &b);
+    }
+    printf("%zu frames x 4 calibrations, %zu mismatches\n", count, bad);
+
+    bme280.cal_param = datasheet_cal;
+    bme280_compute_coefficients(&bme280);
+    t0 = now_sec();
+    for (int r = 0; r < rounds; r++)
+        scalar(&bme280, &a);
+    t_scalar = (now_sec() - t0) / rounds;
+    t0 = now_sec();
+    for (int r = 0; r < rounds; r++)
+        batch(&bme280, &b);
+    t_batch = (now_sec() - t0) / rounds;
+
+    printf("scalar %8.2f ns/frame\n", t_scalar * 1e9 / count);
+    printf("batch  %8.2f ns/frame (%d lanes), %.2fx\n", t_batch * 1e9 / count, BME280_BATCH_LANES, t_scalar / t_batch);
+
+    static const struct {
+        const char * name;
+        u8 compensation;
+    } backends[] = {
+        {"int32", BME280_COMPENSATION_INT32},
+        {"int64", BME280_COMPENSATION_INT64},
+        {"double", BME280_COMPENSATION_DOUBLE},
+    };
+    struct reference_t ref;
+    double err[3];
+
+    reference(&bme280, &a, &ref);
+    printf("\n%-12s %10s %10s %10s %10s\n", "backend", "ns/frame", "T DegC", "P Pa", "H %RH");
+    for (size_t k = 0; k < sizeof(backends) / sizeof(backends[0]); k++) {
+        if (bme280_set_compensation(&bme280, backends[k].compensation) != SUCCESS) {
+            printf("%-12s not built in\n", backends[k].name);
+            continue;
+        }
+        t0 = now_sec();
+        for (int r = 0; r < rounds; r++)
+            backend(&bme280, &a);
+        t_scalar = (now_sec() - t0) / rounds;
+        max_error(&a, &ref, err);
+        printf("%-12s %10.2f %10.4f %10.4f %10.4f\n", backends[k].name, t_scalar * 1e9 / count, err[0], err[1], err[2]);
+    }
+    batch(&bme280, &b);
+    max_error(&b, &ref, err);
+    printf("%-12s %10.2f %10.4f %10.4f %10.4f\n", "batch int32", t_batch * 1e9 / count, err[0], err[1], err[2]);
+
+    altitude(count, rounds);
+    return bad ? 1 : 0;
+}
@@ -0,0 +1,169 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include "bme280-calib.h"
+#include "dmem.h"
+#include "dlog.h"
+
+enum calib_type_t {
+    CALIB_U8,
+    CALIB_S8,
+    CALIB_U16,
+    CALIB_S16,
+};
+
+struct calib_field_t {
+    const char * name;
+    size_t offset;
+    enum calib_type_t type;
+};
+
+#define CALIB_FIELD(field, kind) \
+    {name: #field, offset: offsetof(struct bme280_calibration_param_t, field), type: kind}
+
+static const struct calib_field_t calib_fields[] = {
+    CALIB_FIELD(dig_T1, CALIB_U16),
+    CALIB_FIELD(dig_T2, CALIB_S16),
+    CALIB_FIELD(dig_T3, CALIB_S16),
+    CALIB_FIELD(dig_P1, CALIB_U16),
+    CALIB_FIELD(dig_P2, CALIB_S16),
+    CALIB_FIELD(dig_P3, CALIB_S16),
+    CALIB_FIELD(dig_P4, CALIB_S16),
+    CALIB_FIELD(dig_P5, CALIB_S16),
+    CALIB_FIELD(dig_P6, CALIB_S16),
+    CALIB_FIELD(dig_P7, CALIB_S16),
+    CALIB_FIELD(dig_P8, CALIB_S16),
+    CALIB_FIELD(dig_P9, CALIB_S16),
+    CALIB_FIELD(dig_H1, CALIB_U8),
+    CALIB_FIELD(dig_H2, CALIB_S16),
+    CALIB_FIELD(dig_H3, CALIB_U8),
+    CALIB_FIELD(dig_H4, CALIB_S16),
+    CALIB_FIELD(dig_H5, CALIB_S16),
+    CALIB_FIELD(dig_H6, CALIB_S8),
+};
+
+#define CALIB_FIELDS (sizeof(calib_fields) / sizeof(calib_fields[0]))
+
+static long calib_get(const struct bme280_calibration_param_t * cal, const struct calib_field_t * f) {
+    const char * p = (const char *)cal + f->offset;
+
+    switch (f->type) {
+    case CALIB_U8:
+        return *(const u8 *)p;
+    case CALIB_S8:
+        return *(const s8 *)p;
+    case CALIB_U16:
+        return *(const u16 *)p;
+    default:
+        return *(const s16 *)p;
+    }
+}
+
+static void calib_set(struct bme280_calibration_param_t * cal, const struct calib_field_t * f, long val) {
+    char * p = (char *)cal + f->offset;
+
+    switch (f->type) {
+    case CALIB_U8:
+        *(u8 *)p = val;
+        break;
+    case CALIB_S8:
+        *(s8 *)p = val;
+        break;
+    case CALIB_U16:
+        *(u16 *)p = val;
+        break;
+    default:
+        *(s16 *)p = val;
+        break;
+    }
+}
+
+char * bme280_calib_path(const char * dir, const char * bus, u8 dev_addr) {
+    char * path = NULL;
+    char * p;
+
+    if (asprintf(&path, "%s/bme280-%s-%02x.cal", dir, bus, dev_addr) < 0)
+        return NULL;
+    /* the bus name is a device path, flatten it into the file name */
+    for (p = path + strlen(dir) + 1; *p; p++) {
+        if (*p == '/')
+            *p = '_';
+    }
+    return path;
+}
+
+int bme280_calib_load(const char * path, struct bme280_calib_file_t * calib) {
+    FILE * f;
+    char line[256];
+    char key[32];
+    char value[sizeof(calib->bus)];
+    unsigned int seen = 0;
+    size_t i;
+
+    if ((f = fopen(path, "r")) == NULL) {
+        daemon_log(LOG_DEBUG, "%s %s (%d) %s", __FUNCTION__, path, errno, strerror(errno));
+        return -1;
+    }
+    memset(calib, 0, sizeof(*calib));
+    while (fgets(line, sizeof(line), f)) {
+        if ((line[0] == '#') || (sscanf(line, "%31s %127s", key, value) != 2))
+            continue;
+        if (strcmp(key, "chip_id") == 0) {
+            calib->chip_id = strtoul(value, NULL, 0);
+        } else if (strcmp(key, "addr") == 0) {
+            calib->dev_addr = strtoul(value, NULL, 0);
+        } else if (strcmp(key, "bus") == 0) {
+            strncpy(calib->bus, value, sizeof(calib->bus) - 1);
+        } else {
+            for (i = 0; i < CALIB_FIELDS; i++) {
+                if (strcmp(key, calib_fields[i].name) == 0) {
+                    calib_set(&calib->cal_param, &calib_fields[i], strtol(value, NULL, 0));
+                    seen |= 1 << i;
+                    break;
+                }
+            }
+        }
+    }
+    fclose(f);
+
+    if ((seen != (1u << CALIB_FIELDS) - 1) || (!calib->chip_id)) {
+        daemon_log(LOG_WARNING, "%s %s is incomplete", __FUNCTION__, path);
+        return -1;
+    }
+    return 0;
+}
+
+/* written to a temporary file and renamed, a reader never sees half of it */
+int bme280_calib_save(const char * path, const struct bme280_calib_file_t * calib) {
+    char * tmp = NULL;
+    FILE * f;
+    size_t i;
+    int ret = 0;
+
+    if (asprintf(&tmp, "%s.tmp", path) < 0)
+        return -1;
+    if ((f = fopen(tmp, "w")) == NULL) {
+        daemon_log(LOG_WARNING, "%s %s (%d) %s", __FUNCTION__, tmp, errno, strerror(errno));
+        free(tmp);
+        return -1;
+    }
+    fprintf(f, "# bme280 trimming parameters\n");
+    fprintf(f, "chip_id 0x%02x\n", calib->chip_id);
+    fprintf(f, "bus %s\n", calib->bus);
+    fprintf(f, "addr 0x%02x\n", calib->dev_addr);
+    for (i = 0; i < CALIB_FIELDS; i++) {
+        fprintf(f, "%s %ld\n", calib_fields[i].name, calib_get(&calib->cal_param, &calib_fields[i]));
+    }
+    if ((fclose(f) != 0) || (rename(tmp, path) < 0)) {
+        daemon_log(LOG_WARNING, "%s %s (%d) %s", __FUNCTION__, path, errno, strerror(errno));
+        unlink(tmp);
+        ret = -1;
+    }
+    free(tmp);
+    return ret;
+}
@@ -0,0 +1,21 @@
+#ifndef BME280_CALIB_H_INCLUDED
+#define BME280_CALIB_H_INCLUDED
+#include "bme280.h"
+
+/* Decoded BME280 trimming parameters saved on disk, one text file per
+ * bus and address. The file records the chip id, bus and address it was
+ * read from, and is only trusted after a cheap check against the chip,
+ * see bme280_init_cached().
+ */
+struct bme280_calib_file_t {
+    u8 chip_id;
+    u8 dev_addr;
+    char bus[128];
+    struct bme280_calibration_param_t cal_param;
+};
+
+char * bme280_calib_path(const char * dir, const char * bus, u8 dev_addr);
+int bme280_calib_load(const char * path, struct bme280_calib_file_t * calib);
+int bme280_calib_save(const char * path, const struct bme280_calib_file_t * calib);
+
+#endif // BME280_CALIB_H_INCLUDED
@@ -1,76 +1,135 @@
 #define _GNU_SOURCE
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <math.h>
-#include <unistd.h>
-#include <wiringPiI2C.h>
 #include "bme280-i2c.h"
+#include "bme280-calib.h"
 #include "dlog.h"
 
-s32 bme280_begin(const char *device) {
-    s32 com_rslt = 0;
+/* Trimming parameters come from calib_dir when they are there and
+   still match the chip, else they are read and saved for next time */
+static s32 bme280_init_calib(struct bme280_t *bme280, const char *calib_dir) {
+    struct bme280_calib_file_t calib = {};
+    char *path = calib_dir ? bme280_calib_path(calib_dir, bme280->bus->name, bme280->dev_addr) : NULL;
+    u8 cached = 0;
+    s32 com_rslt;
 
-    bme280Fd = wiringPiI2CSetupInterface(device, BME280_I2C_ADDRESS1);
-    if (bme280Fd < 0) {
-        daemon_log(LOG_ERR,"ERROR: bme280 open failed");
-        return -1;
+    if ((path) && (bme280_calib_load(path, &calib) == 0) &&
+            (strcmp(calib.bus, bme280->bus->name) == 0) && (calib.dev_addr == bme280->dev_addr)) {
+        com_rslt = bme280_init_cached(bme280, calib.chip_id, &calib.cal_param, &cached);
+    } else {
+        com_rslt = bme280_init(bme280);
     }
 
-    I2C_routine();
-
-    if (bme280_init(&bme280) < 0) {
-        return -1;
+    if ((path) && (com_rslt == 0)) {
+        if (cached) {
+            daemon_log(LOG_INFO, "bme280 calibration from %s", path);
+        } else {
+            calib.chip_id = bme280->chip_id;
+            calib.dev_addr = bme280->dev_addr;
+            snprintf(calib.bus, sizeof(calib.bus), "%s", bme280->bus->name);
+            calib.cal_param = bme280->cal_param;
+            calib.cal_param.t_fine = 0;
+            if (bme280_calib_save(path, &calib) == 0)
+                daemon_log(LOG_INFO, "bme280 calibration saved to %s", path);
+        }
     }
+    free(path);
+    return com_rslt;
+}
 
-    com_rslt += bme280_set_power_mode(BME280_NORMAL_MODE);
-    com_rslt += bme280_set_oversamp_humidity(BME280_OVERSAMP_2X);
-    com_rslt += bme280_set_oversamp_pressure(BME280_OVERSAMP_2X);
-    com_rslt += bme280_set_oversamp_temperature(BME280_OVERSAMP_2X);
-    usleep(100000);
+const struct bme280_profile_t bme280_profiles[] = {
+    /* what bme280_begin always used */
+    {"default", BME280_OVERSAMP_2X, BME280_OVERSAMP_2X, BME280_OVERSAMP_2X, BME280_FILTER_COEFF_OFF, BME280_STANDBY_TIME_1_MS},
+    /* shortest conversion, every sample stands alone */
+    {"low-latency", BME280_OVERSAMP_1X, BME280_OVERSAMP_1X, BME280_OVERSAMP_1X, BME280_FILTER_COEFF_OFF, BME280_STANDBY_TIME_1_MS},
+    /* longest conversion and some filtering, for slow sampling */
+    {"low-noise", BME280_OVERSAMP_2X, BME280_OVERSAMP_16X, BME280_OVERSAMP_16X, BME280_FILTER_COEFF_4, BME280_STANDBY_TIME_63_MS},
+    /* datasheet indoor navigation, fast and heavily filtered pressure */
+    {"indoor", BME280_OVERSAMP_2X, BME280_OVERSAMP_16X, BME280_OVERSAMP_1X, BME280_FILTER_COEFF_16, BME280_STANDBY_TIME_1_MS},
+    /* datasheet weather monitoring, meant for forced mode once a minute */
+    {"weather", BME280_OVERSAMP_1X, BME280_OVERSAMP_1X, BME280_OVERSAMP_1X, BME280_FILTER_COEFF_OFF, BME280_STANDBY_TIME_1000_MS},
+    {NULL},
+};
 
-    return com_rslt;
+/* t_standby by the config register code, usec, 0 is 0.5 ms on the BME280 */
+static const u32 bme280_standby_usec[8] = {500, 62500, 125000, 250000, 500000, 1000000, 10000, 20000};
+
+const struct bme280_profile_t *bme280_profile_find(const char *name) {
+    for (const struct bme280_profile_t *profile = bme280_profiles; profile->name; profile++) {
+        if (strcmp(profile->name, name) == 0)
+            return profile;
+    }
+    return NULL;
 }
 
-float bme280_readAltitude(int pressure, float seaLevel) {
-    float atmospheric = (float)pressure / 100.0;
-    return 44330.0 * (1.0 - pow(atmospheric / seaLevel, 0.1903));
+u32 bme280_profile_cycle_usec(const struct bme280_profile_t *profile, u8 v_power_mode_u8) {
+    struct bme280_t bme280 = {
+        oversamp_temperature: profile->oversamp_temperature,
+        oversamp_pressure: profile->oversamp_pressure,
+        oversamp_humidity: profile->oversamp_humidity,
+    };
+    u8 v_waittime_u8 = BME280_INIT_VALUE;
+
+    bme280_compute_wait_time(&bme280, &v_waittime_u8);
+    return v_waittime_u8 * 1000 +
+           ((v_power_mode_u8 == BME280_NORMAL_MODE) ? bme280_standby_usec[profile->standby & 0x07] : 0);
 }
 
-s8 BME280_I2C_bus_write(u8 dev_addr, u8 reg_addr, u8 *reg_data, u8 cnt) {
-    s32 iError = BME280_INIT_VALUE;
-    u8 stringpos = BME280_INIT_VALUE;
-    unsigned char wbuf[2];
-    for (stringpos = BME280_INIT_VALUE; stringpos < cnt; stringpos++) {
-        wbuf[1] = *(reg_data + stringpos);
-        wbuf[0] = reg_addr + stringpos;
-        wiringPiI2CWriteReg16(bme280Fd, wbuf[0], wbuf[1]);
+/* BME280_NORMAL_MODE keeps the chip converting on its own,
+   BME280_FORCED_MODE leaves it asleep between samples */
+s32 bme280_apply_profile(struct bme280_t *bme280, const struct bme280_profile_t *profile, u8 v_power_mode_u8) {
+    s32 com_rslt = 0;
+    u8 v_ctrl_hum_u8 = BME280_INIT_VALUE;
+    u8 v_ctrl_meas_u8 = BME280_INIT_VALUE;
+    u8 v_config_u8 = BME280_INIT_VALUE;
+
+    /* the config register is only sure to be taken in sleep mode */
+    if (BME280_GET_BITSLICE(bme280->ctrl_meas_reg, BME280_CTRL_MEAS_REG_POWER_MODE) == BME280_NORMAL_MODE) {
+        if (bme280_set_power_mode(bme280, BME280_SLEEP_MODE) != SUCCESS)
+            return -1;
     }
-    return (s8)iError;
-}
 
-s8 BME280_I2C_bus_read(u8 dev_addr, u8 reg_addr, u8 *reg_data, u8 cnt) {
-    s32 iError = BME280_INIT_VALUE;
-    u8 stringpos = BME280_INIT_VALUE;
-    unsigned char rbuf[2];
-    //int i;
-    for (stringpos = BME280_INIT_VALUE; stringpos < cnt; stringpos++) {
-        rbuf[0] = reg_addr + stringpos;
-        rbuf[0] = wiringPiI2CReadReg8(bme280Fd, rbuf[0]);
-
-        if (rbuf[0] < 0) iError = -1;
-        else *(reg_data + stringpos) = rbuf[0];
+    v_ctrl_hum_u8 = BME280_SET_BITSLICE(v_ctrl_hum_u8,
+                                        BME280_CTRL_HUMIDITY_REG_OVERSAMP_HUMIDITY, profile->oversamp_humidity);
+    v_ctrl_meas_u8 = BME280_SET_BITSLICE(v_ctrl_meas_u8,
+                                         BME280_CTRL_MEAS_REG_OVERSAMP_PRESSURE, profile->oversamp_pressure);
+    v_ctrl_meas_u8 = BME280_SET_BITSLICE(v_ctrl_meas_u8,
+                                         BME280_CTRL_MEAS_REG_OVERSAMP_TEMPERATURE, profile->oversamp_temperature);
+    v_ctrl_meas_u8 = BME280_SET_BITSLICE(v_ctrl_meas_u8,
+                                         BME280_CTRL_MEAS_REG_POWER_MODE,
+                                         (v_power_mode_u8 == BME280_NORMAL_MODE) ? BME280_FORCED_MODE : BME280_SLEEP_MODE);
+    v_config_u8 = BME280_SET_BITSLICE(v_config_u8,
+                                      BME280_CONFIG_REG_FILTER, profile->filter);
+    v_config_u8 = BME280_SET_BITSLICE(v_config_u8,
+                                      BME280_CONFIG_REG_TSB, profile->standby);
+
+    com_rslt += bme280_apply_settings(bme280, v_ctrl_hum_u8, v_ctrl_meas_u8, v_config_u8);
+    if (v_power_mode_u8 == BME280_NORMAL_MODE) {
+        /* one forced conversion fills the data registers as soon
+           as the chip reports it done, then it runs on its own */
+        com_rslt += bme280_wait_for_conversion(bme280);
+        com_rslt += bme280_set_power_mode(bme280, BME280_NORMAL_MODE);
     }
-    return (s8)iError;
-}
 
-void BME280_delay_msek(u16 msek) {
-    usleep(msek * 1000);
+    return com_rslt;
 }
 
-s8 I2C_routine(void) {
-    bme280.bus_write = BME280_I2C_bus_write;
-    bme280.bus_read = BME280_I2C_bus_read;
-    bme280.dev_addr = BME280_I2C_ADDRESS1;
-    bme280.delay_msec = BME280_delay_msek;
+s32 bme280_begin(struct bme280_t *bme280, struct sensor_bus_t *bus, u8 dev_addr,
+                 u8 v_power_mode_u8, u8 v_forced_wait_u8, const struct bme280_profile_t *profile,
+                 const char *calib_dir) {
+    bme280->bus = bus;
+    bme280->dev_addr = dev_addr;
+    bme280->forced_wait = v_forced_wait_u8;
 
-    return BME280_INIT_VALUE;
+    if (bme280_init_calib(bme280, calib_dir) < 0) {
+        return -1;
+    }
+    return bme280_apply_profile(bme280, profile, v_power_mode_u8);
+}
+
+float bme280_readAltitude(int pressure, float seaLevel) {
+    float atmospheric = (float)pressure / 100.0;
+    return 44330.0 * (1.0 - pow(atmospheric / seaLevel, 0.1903));
 }
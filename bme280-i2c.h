@@ -1,15 +1,29 @@
 #include "bme280.h"
 
-int bme280Fd;
+/* Oversampling, IIR filter and standby settings by name, after the
+   recommended modes of operation in the datasheet, section 3.5 */
+struct bme280_profile_t {
+    const char *name;
+    u8 oversamp_temperature;
+    u8 oversamp_pressure;
+    u8 oversamp_humidity;
+    u8 filter;
+    u8 standby;             /* normal mode only */
+};
 
-struct bme280_t bme280;
+#define BME280_PROFILE_DEFAULT (&bme280_profiles[0])
 
-s32 bme280_begin(const char *device);
-float bme280_readAltitude(int pressure, float seaLevel);
-
-s8 I2C_routine(void);
+/* terminated by a NULL name */
+extern const struct bme280_profile_t bme280_profiles[];
+const struct bme280_profile_t *bme280_profile_find(const char *name);
+/* time from one conversion to the next data in v_power_mode_u8, usec,
+   the longest conversion in forced mode and the conversion plus standby
+   in normal mode */
+u32 bme280_profile_cycle_usec(const struct bme280_profile_t *profile, u8 v_power_mode_u8);
 
-s8 BME280_I2C_bus_write(u8 dev_addr, u8 reg_addr, u8 *reg_data, u8 cnt);
-s8 BME280_I2C_bus_read(u8 dev_addr, u8 reg_addr, u8 *reg_data, u8 cnt);
-
-void BME280_delay_msek(u16 msek);
+s32 bme280_begin(struct bme280_t *bme280, struct sensor_bus_t *bus, u8 dev_addr,
+                 u8 v_power_mode_u8, u8 v_forced_wait_u8, const struct bme280_profile_t *profile,
+                 const char *calib_dir);
+/* settings of profile on a running chip, in the same power mode */
+s32 bme280_apply_profile(struct bme280_t *bme280, const struct bme280_profile_t *profile, u8 v_power_mode_u8);
+float bme280_readAltitude(int pressure, float seaLevel);
@@ -52,7 +52,31 @@
 **************************************************************************/
 #include <unistd.h>
 #include "bme280.h"
-static struct bme280_t *p_bme280; /**< pointer to BME280 */
+
+/* a forced mode conversion ends in sleep mode, so do the stored copies */
+static u8 bme280_settled_ctrl_meas(u8 v_ctrl_meas_u8) {
+    if (BME280_GET_BITSLICE(v_ctrl_meas_u8,
+                            BME280_CTRL_MEAS_REG_POWER_MODE) != BME280_NORMAL_MODE)
+        return BME280_SET_BITSLICE(v_ctrl_meas_u8,
+                                   BME280_CTRL_MEAS_REG_POWER_MODE, BME280_SLEEP_MODE);
+    return v_ctrl_meas_u8;
+}
+
+static void bme280_store_settings(struct bme280_t *p_bme280, u8 v_ctrl_hum_u8, u8 v_ctrl_meas_u8,
+                                  u8 v_config_u8) {
+    p_bme280->ctrl_hum_reg = v_ctrl_hum_u8;
+    p_bme280->ctrl_meas_reg = v_ctrl_meas_u8;
+    p_bme280->config_reg = v_config_u8;
+    p_bme280->oversamp_humidity = BME280_GET_BITSLICE(
+                                      p_bme280->ctrl_hum_reg,
+                                      BME280_CTRL_HUMIDITY_REG_OVERSAMP_HUMIDITY);
+    p_bme280->oversamp_temperature = BME280_GET_BITSLICE(
+                                         p_bme280->ctrl_meas_reg,
+                                         BME280_CTRL_MEAS_REG_OVERSAMP_TEMPERATURE);
+    p_bme280->oversamp_pressure = BME280_GET_BITSLICE(
+                                      p_bme280->ctrl_meas_reg,
+                                      BME280_CTRL_MEAS_REG_OVERSAMP_PRESSURE);
+}
 
 /*!
  *	@brief This function is used for initialize
@@ -60,7 +84,7 @@ static struct bme280_t *p_bme280; /**< pointer to BME280 */
  *  and assign the chip id and I2C address of the BME280 sensor
  *	chip id is read in the register 0xD0 bit from 0 to 7
  *
- *	 @param bme280 structure pointer.
+ *	 @param p_bme280 structure pointer.
  *
  *	@note While changing the parameter of the bme280_t
  *	@note consider the following point:
@@ -79,14 +103,47 @@ static struct bme280_t *p_bme280; /**< pointer to BME280 */
  *
  *
 */
-BME280_RETURN_FUNCTION_TYPE bme280_init(struct bme280_t *bme280) {
+BME280_RETURN_FUNCTION_TYPE bme280_init(struct bme280_t *p_bme280) {
+    u8 v_cached_u8 = BME280_INIT_VALUE;
+
+    return bme280_init_cached(p_bme280, BME280_INIT_VALUE, BME280_NULL,
+                              &v_cached_u8);
+}
+/*!
+ *	@brief This function is used for initialize the sensor
+ *	with trimming parameters saved earlier
+ *
+ *	The saved parameters are used when the chip id matches
+ *	and dig_T1 to dig_T3, read in one transaction, are the
+ *	same as in the chip, else the full set is read.
+ *
+ *	@param p_bme280 structure pointer.
+ *	@param v_chip_id_u8 : chip id the parameters were saved for
+ *	@param v_cal : saved parameters, BME280_NULL for none
+ *	@param v_cached_u8 : 1 when the saved parameters were used
+ *
+ *
+ *	@return results of bus communication function
+ *	@retval 0 -> Success
+ *	@retval -1 -> Error
+ *
+ *
+*/
+BME280_RETURN_FUNCTION_TYPE bme280_init_cached(struct bme280_t *p_bme280,
+        u8 v_chip_id_u8, const struct bme280_calibration_param_t *v_cal,
+        u8 *v_cached_u8) {
     /* used to return the communication result*/
     BME280_RETURN_FUNCTION_TYPE com_rslt = ERROR;
     u8 v_data_u8 = BME280_INIT_VALUE;
+    u8 a_data_u8[BME280_TEMPERATURE_CALIB_DATA_LENGTH] = {
+        BME280_INIT_VALUE, BME280_INIT_VALUE, BME280_INIT_VALUE,
+        BME280_INIT_VALUE, BME280_INIT_VALUE, BME280_INIT_VALUE
+    };
 
-    p_bme280 = bme280;
-    /* assign BME280 ptr */
-    com_rslt = p_bme280->BME280_BUS_READ_FUNC(p_bme280->dev_addr,
+    *v_cached_u8 = BME280_INIT_VALUE;
+    if (bme280_set_compensation(p_bme280, BME280_COMPENSATION_DEFAULT) != SUCCESS)
+        p_bme280->compensation = BME280_COMPENSATION_INT32;
+    com_rslt = BME280_BUS_READ_FUNC(p_bme280->bus, p_bme280->dev_addr,
                BME280_CHIP_ID_REG, &v_data_u8,
                BME280_GEN_READ_WRITE_DATA_LENGTH);
     /* read Chip Id */
@@ -94,8 +151,36 @@ BME280_RETURN_FUNCTION_TYPE bme280_init(struct bme280_t *bme280) {
     if (p_bme280->chip_id != 0x60) {
         return -1;
     }
+    /* the trimming parameters are valid once the
+    NVM copy is over*/
+    com_rslt += bme280_poll_status(p_bme280, BME280_STAT_REG_IM_UPDATE__MSK,
+                                   BME280_NVM_COPY_TIMEOUT_US);
+
+    if ((v_cal != BME280_NULL) && (v_chip_id_u8 == p_bme280->chip_id)) {
+        com_rslt += BME280_BUS_READ_FUNC(p_bme280->bus,
+                                         p_bme280->dev_addr,
+                                         BME280_TEMPERATURE_CALIB_DIG_T1_LSB_REG,
+                                         a_data_u8,
+                                         BME280_TEMPERATURE_CALIB_DATA_LENGTH);
+        if ((com_rslt == SUCCESS) &&
+                (v_cal->dig_T1 == (u16)((a_data_u8[BME280_TEMPERATURE_CALIB_DIG_T1_MSB]
+                                         << BME280_SHIFT_BIT_POSITION_BY_08_BITS) |
+                                        a_data_u8[BME280_TEMPERATURE_CALIB_DIG_T1_LSB])) &&
+                (v_cal->dig_T2 == (s16)((a_data_u8[BME280_TEMPERATURE_CALIB_DIG_T2_MSB]
+                                         << BME280_SHIFT_BIT_POSITION_BY_08_BITS) |
+                                        a_data_u8[BME280_TEMPERATURE_CALIB_DIG_T2_LSB])) &&
+                (v_cal->dig_T3 == (s16)((a_data_u8[BME280_TEMPERATURE_CALIB_DIG_T3_MSB]
+                                         << BME280_SHIFT_BIT_POSITION_BY_08_BITS) |
+                                        a_data_u8[BME280_TEMPERATURE_CALIB_DIG_T3_LSB]))) {
+            p_bme280->cal_param = *v_cal;
+            p_bme280->cal_param.t_fine = BME280_INIT_VALUE;
+            bme280_compute_coefficients(p_bme280);
+            *v_cached_u8 = 1;
+            return com_rslt;
+        }
+    }
 
-    com_rslt += bme280_get_calib_param();
+    com_rslt += bme280_get_calib_param(p_bme280);
     /* readout bme280 calibparam structure */
     return com_rslt;
 }
@@ -117,6 +202,7 @@ BME280_RETURN_FUNCTION_TYPE bme280_init(struct bme280_t *bme280) {
  *
 */
 BME280_RETURN_FUNCTION_TYPE bme280_read_uncomp_temperature(
+    struct bme280_t *p_bme280,
     s32 *v_uncomp_temperature_s32) {
     /* used to return the communication result*/
     BME280_RETURN_FUNCTION_TYPE com_rslt = ERROR;
@@ -132,7 +218,7 @@ BME280_RETURN_FUNCTION_TYPE bme280_read_uncomp_temperature(
     if (p_bme280 == BME280_NULL) {
         return E_BME280_NULL_PTR;
     } else {
-        com_rslt = p_bme280->BME280_BUS_READ_FUNC(
+        com_rslt = BME280_BUS_READ_FUNC(p_bme280->bus,
                        p_bme280->dev_addr,
                        BME280_TEMPERATURE_MSB_REG,
                        a_data_u8r,
@@ -147,6 +233,111 @@ BME280_RETURN_FUNCTION_TYPE bme280_read_uncomp_temperature(
     }
     return com_rslt;
 }
+/*!
+ *	@brief This API derives the compensation terms of
+ *	p_bme280->coef from p_bme280->cal_param, it has to be
+ *	called whenever cal_param changes. bme280_get_calib_param
+ *	and bme280_init_cached call it
+ *
+ *	@note The integer compensation functions give the same
+ *	results as the datasheet formulas, only the work that depends
+ *	on the calibration or on t_fine alone is not redone per sample
+ *
+ *
+*/
+void bme280_compute_coefficients(struct bme280_t *p_bme280) {
+    struct bme280_coefficients_t *coef = &p_bme280->coef;
+
+    coef->t1 = (s32)p_bme280->cal_param.dig_T1;
+    coef->t1_x2 = ((s32)p_bme280->cal_param.dig_T1)
+                  << BME280_SHIFT_BIT_POSITION_BY_01_BIT;
+    coef->p4_16 = ((s32)p_bme280->cal_param.dig_P4)
+                  << BME280_SHIFT_BIT_POSITION_BY_16_BITS;
+    coef->h4_20 = ((s32)p_bme280->cal_param.dig_H4)
+                  << BME280_SHIFT_BIT_POSITION_BY_20_BITS;
+    coef->p_valid = BME280_INIT_VALUE;
+    coef->h_valid = BME280_INIT_VALUE;
+#if defined(BME280_ENABLE_INT64) && defined(BME280_64BITSUPPORT_PRESENT)
+    coef->p64_valid = BME280_INIT_VALUE;
+#endif
+}
+/*!
+ *	@brief This function brings the int32 pressure stage of
+ *	p_bme280->coef up to date with p_bme280->cal_param.t_fine,
+ *	the datasheet terms that do not depend on the uncompensated
+ *	pressure
+ *
+ *	@note Like t_fine the stage is kept in the device handle,
+ *	a handle is used by one thread at a time
+ *
+ *
+*/
+static void bme280_pressure_stage(struct bme280_t *p_bme280) {
+    struct bme280_coefficients_t *coef = &p_bme280->coef;
+    s32 v_t_fine_s32 = p_bme280->cal_param.t_fine;
+    s32 v_x1_u32 = BME280_INIT_VALUE;
+    s32 v_x2_u32 = BME280_INIT_VALUE;
+
+    if (coef->p_valid && (coef->p_t_fine == v_t_fine_s32))
+        return;
+
+    /* calculate x1*/
+    v_x1_u32 = (v_t_fine_s32 >> BME280_SHIFT_BIT_POSITION_BY_01_BIT)
+               - (s32)64000;
+    /* calculate x2*/
+    v_x2_u32 = (((v_x1_u32 >> BME280_SHIFT_BIT_POSITION_BY_02_BITS)
+                 * (v_x1_u32 >> BME280_SHIFT_BIT_POSITION_BY_02_BITS)
+                ) >> BME280_SHIFT_BIT_POSITION_BY_11_BITS)
+               * ((s32)p_bme280->cal_param.dig_P6);
+    v_x2_u32 = v_x2_u32 + ((v_x1_u32 *
+                            ((s32)p_bme280->cal_param.dig_P5))
+                           << BME280_SHIFT_BIT_POSITION_BY_01_BIT);
+    v_x2_u32 = (v_x2_u32 >> BME280_SHIFT_BIT_POSITION_BY_02_BITS) +
+               coef->p4_16;
+    /* calculate x1*/
+    v_x1_u32 = (((p_bme280->cal_param.dig_P3 *
+                  (((v_x1_u32 >> BME280_SHIFT_BIT_POSITION_BY_02_BITS) *
+                    (v_x1_u32 >> BME280_SHIFT_BIT_POSITION_BY_02_BITS))
+                   >> BME280_SHIFT_BIT_POSITION_BY_13_BITS))
+                 >> BME280_SHIFT_BIT_POSITION_BY_03_BITS) +
+                ((((s32)p_bme280->cal_param.dig_P2) *
+                  v_x1_u32) >> BME280_SHIFT_BIT_POSITION_BY_01_BIT))
+               >> BME280_SHIFT_BIT_POSITION_BY_18_BITS;
+    coef->p_x1 = ((((32768 + v_x1_u32)) *
+                   ((s32)p_bme280->cal_param.dig_P1))
+                  >> BME280_SHIFT_BIT_POSITION_BY_15_BITS);
+    coef->p_x2 = v_x2_u32 >> BME280_SHIFT_BIT_POSITION_BY_12_BITS;
+
+    coef->p_t_fine = v_t_fine_s32;
+    coef->p_valid = 1;
+}
+/*!
+ *	@brief This function brings the humidity stage of
+ *	p_bme280->coef up to date with p_bme280->cal_param.t_fine
+ *
+ *
+*/
+static void bme280_humidity_stage(struct bme280_t *p_bme280) {
+    struct bme280_coefficients_t *coef = &p_bme280->coef;
+    s32 v_t_fine_s32 = p_bme280->cal_param.t_fine;
+    s32 v_x1_u32 = BME280_INIT_VALUE;
+
+    if (coef->h_valid && (coef->h_t_fine == v_t_fine_s32))
+        return;
+
+    v_x1_u32 = (v_t_fine_s32 - ((s32)76800));
+    coef->h_h5 = ((s32)p_bme280->cal_param.dig_H5) * v_x1_u32;
+    coef->h_scale = (((((((v_x1_u32 *
+                           ((s32)p_bme280->cal_param.dig_H6))
+                          >> BME280_SHIFT_BIT_POSITION_BY_10_BITS) *
+                         (((v_x1_u32 * ((s32)p_bme280->cal_param.dig_H3))
+                           >> BME280_SHIFT_BIT_POSITION_BY_11_BITS) + ((s32)32768)))
+                        >> BME280_SHIFT_BIT_POSITION_BY_10_BITS) + ((s32)2097152)) *
+                      ((s32)p_bme280->cal_param.dig_H2) + 8192) >> 14);
+
+    coef->h_t_fine = v_t_fine_s32;
+    coef->h_valid = 1;
+}
 /*!
  * @brief Reads actual temperature from uncompensated temperature
  * @note Returns the value in 0.01 degree Centigrade
@@ -160,25 +351,23 @@ BME280_RETURN_FUNCTION_TYPE bme280_read_uncomp_temperature(
  *  @return Returns the actual temperature
  *
 */
-s32 bme280_compensate_temperature_int32(s32 v_uncomp_temperature_s32) {
+s32 bme280_compensate_temperature_int32(struct bme280_t *p_bme280, s32 v_uncomp_temperature_s32) {
     s32 v_x1_u32r = BME280_INIT_VALUE;
     s32 v_x2_u32r = BME280_INIT_VALUE;
     s32 temperature = BME280_INIT_VALUE;
 
     /* calculate x1*/
     v_x1_u32r  =
-        ((((v_uncomp_temperature_s32
-            >> BME280_SHIFT_BIT_POSITION_BY_03_BITS) -
-           ((s32)p_bme280->cal_param.dig_T1
-            << BME280_SHIFT_BIT_POSITION_BY_01_BIT))) *
+        (((v_uncomp_temperature_s32
+           >> BME280_SHIFT_BIT_POSITION_BY_03_BITS) -
+          p_bme280->coef.t1_x2) *
          ((s32)p_bme280->cal_param.dig_T2)) >>
         BME280_SHIFT_BIT_POSITION_BY_11_BITS;
     /* calculate x2*/
-    v_x2_u32r  = (((((v_uncomp_temperature_s32
-                      >> BME280_SHIFT_BIT_POSITION_BY_04_BITS) -
-                     ((s32)p_bme280->cal_param.dig_T1))
-                    * ((v_uncomp_temperature_s32 >> BME280_SHIFT_BIT_POSITION_BY_04_BITS) -
-                       ((s32)p_bme280->cal_param.dig_T1)))
+    v_x2_u32r  = ((v_uncomp_temperature_s32
+                   >> BME280_SHIFT_BIT_POSITION_BY_04_BITS) -
+                  p_bme280->coef.t1);
+    v_x2_u32r  = (((v_x2_u32r * v_x2_u32r)
                    >> BME280_SHIFT_BIT_POSITION_BY_12_BITS) *
                   ((s32)p_bme280->cal_param.dig_T3))
                  >> BME280_SHIFT_BIT_POSITION_BY_14_BITS;
@@ -203,10 +392,11 @@ s32 bme280_compensate_temperature_int32(s32 v_uncomp_temperature_s32) {
  *
 */
 s16 bme280_compensate_temperature_int32_sixteen_bit_output(
+    struct bme280_t *p_bme280,
     s32 v_uncomp_temperature_s32) {
     s16 temperature = BME280_INIT_VALUE;
 
-    bme280_compensate_temperature_int32(
+    bme280_compensate_temperature_int32(p_bme280,
         v_uncomp_temperature_s32);
     temperature  = (s16)((((
                                p_bme280->cal_param.t_fine - 122880) * 25) + 128)
@@ -234,6 +424,7 @@ s16 bme280_compensate_temperature_int32_sixteen_bit_output(
  *
 */
 BME280_RETURN_FUNCTION_TYPE bme280_read_uncomp_pressure(
+    struct bme280_t *p_bme280,
     s32 *v_uncomp_pressure_s32) {
     /* used to return the communication result*/
     BME280_RETURN_FUNCTION_TYPE com_rslt = ERROR;
@@ -249,7 +440,7 @@ BME280_RETURN_FUNCTION_TYPE bme280_read_uncomp_pressure(
     if (p_bme280 == BME280_NULL) {
         return E_BME280_NULL_PTR;
     } else {
-        com_rslt = p_bme280->BME280_BUS_READ_FUNC(
+        com_rslt = BME280_BUS_READ_FUNC(p_bme280->bus,
                        p_bme280->dev_addr,
                        BME280_PRESSURE_MSB_REG,
                        a_data_u8, BME280_PRESSURE_DATA_LENGTH);
@@ -278,44 +469,18 @@ BME280_RETURN_FUNCTION_TYPE bme280_read_uncomp_pressure(
  *  @return Return the actual pressure output as u32
  *
 */
-u32 bme280_compensate_pressure_int32(s32 v_uncomp_pressure_s32) {
+u32 bme280_compensate_pressure_int32(struct bme280_t *p_bme280, s32 v_uncomp_pressure_s32) {
     s32 v_x1_u32 = BME280_INIT_VALUE;
     s32 v_x2_u32 = BME280_INIT_VALUE;
     u32 v_pressure_u32 = BME280_INIT_VALUE;
 
-    /* calculate x1*/
-    v_x1_u32 = (((s32)p_bme280->cal_param.t_fine)
-                >> BME280_SHIFT_BIT_POSITION_BY_01_BIT) - (s32)64000;
-    /* calculate x2*/
-    v_x2_u32 = (((v_x1_u32 >> BME280_SHIFT_BIT_POSITION_BY_02_BITS)
-                 * (v_x1_u32 >> BME280_SHIFT_BIT_POSITION_BY_02_BITS)
-                ) >> BME280_SHIFT_BIT_POSITION_BY_11_BITS)
-               * ((s32)p_bme280->cal_param.dig_P6);
-    /* calculate x2*/
-    v_x2_u32 = v_x2_u32 + ((v_x1_u32 *
-                            ((s32)p_bme280->cal_param.dig_P5))
-                           << BME280_SHIFT_BIT_POSITION_BY_01_BIT);
-    /* calculate x2*/
-    v_x2_u32 = (v_x2_u32 >> BME280_SHIFT_BIT_POSITION_BY_02_BITS) +
-               (((s32)p_bme280->cal_param.dig_P4)
-                << BME280_SHIFT_BIT_POSITION_BY_16_BITS);
-    /* calculate x1*/
-    v_x1_u32 = (((p_bme280->cal_param.dig_P3 *
-                  (((v_x1_u32 >> BME280_SHIFT_BIT_POSITION_BY_02_BITS) *
-                    (v_x1_u32 >> BME280_SHIFT_BIT_POSITION_BY_02_BITS))
-                   >> BME280_SHIFT_BIT_POSITION_BY_13_BITS))
-                 >> BME280_SHIFT_BIT_POSITION_BY_03_BITS) +
-                ((((s32)p_bme280->cal_param.dig_P2) *
-                  v_x1_u32) >> BME280_SHIFT_BIT_POSITION_BY_01_BIT))
-               >> BME280_SHIFT_BIT_POSITION_BY_18_BITS;
-    /* calculate x1*/
-    v_x1_u32 = ((((32768 + v_x1_u32)) *
-                 ((s32)p_bme280->cal_param.dig_P1))
-                >> BME280_SHIFT_BIT_POSITION_BY_15_BITS);
+    /* x1 and x2 depend on t_fine only*/
+    bme280_pressure_stage(p_bme280);
+    v_x1_u32 = p_bme280->coef.p_x1;
     /* calculate pressure*/
     v_pressure_u32 =
         (((u32)(((s32)1048576) - v_uncomp_pressure_s32)
-          - (v_x2_u32 >> BME280_SHIFT_BIT_POSITION_BY_12_BITS))) * 3125;
+          - p_bme280->coef.p_x2)) * 3125;
     if (v_pressure_u32
             < 0x80000000)
         /* Avoid exception caused by division by zero */
@@ -368,6 +533,7 @@ u32 bme280_compensate_pressure_int32(s32 v_uncomp_pressure_s32) {
  *
 */
 BME280_RETURN_FUNCTION_TYPE bme280_read_uncomp_humidity(
+    struct bme280_t *p_bme280,
     s32 *v_uncomp_humidity_s32) {
     /* used to return the communication result*/
     BME280_RETURN_FUNCTION_TYPE com_rslt = ERROR;
@@ -382,7 +548,7 @@ BME280_RETURN_FUNCTION_TYPE bme280_read_uncomp_humidity(
     if (p_bme280 == BME280_NULL) {
         return E_BME280_NULL_PTR;
     } else {
-        com_rslt = p_bme280->BME280_BUS_READ_FUNC(
+        com_rslt = BME280_BUS_READ_FUNC(p_bme280->bus,
                        p_bme280->dev_addr,
                        BME280_HUMIDITY_MSB_REG, a_data_u8,
                        BME280_HUMIDITY_DATA_LENGTH);
@@ -407,25 +573,17 @@ BME280_RETURN_FUNCTION_TYPE bme280_read_uncomp_humidity(
  *  @return Return the actual relative humidity output as u32
  *
 */
-u32 bme280_compensate_humidity_int32(s32 v_uncomp_humidity_s32) {
+u32 bme280_compensate_humidity_int32(struct bme280_t *p_bme280, s32 v_uncomp_humidity_s32) {
     s32 v_x1_u32 = BME280_INIT_VALUE;
 
+    /* the dig_H2..H6 factor depends on t_fine only*/
+    bme280_humidity_stage(p_bme280);
     /* calculate x1*/
-    v_x1_u32 = (p_bme280->cal_param.t_fine - ((s32)76800));
-    /* calculate x1*/
-    v_x1_u32 = (((((v_uncomp_humidity_s32
-                    << BME280_SHIFT_BIT_POSITION_BY_14_BITS) -
-                   (((s32)p_bme280->cal_param.dig_H4)
-                    << BME280_SHIFT_BIT_POSITION_BY_20_BITS) -
-                   (((s32)p_bme280->cal_param.dig_H5) * v_x1_u32)) +
-                  ((s32)16384)) >> BME280_SHIFT_BIT_POSITION_BY_15_BITS)
-                * (((((((v_x1_u32 *
-                         ((s32)p_bme280->cal_param.dig_H6))
-                        >> BME280_SHIFT_BIT_POSITION_BY_10_BITS) *
-                       (((v_x1_u32 * ((s32)p_bme280->cal_param.dig_H3))
-                         >> BME280_SHIFT_BIT_POSITION_BY_11_BITS) + ((s32)32768)))
-                      >> BME280_SHIFT_BIT_POSITION_BY_10_BITS) + ((s32)2097152)) *
-                    ((s32)p_bme280->cal_param.dig_H2) + 8192) >> 14));
+    v_x1_u32 = ((((v_uncomp_humidity_s32
+                   << BME280_SHIFT_BIT_POSITION_BY_14_BITS) -
+                  p_bme280->coef.h4_20 - p_bme280->coef.h_h5) +
+                 ((s32)16384)) >> BME280_SHIFT_BIT_POSITION_BY_15_BITS)
+               * p_bme280->coef.h_scale;
     v_x1_u32 = (v_x1_u32 - (((((v_x1_u32
                                 >> BME280_SHIFT_BIT_POSITION_BY_15_BITS) *
                                (v_x1_u32 >> BME280_SHIFT_BIT_POSITION_BY_15_BITS))
@@ -452,11 +610,12 @@ u32 bme280_compensate_humidity_int32(s32 v_uncomp_humidity_s32) {
  *
 */
 u16 bme280_compensate_humidity_int32_sixteen_bit_output(
+    struct bme280_t *p_bme280,
     s32 v_uncomp_humidity_s32) {
     u32 v_x1_u32 = BME280_INIT_VALUE;
     u16 v_x2_u32 = BME280_INIT_VALUE;
 
-    v_x1_u32 =  bme280_compensate_humidity_int32(v_uncomp_humidity_s32);
+    v_x1_u32 =  bme280_compensate_humidity_int32(p_bme280, v_uncomp_humidity_s32);
     v_x2_u32 = (u16)(v_x1_u32 >> BME280_SHIFT_BIT_POSITION_BY_01_BIT);
     return v_x2_u32;
 }
@@ -480,67 +639,102 @@ u16 bme280_compensate_humidity_int32_sixteen_bit_output(
  *
 */
 BME280_RETURN_FUNCTION_TYPE bme280_read_uncomp_pressure_temperature_humidity(
+    struct bme280_t *p_bme280,
     s32 *v_uncomp_pressure_s32,
     s32 *v_uncomp_temperature_s32, s32 *v_uncomp_humidity_s32) {
     /* used to return the communication result*/
     BME280_RETURN_FUNCTION_TYPE com_rslt = ERROR;
-    /* Array holding the MSB and LSb value of
-    a_data_u8[0] - Pressure MSB
-    a_data_u8[1] - Pressure LSB
-    a_data_u8[1] - Pressure LSB
-    a_data_u8[1] - Temperature MSB
-    a_data_u8[1] - Temperature LSB
-    a_data_u8[1] - Temperature LSB
-    a_data_u8[1] - Humidity MSB
-    a_data_u8[1] - Humidity LSB
-    */
     u8 a_data_u8[BME280_DATA_FRAME_SIZE] = {
         BME280_INIT_VALUE, BME280_INIT_VALUE,
         BME280_INIT_VALUE, BME280_INIT_VALUE,
         BME280_INIT_VALUE, BME280_INIT_VALUE,
         BME280_INIT_VALUE, BME280_INIT_VALUE
     };
+
+    com_rslt = bme280_read_data_frame(p_bme280, a_data_u8);
+    bme280_decode_data_frame(a_data_u8, v_uncomp_pressure_s32,
+                             v_uncomp_temperature_s32, v_uncomp_humidity_s32);
+    return com_rslt;
+}
+/*!
+ * @brief This API is used to read the raw data frame, pressure,
+ *	temperature and humidity registers 0xF7 to 0xFE, as they are
+ *
+ *
+ *  @param  v_frame_u8: BME280_DATA_FRAME_SIZE bytes for the frame
+ *
+ *
+ *
+ *	@return results of bus communication function
+ *	@retval 0 -> Success
+ *	@retval -1 -> Error
+ *
+ *
+*/
+BME280_RETURN_FUNCTION_TYPE bme280_read_data_frame(
+    struct bme280_t *p_bme280, u8 *v_frame_u8) {
     /* check the p_bme280 structure pointer as NULL*/
-    if (p_bme280 == BME280_NULL) {
+    if (p_bme280 == BME280_NULL)
         return E_BME280_NULL_PTR;
-    } else {
-        com_rslt = p_bme280->BME280_BUS_READ_FUNC(
-                       p_bme280->dev_addr,
-                       BME280_PRESSURE_MSB_REG,
-                       a_data_u8, BME280_ALL_DATA_FRAME_LENGTH);
-        /*Pressure*/
-        *v_uncomp_pressure_s32 = (s32)((
-                                           ((u32)(a_data_u8[
-                                                   BME280_DATA_FRAME_PRESSURE_MSB_BYTE]))
-                                           << BME280_SHIFT_BIT_POSITION_BY_12_BITS) |
-                                       (((u32)(a_data_u8[
-                                               BME280_DATA_FRAME_PRESSURE_LSB_BYTE]))
-                                        << BME280_SHIFT_BIT_POSITION_BY_04_BITS) |
-                                       ((u32)a_data_u8[
-                                            BME280_DATA_FRAME_PRESSURE_XLSB_BYTE] >>
-                                        BME280_SHIFT_BIT_POSITION_BY_04_BITS));
+    return BME280_BUS_READ_FUNC(p_bme280->bus,
+                                p_bme280->dev_addr,
+                                BME280_PRESSURE_MSB_REG,
+                                v_frame_u8, BME280_ALL_DATA_FRAME_LENGTH);
+}
+/*!
+ * @brief This API is used to take the uncompensated pressure,
+ *	temperature and humidity out of a raw data frame
+ *
+ *	v_frame_u8[0] - Pressure MSB
+ *	v_frame_u8[1] - Pressure LSB
+ *	v_frame_u8[2] - Pressure XLSB
+ *	v_frame_u8[3] - Temperature MSB
+ *	v_frame_u8[4] - Temperature LSB
+ *	v_frame_u8[5] - Temperature XLSB
+ *	v_frame_u8[6] - Humidity MSB
+ *	v_frame_u8[7] - Humidity LSB
+ *
+ *  @param  v_frame_u8: the BME280_DATA_FRAME_SIZE bytes of 0xF7 to 0xFE
+ *  @param  v_uncomp_pressure_s32: The value of uncompensated pressure.
+ *  @param  v_uncomp_temperature_s32: The value of uncompensated temperature
+ *  @param  v_uncomp_humidity_s32: The value of uncompensated humidity.
+ *
+ *
+*/
+void bme280_decode_data_frame(const u8 *v_frame_u8,
+                              s32 *v_uncomp_pressure_s32,
+                              s32 *v_uncomp_temperature_s32, s32 *v_uncomp_humidity_s32) {
+    /*Pressure*/
+    *v_uncomp_pressure_s32 = (s32)((
+                                       ((u32)(v_frame_u8[
+                                               BME280_DATA_FRAME_PRESSURE_MSB_BYTE]))
+                                       << BME280_SHIFT_BIT_POSITION_BY_12_BITS) |
+                                   (((u32)(v_frame_u8[
+                                           BME280_DATA_FRAME_PRESSURE_LSB_BYTE]))
+                                    << BME280_SHIFT_BIT_POSITION_BY_04_BITS) |
+                                   ((u32)v_frame_u8[
+                                        BME280_DATA_FRAME_PRESSURE_XLSB_BYTE] >>
+                                    BME280_SHIFT_BIT_POSITION_BY_04_BITS));
 
-        /* Temperature */
-        *v_uncomp_temperature_s32 = (s32)(((
-                                               (u32) (a_data_u8[
-                                                       BME280_DATA_FRAME_TEMPERATURE_MSB_BYTE]))
-                                           << BME280_SHIFT_BIT_POSITION_BY_12_BITS) |
-                                          (((u32)(a_data_u8[
-                                                  BME280_DATA_FRAME_TEMPERATURE_LSB_BYTE]))
-                                           << BME280_SHIFT_BIT_POSITION_BY_04_BITS)
-                                          | ((u32)a_data_u8[
-                                                  BME280_DATA_FRAME_TEMPERATURE_XLSB_BYTE]
-                                             >> BME280_SHIFT_BIT_POSITION_BY_04_BITS));
+    /* Temperature */
+    *v_uncomp_temperature_s32 = (s32)(((
+                                           (u32) (v_frame_u8[
+                                                   BME280_DATA_FRAME_TEMPERATURE_MSB_BYTE]))
+                                       << BME280_SHIFT_BIT_POSITION_BY_12_BITS) |
+                                      (((u32)(v_frame_u8[
+                                              BME280_DATA_FRAME_TEMPERATURE_LSB_BYTE]))
+                                       << BME280_SHIFT_BIT_POSITION_BY_04_BITS)
+                                      | ((u32)v_frame_u8[
+                                              BME280_DATA_FRAME_TEMPERATURE_XLSB_BYTE]
+                                         >> BME280_SHIFT_BIT_POSITION_BY_04_BITS));
 
-        /*Humidity*/
-        *v_uncomp_humidity_s32 = (s32)((
-                                           ((u32)(a_data_u8[
-                                                   BME280_DATA_FRAME_HUMIDITY_MSB_BYTE]))
-                                           << BME280_SHIFT_BIT_POSITION_BY_08_BITS) |
-                                       ((u32)(a_data_u8[
-                                               BME280_DATA_FRAME_HUMIDITY_LSB_BYTE])));
-    }
-    return com_rslt;
+    /*Humidity*/
+    *v_uncomp_humidity_s32 = (s32)((
+                                       ((u32)(v_frame_u8[
+                                               BME280_DATA_FRAME_HUMIDITY_MSB_BYTE]))
+                                       << BME280_SHIFT_BIT_POSITION_BY_08_BITS) |
+                                   ((u32)(v_frame_u8[
+                                           BME280_DATA_FRAME_HUMIDITY_LSB_BYTE])));
 }
 /*!
  * @brief This API used to read true pressure, temperature and humidity
@@ -560,6 +754,7 @@ BME280_RETURN_FUNCTION_TYPE bme280_read_uncomp_pressure_temperature_humidity(
  *
 */
 BME280_RETURN_FUNCTION_TYPE bme280_read_pressure_temperature_humidity(
+    struct bme280_t *p_bme280,
     u32 *v_pressure_u32, s32 *v_temperature_s32, u32 *v_humidity_u32) {
     /* used to return the communication result*/
     BME280_RETURN_FUNCTION_TYPE com_rslt = ERROR;
@@ -573,19 +768,116 @@ BME280_RETURN_FUNCTION_TYPE bme280_read_pressure_temperature_humidity(
         /* read the uncompensated pressure,
         temperature and humidity*/
         com_rslt =
-            bme280_read_uncomp_pressure_temperature_humidity(
+            bme280_read_uncomp_pressure_temperature_humidity(p_bme280,
                 &v_uncomp_pressure_s32, &v_uncom_temperature_s32,
                 &v_uncom_humidity_s32);
         /* read the true pressure, temperature and humidity*/
+        bme280_compensate_pressure_temperature_humidity(p_bme280,
+            v_uncomp_pressure_s32, v_uncom_temperature_s32,
+            v_uncom_humidity_s32,
+            v_pressure_u32, v_temperature_s32, v_humidity_u32);
+    }
+    return com_rslt;
+}
+/*!
+ * @brief This API is used to compensate one frame of uncompensated
+ *	pressure, temperature and humidity with the backend chosen by
+ *	bme280_set_compensation
+ *
+ *	@note The results are in the units of the int32 backend
+ *	whatever the backend: pressure in Pa, temperature in
+ *	0.01 DegC and humidity in 1/1024 %rH, rounded to nearest
+ *
+ *	@param  v_uncomp_pressure_s32: The value of uncompensated pressure.
+ *	@param  v_uncomp_temperature_s32: The value of uncompensated temperature
+ *	@param  v_uncomp_humidity_s32: The value of uncompensated humidity.
+ *	@param  v_pressure_u32 : The value of compensated pressure.
+ *	@param  v_temperature_s32 : The value of compensated temperature.
+ *	@param  v_humidity_u32 : The value of compensated humidity.
+ *
+ *
+*/
+void bme280_compensate_pressure_temperature_humidity(
+    struct bme280_t *p_bme280,
+    s32 v_uncomp_pressure_s32, s32 v_uncomp_temperature_s32,
+    s32 v_uncomp_humidity_s32,
+    u32 *v_pressure_u32, s32 *v_temperature_s32, u32 *v_humidity_u32) {
+#ifdef BME280_ENABLE_FLOAT
+    double v_x_double = BME280_INIT_VALUE;
+#endif
+    switch (p_bme280->compensation) {
+#if defined(BME280_ENABLE_INT64) && defined(BME280_64BITSUPPORT_PRESENT)
+    case BME280_COMPENSATION_INT64:
+        *v_temperature_s32 =
+            bme280_compensate_temperature_int32(p_bme280,
+                v_uncomp_temperature_s32);
+        /* Q24.8 to Pa */
+        *v_pressure_u32 = (bme280_compensate_pressure_int64(p_bme280,
+                               v_uncomp_pressure_s32) + 128)
+                          >> BME280_SHIFT_BIT_POSITION_BY_08_BITS;
+        *v_humidity_u32 = bme280_compensate_humidity_int32(p_bme280,
+                              v_uncomp_humidity_s32);
+        break;
+#endif
+#ifdef BME280_ENABLE_FLOAT
+    case BME280_COMPENSATION_DOUBLE:
+        /* round to nearest, pressure and humidity are never negative */
+        v_x_double = bme280_compensate_temperature_double(p_bme280,
+                     v_uncomp_temperature_s32) * 100.0;
+        *v_temperature_s32 = (s32)(v_x_double < 0 ?
+                                   v_x_double - 0.5 : v_x_double + 0.5);
+        *v_pressure_u32 = (u32)(bme280_compensate_pressure_double(p_bme280,
+                                v_uncomp_pressure_s32) + 0.5);
+        *v_humidity_u32 = (u32)(bme280_compensate_humidity_double(p_bme280,
+                                v_uncomp_humidity_s32) * 1024.0 + 0.5);
+        break;
+#endif
+    default:
         *v_temperature_s32 =
-            bme280_compensate_temperature_int32(
-                v_uncom_temperature_s32);
-        *v_pressure_u32 = bme280_compensate_pressure_int32(
+            bme280_compensate_temperature_int32(p_bme280,
+                v_uncomp_temperature_s32);
+        *v_pressure_u32 = bme280_compensate_pressure_int32(p_bme280,
                               v_uncomp_pressure_s32);
-        *v_humidity_u32 = bme280_compensate_humidity_int32(
-                              v_uncom_humidity_s32);
+        *v_humidity_u32 = bme280_compensate_humidity_int32(p_bme280,
+                              v_uncomp_humidity_s32);
+        break;
+    }
+}
+/*!
+ * @brief This API is used to choose the compensation backend
+ *
+ *	@param v_compensation_u8 : the backend
+ *  value   |   backend
+ * ---------|----------------------------
+ *  0x00    | BME280_COMPENSATION_INT32
+ *  0x01    | BME280_COMPENSATION_INT64
+ *  0x02    | BME280_COMPENSATION_DOUBLE
+ *
+ *	@return results of the selection
+ *	@retval 0 -> Success
+ *	@retval -1 -> Error, the backend is not built in, see
+ *	BME280_ENABLE_INT64 and BME280_ENABLE_FLOAT
+ *
+ *
+*/
+BME280_RETURN_FUNCTION_TYPE bme280_set_compensation(struct bme280_t *p_bme280,
+        u8 v_compensation_u8) {
+    /* check the p_bme280 structure pointer as NULL*/
+    if (p_bme280 == BME280_NULL)
+        return E_BME280_NULL_PTR;
+    switch (v_compensation_u8) {
+    case BME280_COMPENSATION_INT32:
+#if defined(BME280_ENABLE_INT64) && defined(BME280_64BITSUPPORT_PRESENT)
+    case BME280_COMPENSATION_INT64:
+#endif
+#ifdef BME280_ENABLE_FLOAT
+    case BME280_COMPENSATION_DOUBLE:
+#endif
+        p_bme280->compensation = v_compensation_u8;
+        return SUCCESS;
+    default:
+        return ERROR;
     }
-    return com_rslt;
 }
 /*!
  *	@brief This API is used to
@@ -615,7 +907,7 @@ BME280_RETURN_FUNCTION_TYPE bme280_read_pressure_temperature_humidity(
  *
  *
 */
-BME280_RETURN_FUNCTION_TYPE bme280_get_calib_param(void) {
+BME280_RETURN_FUNCTION_TYPE bme280_get_calib_param(struct bme280_t *p_bme280) {
     /* used to return the communication result*/
     BME280_RETURN_FUNCTION_TYPE com_rslt = ERROR;
     u8 a_data_u8[BME280_CALIB_DATA_SIZE] = {
@@ -633,7 +925,7 @@ BME280_RETURN_FUNCTION_TYPE bme280_get_calib_param(void) {
     if (p_bme280 == BME280_NULL) {
         return E_BME280_NULL_PTR;
     } else {
-        com_rslt = p_bme280->BME280_BUS_READ_FUNC(
+        com_rslt = BME280_BUS_READ_FUNC(p_bme280->bus,
                        p_bme280->dev_addr,
                        BME280_TEMPERATURE_CALIB_DIG_T1_LSB_REG,
                        a_data_u8,
@@ -702,7 +994,7 @@ BME280_RETURN_FUNCTION_TYPE bme280_get_calib_param(void) {
                                            | a_data_u8[BME280_PRESSURE_CALIB_DIG_P9_LSB]);
         p_bme280->cal_param.dig_H1 =
             a_data_u8[BME280_HUMIDITY_CALIB_DIG_H1];
-        com_rslt += p_bme280->BME280_BUS_READ_FUNC(
+        com_rslt += BME280_BUS_READ_FUNC(p_bme280->bus,
                         p_bme280->dev_addr,
                         BME280_HUMIDITY_CALIB_DIG_H2_LSB_REG, a_data_u8,
                         BME280_HUMIDITY_CALIB_DATA_LENGTH);
@@ -727,6 +1019,7 @@ BME280_RETURN_FUNCTION_TYPE bme280_get_calib_param(void) {
                                             BME280_SHIFT_BIT_POSITION_BY_04_BITS));
         p_bme280->cal_param.dig_H6 =
             (s8)a_data_u8[BME280_HUMIDITY_CALIB_DIG_H6];
+        bme280_compute_coefficients(p_bme280);
     }
     return com_rslt;
 }
@@ -756,6 +1049,7 @@ BME280_RETURN_FUNCTION_TYPE bme280_get_calib_param(void) {
  *
 */
 BME280_RETURN_FUNCTION_TYPE bme280_get_oversamp_temperature(
+    struct bme280_t *p_bme280,
     u8 *v_value_u8) {
     /* used to return the communication result*/
     BME280_RETURN_FUNCTION_TYPE com_rslt = ERROR;
@@ -764,7 +1058,7 @@ BME280_RETURN_FUNCTION_TYPE bme280_get_oversamp_temperature(
     if (p_bme280 == BME280_NULL) {
         return E_BME280_NULL_PTR;
     } else {
-        com_rslt = p_bme280->BME280_BUS_READ_FUNC(
+        com_rslt = BME280_BUS_READ_FUNC(p_bme280->bus,
                        p_bme280->dev_addr,
                        BME280_CTRL_MEAS_REG_OVERSAMP_TEMPERATURE__REG,
                        &v_data_u8, BME280_GEN_READ_WRITE_DATA_LENGTH);
@@ -801,13 +1095,11 @@ BME280_RETURN_FUNCTION_TYPE bme280_get_oversamp_temperature(
  *
 */
 BME280_RETURN_FUNCTION_TYPE bme280_set_oversamp_temperature(
+    struct bme280_t *p_bme280,
     u8 v_value_u8) {
     /* used to return the communication result*/
     BME280_RETURN_FUNCTION_TYPE com_rslt = ERROR;
     u8 v_data_u8 = BME280_INIT_VALUE;
-    u8 v_prev_pow_mode_u8 = BME280_INIT_VALUE;
-    u8 v_pre_ctrl_hum_value_u8 = BME280_INIT_VALUE;
-    u8 v_pre_config_value_u8 = BME280_INIT_VALUE;
     /* check the p_bme280 structure pointer as NULL*/
     if (p_bme280 == BME280_NULL) {
         return E_BME280_NULL_PTR;
@@ -816,53 +1108,12 @@ BME280_RETURN_FUNCTION_TYPE bme280_set_oversamp_temperature(
         v_data_u8 =
             BME280_SET_BITSLICE(v_data_u8,
                                 BME280_CTRL_MEAS_REG_OVERSAMP_TEMPERATURE, v_value_u8);
-        com_rslt = bme280_get_power_mode(&v_prev_pow_mode_u8);
-        if (v_prev_pow_mode_u8 != BME280_SLEEP_MODE) {
-            com_rslt += bme280_set_soft_rst();
-            p_bme280->delay_msec(BME280_3MS_DELAY);
-            /* write previous value
-            of configuration register*/
-            v_pre_config_value_u8 = p_bme280->config_reg;
-            com_rslt += bme280_write_register(
-                            BME280_CONFIG_REG,
-                            &v_pre_config_value_u8,
-                            BME280_GEN_READ_WRITE_DATA_LENGTH);
-            /* write previous value
-            of humidity oversampling*/
-            v_pre_ctrl_hum_value_u8 =
-                p_bme280->ctrl_hum_reg;
-            com_rslt += bme280_write_register(
-                            BME280_CTRL_HUMIDITY_REG,
-                            &v_pre_ctrl_hum_value_u8,
-                            BME280_GEN_READ_WRITE_DATA_LENGTH);
-            /* write previous and updated value
-            of configuration register*/
-            com_rslt += bme280_write_register(
-                            BME280_CTRL_MEAS_REG,
-                            &v_data_u8, BME280_GEN_READ_WRITE_DATA_LENGTH);
-        } else {
-            com_rslt = p_bme280->BME280_BUS_WRITE_FUNC(
-                           p_bme280->dev_addr,
-                           BME280_CTRL_MEAS_REG_OVERSAMP_TEMPERATURE__REG,
-                           &v_data_u8, BME280_GEN_READ_WRITE_DATA_LENGTH);
-        }
-        p_bme280->oversamp_temperature = v_value_u8;
-        /* read the control measurement register value*/
-        com_rslt = bme280_read_register(
-                       BME280_CTRL_MEAS_REG,
-                       &v_data_u8, BME280_GEN_READ_WRITE_DATA_LENGTH);
-        p_bme280->ctrl_meas_reg = v_data_u8;
-        /* read the control humidity register value*/
-        com_rslt += bme280_read_register(
-                        BME280_CTRL_HUMIDITY_REG,
-                        &v_data_u8, BME280_GEN_READ_WRITE_DATA_LENGTH);
-        p_bme280->ctrl_hum_reg = v_data_u8;
-        /* read the control
-        configuration register value*/
-        com_rslt += bme280_read_register(
-                        BME280_CONFIG_REG,
-                        &v_data_u8, BME280_GEN_READ_WRITE_DATA_LENGTH);
-        p_bme280->config_reg = v_data_u8;
+        /* write the updated value together with the
+        previous values of the other control registers*/
+        com_rslt = bme280_apply_settings(p_bme280,
+                       p_bme280->ctrl_hum_reg,
+                       v_data_u8,
+                       p_bme280->config_reg);
     }
     return com_rslt;
 }
@@ -892,6 +1143,7 @@ BME280_RETURN_FUNCTION_TYPE bme280_set_oversamp_temperature(
  *
 */
 BME280_RETURN_FUNCTION_TYPE bme280_get_oversamp_pressure(
+    struct bme280_t *p_bme280,
     u8 *v_value_u8) {
     /* used to return the communication result*/
     BME280_RETURN_FUNCTION_TYPE com_rslt = ERROR;
@@ -900,7 +1152,7 @@ BME280_RETURN_FUNCTION_TYPE bme280_get_oversamp_pressure(
     if (p_bme280 == BME280_NULL) {
         return E_BME280_NULL_PTR;
     } else {
-        com_rslt = p_bme280->BME280_BUS_READ_FUNC(
+        com_rslt = BME280_BUS_READ_FUNC(p_bme280->bus,
                        p_bme280->dev_addr,
                        BME280_CTRL_MEAS_REG_OVERSAMP_PRESSURE__REG,
                        &v_data_u8, BME280_GEN_READ_WRITE_DATA_LENGTH);
@@ -938,13 +1190,11 @@ BME280_RETURN_FUNCTION_TYPE bme280_get_oversamp_pressure(
  *
 */
 BME280_RETURN_FUNCTION_TYPE bme280_set_oversamp_pressure(
+    struct bme280_t *p_bme280,
     u8 v_value_u8) {
     /* used to return the communication result*/
     BME280_RETURN_FUNCTION_TYPE com_rslt = ERROR;
     u8 v_data_u8 = BME280_INIT_VALUE;
-    u8 v_prev_pow_mode_u8 = BME280_INIT_VALUE;
-    u8 v_pre_ctrl_hum_value_u8 = BME280_INIT_VALUE;
-    u8 v_pre_config_value_u8 = BME280_INIT_VALUE;
     /* check the p_bme280 structure pointer as NULL*/
     if (p_bme280 == BME280_NULL) {
         return E_BME280_NULL_PTR;
@@ -953,53 +1203,12 @@ BME280_RETURN_FUNCTION_TYPE bme280_set_oversamp_pressure(
         v_data_u8 =
             BME280_SET_BITSLICE(v_data_u8,
                                 BME280_CTRL_MEAS_REG_OVERSAMP_PRESSURE, v_value_u8);
-        com_rslt = bme280_get_power_mode(&v_prev_pow_mode_u8);
-        if (v_prev_pow_mode_u8 != BME280_SLEEP_MODE) {
-            com_rslt += bme280_set_soft_rst();
-            p_bme280->delay_msec(BME280_3MS_DELAY);
-            /* write previous value of
-            configuration register*/
-            v_pre_config_value_u8 = p_bme280->config_reg;
-            com_rslt = bme280_write_register(
-                           BME280_CONFIG_REG,
-                           &v_pre_config_value_u8,
-                           BME280_GEN_READ_WRITE_DATA_LENGTH);
-            /* write previous value of
-            humidity oversampling*/
-            v_pre_ctrl_hum_value_u8 =
-                p_bme280->ctrl_hum_reg;
-            com_rslt += bme280_write_register(
-                            BME280_CTRL_HUMIDITY_REG,
-                            &v_pre_ctrl_hum_value_u8,
-                            BME280_GEN_READ_WRITE_DATA_LENGTH);
-            /* write previous and updated value of
-            control measurement register*/
-            bme280_write_register(
-                BME280_CTRL_MEAS_REG,
-                &v_data_u8, BME280_GEN_READ_WRITE_DATA_LENGTH);
-        } else {
-            com_rslt = p_bme280->BME280_BUS_WRITE_FUNC(
-                           p_bme280->dev_addr,
-                           BME280_CTRL_MEAS_REG_OVERSAMP_PRESSURE__REG,
-                           &v_data_u8, BME280_GEN_READ_WRITE_DATA_LENGTH);
-        }
-        p_bme280->oversamp_pressure = v_value_u8;
-        /* read the control measurement register value*/
-        com_rslt = bme280_read_register(
-                       BME280_CTRL_MEAS_REG,
-                       &v_data_u8, BME280_GEN_READ_WRITE_DATA_LENGTH);
-        p_bme280->ctrl_meas_reg = v_data_u8;
-        /* read the control humidity register value*/
-        com_rslt += bme280_read_register(
-                        BME280_CTRL_HUMIDITY_REG,
-                        &v_data_u8, BME280_GEN_READ_WRITE_DATA_LENGTH);
-        p_bme280->ctrl_hum_reg = v_data_u8;
-        /* read the control
-        configuration register value*/
-        com_rslt += bme280_read_register(
-                        BME280_CONFIG_REG,
-                        &v_data_u8, BME280_GEN_READ_WRITE_DATA_LENGTH);
-        p_bme280->config_reg = v_data_u8;
+        /* write the updated value together with the
+        previous values of the other control registers*/
+        com_rslt = bme280_apply_settings(p_bme280,
+                       p_bme280->ctrl_hum_reg,
+                       v_data_u8,
+                       p_bme280->config_reg);
     }
     return com_rslt;
 }
@@ -1029,6 +1238,7 @@ BME280_RETURN_FUNCTION_TYPE bme280_set_oversamp_pressure(
  *
 */
 BME280_RETURN_FUNCTION_TYPE bme280_get_oversamp_humidity(
+    struct bme280_t *p_bme280,
     u8 *v_value_u8) {
     /* used to return the communication result*/
     BME280_RETURN_FUNCTION_TYPE com_rslt = ERROR;
@@ -1037,7 +1247,7 @@ BME280_RETURN_FUNCTION_TYPE bme280_get_oversamp_humidity(
     if (p_bme280 == BME280_NULL) {
         return E_BME280_NULL_PTR;
     } else {
-        com_rslt = p_bme280->BME280_BUS_READ_FUNC(
+        com_rslt = BME280_BUS_READ_FUNC(p_bme280->bus,
                        p_bme280->dev_addr,
                        BME280_CTRL_HUMIDITY_REG_OVERSAMP_HUMIDITY__REG,
                        &v_data_u8, BME280_GEN_READ_WRITE_DATA_LENGTH);
@@ -1089,74 +1299,25 @@ BME280_RETURN_FUNCTION_TYPE bme280_get_oversamp_humidity(
  *
 */
 BME280_RETURN_FUNCTION_TYPE bme280_set_oversamp_humidity(
+    struct bme280_t *p_bme280,
     u8 v_value_u8) {
     /* used to return the communication result*/
     BME280_RETURN_FUNCTION_TYPE com_rslt = ERROR;
     u8 v_data_u8 = BME280_INIT_VALUE;
-    u8 pre_ctrl_meas_value = BME280_INIT_VALUE;
-    u8 v_pre_config_value_u8 = BME280_INIT_VALUE;
-    u8 v_prev_pow_mode_u8 = BME280_INIT_VALUE;
     /* check the p_bme280 structure pointer as NULL*/
     if (p_bme280 == BME280_NULL) {
         return E_BME280_NULL_PTR;
     } else {
-        /* write humidity oversampling*/
         v_data_u8 = p_bme280->ctrl_hum_reg;
         v_data_u8 =
             BME280_SET_BITSLICE(v_data_u8,
                                 BME280_CTRL_HUMIDITY_REG_OVERSAMP_HUMIDITY, v_value_u8);
-        com_rslt = bme280_get_power_mode(&v_prev_pow_mode_u8);
-        if (v_prev_pow_mode_u8 != BME280_SLEEP_MODE) {
-            com_rslt += bme280_set_soft_rst();
-            p_bme280->delay_msec(BME280_3MS_DELAY);
-            /* write previous value of
-            configuration register*/
-            v_pre_config_value_u8 = p_bme280->config_reg;
-            com_rslt += bme280_write_register(
-                            BME280_CONFIG_REG,
-                            &v_pre_config_value_u8,
-                            BME280_GEN_READ_WRITE_DATA_LENGTH);
-            /* write the value of control humidity*/
-            com_rslt += bme280_write_register(
-                            BME280_CTRL_HUMIDITY_REG,
-                            &v_data_u8, BME280_GEN_READ_WRITE_DATA_LENGTH);
-            /* write previous value of
-            control measurement register*/
-            pre_ctrl_meas_value =
-                p_bme280->ctrl_meas_reg;
-            com_rslt += bme280_write_register(
-                            BME280_CTRL_MEAS_REG,
-                            &pre_ctrl_meas_value,
-                            BME280_GEN_READ_WRITE_DATA_LENGTH);
-        } else {
-            com_rslt +=
-                p_bme280->BME280_BUS_WRITE_FUNC(
-                    p_bme280->dev_addr,
-                    BME280_CTRL_HUMIDITY_REG_OVERSAMP_HUMIDITY__REG,
-                    &v_data_u8, BME280_GEN_READ_WRITE_DATA_LENGTH);
-            /* Control humidity write will effective only
-            after the control measurement register*/
-            pre_ctrl_meas_value =
-                p_bme280->ctrl_meas_reg;
-            com_rslt += bme280_write_register(
-                            BME280_CTRL_MEAS_REG,
-                            &pre_ctrl_meas_value,
-                            BME280_GEN_READ_WRITE_DATA_LENGTH);
-        }
-        p_bme280->oversamp_humidity = v_value_u8;
-        /* read the control measurement register value*/
-        com_rslt += bme280_read_register(BME280_CTRL_MEAS_REG,
-                                         &v_data_u8, BME280_GEN_READ_WRITE_DATA_LENGTH);
-        p_bme280->ctrl_meas_reg = v_data_u8;
-        /* read the control humidity register value*/
-        com_rslt += bme280_read_register(
-                        BME280_CTRL_HUMIDITY_REG,
-                        &v_data_u8, BME280_GEN_READ_WRITE_DATA_LENGTH);
-        p_bme280->ctrl_hum_reg = v_data_u8;
-        /* read the control configuration register value*/
-        com_rslt += bme280_read_register(BME280_CONFIG_REG,
-                                         &v_data_u8, BME280_GEN_READ_WRITE_DATA_LENGTH);
-        p_bme280->config_reg = v_data_u8;
+        /* write the updated value together with the
+        previous values of the other control registers*/
+        com_rslt = bme280_apply_settings(p_bme280,
+                       v_data_u8,
+                       p_bme280->ctrl_meas_reg,
+                       p_bme280->config_reg);
     }
     return com_rslt;
 }
@@ -1179,7 +1340,7 @@ BME280_RETURN_FUNCTION_TYPE bme280_set_oversamp_humidity(
  *
  *
 */
-BME280_RETURN_FUNCTION_TYPE bme280_get_power_mode(u8 *v_power_mode_u8) {
+BME280_RETURN_FUNCTION_TYPE bme280_get_power_mode(struct bme280_t *p_bme280, u8 *v_power_mode_u8) {
     /* used to return the communication result*/
     BME280_RETURN_FUNCTION_TYPE com_rslt = ERROR;
     u8 v_mode_u8r = BME280_INIT_VALUE;
@@ -1187,7 +1348,7 @@ BME280_RETURN_FUNCTION_TYPE bme280_get_power_mode(u8 *v_power_mode_u8) {
     if (p_bme280 == BME280_NULL) {
         return E_BME280_NULL_PTR;
     } else {
-        com_rslt = p_bme280->BME280_BUS_READ_FUNC(
+        com_rslt = BME280_BUS_READ_FUNC(p_bme280->bus,
                        p_bme280->dev_addr,
                        BME280_CTRL_MEAS_REG_POWER_MODE__REG,
                        &v_mode_u8r, BME280_GEN_READ_WRITE_DATA_LENGTH);
@@ -1215,14 +1376,10 @@ BME280_RETURN_FUNCTION_TYPE bme280_get_power_mode(u8 *v_power_mode_u8) {
  *
  *
 */
-BME280_RETURN_FUNCTION_TYPE bme280_set_power_mode(u8 v_power_mode_u8) {
+BME280_RETURN_FUNCTION_TYPE bme280_set_power_mode(struct bme280_t *p_bme280, u8 v_power_mode_u8) {
     /* used to return the communication result*/
     BME280_RETURN_FUNCTION_TYPE com_rslt = ERROR;
     u8 v_mode_u8r = BME280_INIT_VALUE;
-    u8 v_prev_pow_mode_u8 = BME280_INIT_VALUE;
-    u8 v_pre_ctrl_hum_value_u8 = BME280_INIT_VALUE;
-    u8 v_pre_config_value_u8 = BME280_INIT_VALUE;
-    u8 v_data_u8 = BME280_INIT_VALUE;
     /* check the p_bme280 structure pointer as NULL*/
     if (p_bme280 == BME280_NULL) {
         return E_BME280_NULL_PTR;
@@ -1233,56 +1390,12 @@ BME280_RETURN_FUNCTION_TYPE bme280_set_power_mode(u8 v_power_mode_u8) {
                 BME280_SET_BITSLICE(v_mode_u8r,
                                     BME280_CTRL_MEAS_REG_POWER_MODE,
                                     v_power_mode_u8);
-            com_rslt = bme280_get_power_mode(
-                           &v_prev_pow_mode_u8);
-            if (v_prev_pow_mode_u8 != BME280_SLEEP_MODE) {
-                com_rslt += bme280_set_soft_rst();
-                p_bme280->delay_msec(BME280_3MS_DELAY);
-                /* write previous value of
-                configuration register*/
-                v_pre_config_value_u8 =
-                    p_bme280->config_reg;
-                com_rslt = bme280_write_register(
-                               BME280_CONFIG_REG,
-                               &v_pre_config_value_u8,
-                               BME280_GEN_READ_WRITE_DATA_LENGTH);
-                /* write previous value of
-                humidity oversampling*/
-                v_pre_ctrl_hum_value_u8 =
-                    p_bme280->ctrl_hum_reg;
-                com_rslt += bme280_write_register(
-                                BME280_CTRL_HUMIDITY_REG,
-                                &v_pre_ctrl_hum_value_u8,
-                                BME280_GEN_READ_WRITE_DATA_LENGTH);
-                /* write previous and updated value of
-                control measurement register*/
-                com_rslt += bme280_write_register(
-                                BME280_CTRL_MEAS_REG,
-                                &v_mode_u8r,
-                                BME280_GEN_READ_WRITE_DATA_LENGTH);
-            } else {
-                com_rslt =
-                    p_bme280->BME280_BUS_WRITE_FUNC(
-                        p_bme280->dev_addr,
-                        BME280_CTRL_MEAS_REG_POWER_MODE__REG,
-                        &v_mode_u8r,
-                        BME280_GEN_READ_WRITE_DATA_LENGTH);
-            }
-            /* read the control measurement register value*/
-            com_rslt = bme280_read_register(
-                           BME280_CTRL_MEAS_REG,
-                           &v_data_u8, BME280_GEN_READ_WRITE_DATA_LENGTH);
-            p_bme280->ctrl_meas_reg = v_data_u8;
-            /* read the control humidity register value*/
-            com_rslt += bme280_read_register(
-                            BME280_CTRL_HUMIDITY_REG,
-                            &v_data_u8, BME280_GEN_READ_WRITE_DATA_LENGTH);
-            p_bme280->ctrl_hum_reg = v_data_u8;
-            /* read the config register value*/
-            com_rslt += bme280_read_register(
-                            BME280_CONFIG_REG,
-                            &v_data_u8, BME280_GEN_READ_WRITE_DATA_LENGTH);
-            p_bme280->config_reg = v_data_u8;
+            /* write the updated value together with the
+            previous values of the other control registers*/
+            com_rslt = bme280_apply_settings(p_bme280,
+                           p_bme280->ctrl_hum_reg,
+                           v_mode_u8r,
+                           p_bme280->config_reg);
         } else {
             com_rslt = E_BME280_OUT_OF_RANGE;
         }
@@ -1304,18 +1417,20 @@ BME280_RETURN_FUNCTION_TYPE bme280_set_power_mode(u8 v_power_mode_u8) {
  *
  *
 */
-BME280_RETURN_FUNCTION_TYPE bme280_set_soft_rst(void) {
+BME280_RETURN_FUNCTION_TYPE bme280_set_soft_rst(struct bme280_t *p_bme280) {
     /* used to return the communication result*/
     BME280_RETURN_FUNCTION_TYPE com_rslt = ERROR;
-    u8 v_data_u8 = BME280_SOFT_RESET_CODE;
+    u8 a_data_u8[] = {BME280_RST_REG, BME280_SOFT_RESET_CODE};
     /* check the p_bme280 structure pointer as NULL*/
     if (p_bme280 == BME280_NULL) {
         return E_BME280_NULL_PTR;
     } else {
-        com_rslt = p_bme280->BME280_BUS_WRITE_FUNC(
-                       p_bme280->dev_addr,
-                       BME280_RST_REG, &v_data_u8,
-                       BME280_GEN_READ_WRITE_DATA_LENGTH);
+        com_rslt = bme280_write_register_pairs(p_bme280, a_data_u8,
+                                               BME280_GEN_READ_WRITE_DATA_LENGTH);
+        /* the chip is back to its reset values*/
+        if (com_rslt == SUCCESS)
+            bme280_store_settings(p_bme280, BME280_INIT_VALUE,
+                                  BME280_INIT_VALUE, BME280_INIT_VALUE);
     }
     return com_rslt;
 }
@@ -1339,7 +1454,7 @@ BME280_RETURN_FUNCTION_TYPE bme280_set_soft_rst(void) {
  *
  *
 */
-BME280_RETURN_FUNCTION_TYPE bme280_get_spi3(u8 *v_enable_disable_u8) {
+BME280_RETURN_FUNCTION_TYPE bme280_get_spi3(struct bme280_t *p_bme280, u8 *v_enable_disable_u8) {
     /* used to return the communication result*/
     BME280_RETURN_FUNCTION_TYPE com_rslt = ERROR;
     u8 v_data_u8 = BME280_INIT_VALUE;
@@ -1347,7 +1462,7 @@ BME280_RETURN_FUNCTION_TYPE bme280_get_spi3(u8 *v_enable_disable_u8) {
     if (p_bme280 == BME280_NULL) {
         return E_BME280_NULL_PTR;
     } else {
-        com_rslt = p_bme280->BME280_BUS_READ_FUNC(
+        com_rslt = BME280_BUS_READ_FUNC(p_bme280->bus,
                        p_bme280->dev_addr,
                        BME280_CONFIG_REG_SPI3_ENABLE__REG,
                        &v_data_u8, BME280_GEN_READ_WRITE_DATA_LENGTH);
@@ -1377,13 +1492,10 @@ BME280_RETURN_FUNCTION_TYPE bme280_get_spi3(u8 *v_enable_disable_u8) {
  *
  *
 */
-BME280_RETURN_FUNCTION_TYPE bme280_set_spi3(u8 v_enable_disable_u8) {
+BME280_RETURN_FUNCTION_TYPE bme280_set_spi3(struct bme280_t *p_bme280, u8 v_enable_disable_u8) {
     /* used to return the communication result*/
     BME280_RETURN_FUNCTION_TYPE com_rslt = ERROR;
     u8 v_data_u8 = BME280_INIT_VALUE;
-    u8 pre_ctrl_meas_value = BME280_INIT_VALUE;
-    u8 v_prev_pow_mode_u8 = BME280_INIT_VALUE;
-    u8 v_pre_ctrl_hum_value_u8 =  BME280_INIT_VALUE;
     /* check the p_bme280 structure pointer as NULL*/
     if (p_bme280 == BME280_NULL) {
         return E_BME280_NULL_PTR;
@@ -1392,53 +1504,12 @@ BME280_RETURN_FUNCTION_TYPE bme280_set_spi3(u8 v_enable_disable_u8) {
         v_data_u8 =
             BME280_SET_BITSLICE(v_data_u8,
                                 BME280_CONFIG_REG_SPI3_ENABLE, v_enable_disable_u8);
-        com_rslt = bme280_get_power_mode(&v_prev_pow_mode_u8);
-        if (v_prev_pow_mode_u8 != BME280_SLEEP_MODE) {
-            com_rslt += bme280_set_soft_rst();
-            p_bme280->delay_msec(BME280_3MS_DELAY);
-            /* write previous and updated value of
-            configuration register*/
-            com_rslt += bme280_write_register(
-                            BME280_CONFIG_REG,
-                            &v_data_u8, BME280_GEN_READ_WRITE_DATA_LENGTH);
-            /* write previous value of
-            humidity oversampling*/
-            v_pre_ctrl_hum_value_u8 =
-                p_bme280->ctrl_hum_reg;
-            com_rslt +=  bme280_write_register(
-                             BME280_CTRL_HUMIDITY_REG,
-                             &v_pre_ctrl_hum_value_u8,
-                             BME280_GEN_READ_WRITE_DATA_LENGTH);
-            /* write previous value of
-            control measurement register*/
-            pre_ctrl_meas_value =
-                p_bme280->ctrl_meas_reg;
-            com_rslt += bme280_write_register(
-                            BME280_CTRL_MEAS_REG,
-                            &pre_ctrl_meas_value,
-                            BME280_GEN_READ_WRITE_DATA_LENGTH);
-        } else {
-            com_rslt =
-                p_bme280->BME280_BUS_WRITE_FUNC(
-                    p_bme280->dev_addr,
-                    BME280_CONFIG_REG_SPI3_ENABLE__REG,
-                    &v_data_u8, BME280_GEN_READ_WRITE_DATA_LENGTH);
-        }
-        /* read the control measurement register value*/
-        com_rslt += bme280_read_register(
-                        BME280_CTRL_MEAS_REG,
-                        &v_data_u8, BME280_GEN_READ_WRITE_DATA_LENGTH);
-        p_bme280->ctrl_meas_reg = v_data_u8;
-        /* read the control humidity register value*/
-        com_rslt += bme280_read_register(
-                        BME280_CTRL_HUMIDITY_REG,
-                        &v_data_u8, BME280_GEN_READ_WRITE_DATA_LENGTH);
-        p_bme280->ctrl_hum_reg = v_data_u8;
-        /* read the control configuration register value*/
-        com_rslt += bme280_read_register(
-                        BME280_CONFIG_REG,
-                        &v_data_u8, BME280_GEN_READ_WRITE_DATA_LENGTH);
-        p_bme280->config_reg = v_data_u8;
+        /* write the updated value together with the
+        previous values of the other control registers*/
+        com_rslt = bme280_apply_settings(p_bme280,
+                       p_bme280->ctrl_hum_reg,
+                       p_bme280->ctrl_meas_reg,
+                       v_data_u8);
     }
     return com_rslt;
 }
@@ -1464,7 +1535,7 @@ BME280_RETURN_FUNCTION_TYPE bme280_set_spi3(u8 v_enable_disable_u8) {
  *
  *
 */
-BME280_RETURN_FUNCTION_TYPE bme280_get_filter(u8 *v_value_u8) {
+BME280_RETURN_FUNCTION_TYPE bme280_get_filter(struct bme280_t *p_bme280, u8 *v_value_u8) {
     /* used to return the communication result*/
     BME280_RETURN_FUNCTION_TYPE com_rslt = ERROR;
     u8 v_data_u8 = BME280_INIT_VALUE;
@@ -1472,7 +1543,7 @@ BME280_RETURN_FUNCTION_TYPE bme280_get_filter(u8 *v_value_u8) {
     if (p_bme280 == BME280_NULL) {
         return E_BME280_NULL_PTR;
     } else {
-        com_rslt = p_bme280->BME280_BUS_READ_FUNC(
+        com_rslt = BME280_BUS_READ_FUNC(p_bme280->bus,
                        p_bme280->dev_addr,
                        BME280_CONFIG_REG_FILTER__REG,
                        &v_data_u8, BME280_GEN_READ_WRITE_DATA_LENGTH);
@@ -1503,13 +1574,10 @@ BME280_RETURN_FUNCTION_TYPE bme280_get_filter(u8 *v_value_u8) {
  *
  *
 */
-BME280_RETURN_FUNCTION_TYPE bme280_set_filter(u8 v_value_u8) {
+BME280_RETURN_FUNCTION_TYPE bme280_set_filter(struct bme280_t *p_bme280, u8 v_value_u8) {
     /* used to return the communication result*/
     BME280_RETURN_FUNCTION_TYPE com_rslt = ERROR;
     u8 v_data_u8 = BME280_INIT_VALUE;
-    u8 pre_ctrl_meas_value = BME280_INIT_VALUE;
-    u8 v_prev_pow_mode_u8 = BME280_INIT_VALUE;
-    u8 v_pre_ctrl_hum_value_u8 =  BME280_INIT_VALUE;
     /* check the p_bme280 structure pointer as NULL*/
     if (p_bme280 == BME280_NULL) {
         return E_BME280_NULL_PTR;
@@ -1518,51 +1586,12 @@ BME280_RETURN_FUNCTION_TYPE bme280_set_filter(u8 v_value_u8) {
         v_data_u8 =
             BME280_SET_BITSLICE(v_data_u8,
                                 BME280_CONFIG_REG_FILTER, v_value_u8);
-        com_rslt = bme280_get_power_mode(&v_prev_pow_mode_u8);
-        if (v_prev_pow_mode_u8 != BME280_SLEEP_MODE) {
-            com_rslt += bme280_set_soft_rst();
-            p_bme280->delay_msec(BME280_3MS_DELAY);
-            /* write previous and updated value of
-            configuration register*/
-            com_rslt += bme280_write_register(
-                            BME280_CONFIG_REG,
-                            &v_data_u8, BME280_GEN_READ_WRITE_DATA_LENGTH);
-            /* write previous value of
-            humidity oversampling*/
-            v_pre_ctrl_hum_value_u8 =
-                p_bme280->ctrl_hum_reg;
-            com_rslt += bme280_write_register(
-                            BME280_CTRL_HUMIDITY_REG,
-                            &v_pre_ctrl_hum_value_u8,
-                            BME280_GEN_READ_WRITE_DATA_LENGTH);
-            /* write previous value of
-            control measurement register*/
-            pre_ctrl_meas_value =
-                p_bme280->ctrl_meas_reg;
-            com_rslt += bme280_write_register(
-                            BME280_CTRL_MEAS_REG,
-                            &pre_ctrl_meas_value,
-                            BME280_GEN_READ_WRITE_DATA_LENGTH);
-        } else {
-            com_rslt =
-                p_bme280->BME280_BUS_WRITE_FUNC(
-                    p_bme280->dev_addr,
-                    BME280_CONFIG_REG_FILTER__REG,
-                    &v_data_u8, BME280_GEN_READ_WRITE_DATA_LENGTH);
-        }
-        /* read the control measurement register value*/
-        com_rslt += bme280_read_register(BME280_CTRL_MEAS_REG,
-                                         &v_data_u8, BME280_GEN_READ_WRITE_DATA_LENGTH);
-        p_bme280->ctrl_meas_reg = v_data_u8;
-        /* read the control humidity register value*/
-        com_rslt += bme280_read_register(
-                        BME280_CTRL_HUMIDITY_REG,
-                        &v_data_u8, BME280_GEN_READ_WRITE_DATA_LENGTH);
-        p_bme280->ctrl_hum_reg = v_data_u8;
-        /* read the configuration register value*/
-        com_rslt += bme280_read_register(BME280_CONFIG_REG,
-                                         &v_data_u8, BME280_GEN_READ_WRITE_DATA_LENGTH);
-        p_bme280->config_reg = v_data_u8;
+        /* write the updated value together with the
+        previous values of the other control registers*/
+        com_rslt = bme280_apply_settings(p_bme280,
+                       p_bme280->ctrl_hum_reg,
+                       p_bme280->ctrl_meas_reg,
+                       v_data_u8);
     }
     return com_rslt;
 }
@@ -1589,7 +1618,7 @@ BME280_RETURN_FUNCTION_TYPE bme280_set_filter(u8 v_value_u8) {
  *
  *
 */
-BME280_RETURN_FUNCTION_TYPE bme280_get_standby_durn(u8 *v_standby_durn_u8) {
+BME280_RETURN_FUNCTION_TYPE bme280_get_standby_durn(struct bme280_t *p_bme280, u8 *v_standby_durn_u8) {
     /* used to return the communication result*/
     BME280_RETURN_FUNCTION_TYPE com_rslt = ERROR;
     u8 v_data_u8 = BME280_INIT_VALUE;
@@ -1597,7 +1626,7 @@ BME280_RETURN_FUNCTION_TYPE bme280_get_standby_durn(u8 *v_standby_durn_u8) {
     if (p_bme280 == BME280_NULL) {
         return E_BME280_NULL_PTR;
     } else {
-        com_rslt = p_bme280->BME280_BUS_READ_FUNC(
+        com_rslt = BME280_BUS_READ_FUNC(p_bme280->bus,
                        p_bme280->dev_addr,
                        BME280_CONFIG_REG_TSB__REG,
                        &v_data_u8, BME280_GEN_READ_WRITE_DATA_LENGTH);
@@ -1629,7 +1658,7 @@ BME280_RETURN_FUNCTION_TYPE bme280_get_standby_durn(u8 *v_standby_durn_u8) {
  *	the contents of the register t_sb.
  *	Standby time can be set using BME280_STANDBY_TIME_125_MS.
  *
- *	@note Usage Hint : bme280_set_standby_durn(BME280_STANDBY_TIME_125_MS)
+ *	@note Usage Hint : bme280_set_standby_durn(p_bme280, BME280_STANDBY_TIME_125_MS)
  *
  *
  *
@@ -1639,13 +1668,10 @@ BME280_RETURN_FUNCTION_TYPE bme280_get_standby_durn(u8 *v_standby_durn_u8) {
  *
  *
 */
-BME280_RETURN_FUNCTION_TYPE bme280_set_standby_durn(u8 v_standby_durn_u8) {
+BME280_RETURN_FUNCTION_TYPE bme280_set_standby_durn(struct bme280_t *p_bme280, u8 v_standby_durn_u8) {
     /* used to return the communication result*/
     BME280_RETURN_FUNCTION_TYPE com_rslt = ERROR;
     u8 v_data_u8 = BME280_INIT_VALUE;
-    u8 pre_ctrl_meas_value = BME280_INIT_VALUE;
-    u8 v_prev_pow_mode_u8 = BME280_INIT_VALUE;
-    u8 v_pre_ctrl_hum_value_u8 = BME280_INIT_VALUE;
     /* check the p_bme280 structure pointer as NULL*/
     if (p_bme280 == BME280_NULL) {
         return E_BME280_NULL_PTR;
@@ -1654,51 +1680,12 @@ BME280_RETURN_FUNCTION_TYPE bme280_set_standby_durn(u8 v_standby_durn_u8) {
         v_data_u8 =
             BME280_SET_BITSLICE(v_data_u8,
                                 BME280_CONFIG_REG_TSB, v_standby_durn_u8);
-        com_rslt = bme280_get_power_mode(&v_prev_pow_mode_u8);
-        if (v_prev_pow_mode_u8 != BME280_SLEEP_MODE) {
-            com_rslt += bme280_set_soft_rst();
-            p_bme280->delay_msec(BME280_3MS_DELAY);
-            /* write previous and updated value of
-            configuration register*/
-            com_rslt += bme280_write_register(
-                            BME280_CONFIG_REG,
-                            &v_data_u8, BME280_GEN_READ_WRITE_DATA_LENGTH);
-            /* write previous value of
-            humidity oversampling*/
-            v_pre_ctrl_hum_value_u8 =
-                p_bme280->ctrl_hum_reg;
-            com_rslt += bme280_write_register(
-                            BME280_CTRL_HUMIDITY_REG,
-                            &v_pre_ctrl_hum_value_u8,
-                            BME280_GEN_READ_WRITE_DATA_LENGTH);
-            /* write previous value of control
-            measurement register*/
-            pre_ctrl_meas_value =
-                p_bme280->ctrl_meas_reg;
-            com_rslt += bme280_write_register(
-                            BME280_CTRL_MEAS_REG,
-                            &pre_ctrl_meas_value,
-                            BME280_GEN_READ_WRITE_DATA_LENGTH);
-        } else {
-            com_rslt =
-                p_bme280->BME280_BUS_WRITE_FUNC(
-                    p_bme280->dev_addr,
-                    BME280_CONFIG_REG_TSB__REG,
-                    &v_data_u8, BME280_GEN_READ_WRITE_DATA_LENGTH);
-        }
-        /* read the control measurement register value*/
-        com_rslt += bme280_read_register(BME280_CTRL_MEAS_REG,
-                                         &v_data_u8, BME280_GEN_READ_WRITE_DATA_LENGTH);
-        p_bme280->ctrl_meas_reg = v_data_u8;
-        /* read the control humidity register value*/
-        com_rslt += bme280_read_register(
-                        BME280_CTRL_HUMIDITY_REG,
-                        &v_data_u8, BME280_GEN_READ_WRITE_DATA_LENGTH);
-        p_bme280->ctrl_hum_reg = v_data_u8;
-        /* read the configuration register value*/
-        com_rslt += bme280_read_register(BME280_CONFIG_REG,
-                                         &v_data_u8, BME280_GEN_READ_WRITE_DATA_LENGTH);
-        p_bme280->config_reg = v_data_u8;
+        /* write the updated value together with the
+        previous values of the other control registers*/
+        com_rslt = bme280_apply_settings(p_bme280,
+                       p_bme280->ctrl_hum_reg,
+                       p_bme280->ctrl_meas_reg,
+                       v_data_u8);
     }
     return com_rslt;
 }
@@ -1723,7 +1710,7 @@ BME280_RETURN_FUNCTION_TYPE bme280_set_standby_durn(u8 v_standby_durn_u8) {
  *
  *
 */
-/*BME280_RETURN_FUNCTION_TYPE bme280_set_work_mode(u8 v_work_mode_u8)
+/*BME280_RETURN_FUNCTION_TYPE bme280_set_work_mode(struct bme280_t *p_bme280, u8 v_work_mode_u8)
 {
 BME280_RETURN_FUNCTION_TYPE com_rslt = ERROR;
 u8 v_data_u8 = BME280_INIT_VALUE;
@@ -1731,7 +1718,7 @@ if (p_bme280 == BME280_NULL) {
 	return E_BME280_NULL_PTR;
 } else {
 	if (v_work_mode_u8 <= BME280_ULTRAHIGHRESOLUTION_MODE) {
-		com_rslt = p_bme280->BME280_BUS_READ_FUNC(
+		com_rslt = BME280_BUS_READ_FUNC(p_bme280->bus,
 			p_bme280->dev_addr,	BME280_CTRL_MEAS_REG,
 			&v_data_u8, BME280_GEN_READ_WRITE_DATA_LENGTH);
 		if (com_rslt == SUCCESS) {
@@ -1799,16 +1786,48 @@ return com_rslt;
 */
 BME280_RETURN_FUNCTION_TYPE
 bme280_get_forced_uncomp_pressure_temperature_humidity(
+    struct bme280_t *p_bme280,
     s32 *v_uncom_pressure_s32,
     s32 *v_uncom_temperature_s32, s32 *v_uncom_humidity_s32) {
     /* used to return the communication result*/
     BME280_RETURN_FUNCTION_TYPE com_rslt = ERROR;
-    u8 v_data_u8 = BME280_INIT_VALUE;
+    u8 a_data_u8[BME280_DATA_FRAME_SIZE] = {
+        BME280_INIT_VALUE, BME280_INIT_VALUE,
+        BME280_INIT_VALUE, BME280_INIT_VALUE,
+        BME280_INIT_VALUE, BME280_INIT_VALUE,
+        BME280_INIT_VALUE, BME280_INIT_VALUE
+    };
+
+    com_rslt = bme280_get_forced_data_frame(p_bme280, a_data_u8);
+    bme280_decode_data_frame(a_data_u8, v_uncom_pressure_s32,
+                             v_uncom_temperature_s32, v_uncom_humidity_s32);
+    return com_rslt;
+}
+/*!
+ * @brief This API is used to start one conversion in forced
+ *	mode and read the raw data frame, registers 0xF7 to 0xFE,
+ *	as soon as the conversion is complete
+ *
+ *	@note The wait is selected by the forced_wait member
+ *
+ *	@param  v_frame_u8: BME280_DATA_FRAME_SIZE bytes for the frame
+ *
+ *
+ *	@return results of bus communication function
+ *	@retval 0 -> Success
+ *	@retval -1 -> Error
+ *
+ *
+*/
+BME280_RETURN_FUNCTION_TYPE
+bme280_get_forced_data_frame(struct bme280_t *p_bme280, u8 *v_frame_u8) {
+    /* used to return the communication result*/
+    BME280_RETURN_FUNCTION_TYPE com_rslt = ERROR;
     u8 v_waittime_u8r = BME280_INIT_VALUE;
-    u8 v_prev_pow_mode_u8 = BME280_INIT_VALUE;
     u8 v_mode_u8r = BME280_INIT_VALUE;
-    u8 pre_ctrl_config_value = BME280_INIT_VALUE;
-    u8 v_pre_ctrl_hum_value_u8 = BME280_INIT_VALUE;
+    u8 a_data_u8[BME280_GEN_READ_WRITE_DATA_LENGTH * 2] = {
+        BME280_INIT_VALUE, BME280_INIT_VALUE
+    };
     /* check the p_bme280 structure pointer as NULL*/
     if (p_bme280 == BME280_NULL) {
         return E_BME280_NULL_PTR;
@@ -1817,66 +1836,143 @@ bme280_get_forced_uncomp_pressure_temperature_humidity(
         v_mode_u8r =
             BME280_SET_BITSLICE(v_mode_u8r,
                                 BME280_CTRL_MEAS_REG_POWER_MODE, BME280_FORCED_MODE);
-        com_rslt = bme280_get_power_mode(&v_prev_pow_mode_u8);
-        if (v_prev_pow_mode_u8 != BME280_SLEEP_MODE) {
-            com_rslt += bme280_set_soft_rst();
-            p_bme280->delay_msec(BME280_3MS_DELAY);
-            /* write previous and updated value of
-            configuration register*/
-            pre_ctrl_config_value = p_bme280->config_reg;
-            com_rslt += bme280_write_register(
-                            BME280_CONFIG_REG,
-                            &pre_ctrl_config_value,
-                            BME280_GEN_READ_WRITE_DATA_LENGTH);
-            /* write previous value of
-            humidity oversampling*/
-            v_pre_ctrl_hum_value_u8 =
-                p_bme280->ctrl_hum_reg;
-            com_rslt += bme280_write_register(
-                            BME280_CTRL_HUMIDITY_REG,
-                            &v_pre_ctrl_hum_value_u8,
-                            BME280_GEN_READ_WRITE_DATA_LENGTH);
-            /* write the force mode  */
-            com_rslt += bme280_write_register(
-                            BME280_CTRL_MEAS_REG,
-                            &v_mode_u8r, BME280_GEN_READ_WRITE_DATA_LENGTH);
+        a_data_u8[BME280_INIT_VALUE] = BME280_CTRL_MEAS_REG;
+        a_data_u8[BME280_GEN_READ_WRITE_DATA_LENGTH] = v_mode_u8r;
+        /* ctrl_hum and config are already in the chip, a write
+        of ctrl_meas alone starts the conversion*/
+        com_rslt = bme280_write_register_pairs(p_bme280, a_data_u8,
+                                               BME280_GEN_READ_WRITE_DATA_LENGTH);
+        if (com_rslt != SUCCESS)
+            return com_rslt;
+        /* the chip returns to sleep mode by itself*/
+        p_bme280->ctrl_meas_reg =
+            BME280_SET_BITSLICE(v_mode_u8r,
+                                BME280_CTRL_MEAS_REG_POWER_MODE, BME280_SLEEP_MODE);
+        if (p_bme280->forced_wait == BME280_FORCED_WAIT_POLL) {
+            com_rslt = bme280_wait_for_conversion(p_bme280);
         } else {
-            /* write previous value of
-            humidity oversampling*/
-            v_pre_ctrl_hum_value_u8 =
-                p_bme280->ctrl_hum_reg;
-            com_rslt += bme280_write_register(
-                            BME280_CTRL_HUMIDITY_REG,
-                            &v_pre_ctrl_hum_value_u8,
-                            BME280_GEN_READ_WRITE_DATA_LENGTH);
-            /* write the force mode  */
-            com_rslt += bme280_write_register(
-                            BME280_CTRL_MEAS_REG,
-                            &v_mode_u8r, BME280_GEN_READ_WRITE_DATA_LENGTH);
+            bme280_compute_wait_time(p_bme280, &v_waittime_u8r);
+            BME280_DELAY_FUNC(p_bme280->bus, v_waittime_u8r);
+        }
+        /* read the force-mode frame, the chip is back
+        in sleep mode*/
+        com_rslt += bme280_read_data_frame(p_bme280, v_frame_u8);
+    }
+    return com_rslt;
+}
+/*!
+ * @brief This API is used to start one conversion in forced
+ *	mode and read the true pressure, temperature and humidity
+ *	as soon as the conversion is complete
+ *
+ *
+ *	@param  v_pressure_u32 : The value of compensated pressure.
+ *	@param  v_temperature_s32 : The value of compensated temperature.
+ *	@param  v_humidity_u32 : The value of compensated humidity.
+ *
+ *
+ *	@return results of bus communication function
+ *	@retval 0 -> Success
+ *	@retval -1 -> Error
+ *
+ *
+*/
+BME280_RETURN_FUNCTION_TYPE
+bme280_get_forced_pressure_temperature_humidity(
+    struct bme280_t *p_bme280,
+    u32 *v_pressure_u32, s32 *v_temperature_s32, u32 *v_humidity_u32) {
+    /* used to return the communication result*/
+    BME280_RETURN_FUNCTION_TYPE com_rslt = ERROR;
+    s32 v_uncomp_pressure_s32 = BME280_INIT_VALUE;
+    s32 v_uncom_temperature_s32 = BME280_INIT_VALUE;
+    s32 v_uncom_humidity_s32 = BME280_INIT_VALUE;
+    /* check the p_bme280 structure pointer as NULL*/
+    if (p_bme280 == BME280_NULL) {
+        return E_BME280_NULL_PTR;
+    } else {
+        com_rslt =
+            bme280_get_forced_uncomp_pressure_temperature_humidity(p_bme280,
+                &v_uncomp_pressure_s32, &v_uncom_temperature_s32,
+                &v_uncom_humidity_s32);
+        /* read the true pressure, temperature and humidity*/
+        bme280_compensate_pressure_temperature_humidity(p_bme280,
+            v_uncomp_pressure_s32, v_uncom_temperature_s32,
+            v_uncom_humidity_s32,
+            v_pressure_u32, v_temperature_s32, v_humidity_u32);
+    }
+    return com_rslt;
+}
+/*!
+ * @brief This API is used to wait for the end of a conversion,
+ *	it sleeps the typical conversion time and then polls
+ *	the measuring bit of the status register 0xF3
+ *
+ *
+ *	@return results of bus communication function
+ *	@retval 0 -> Success
+ *	@retval -1 -> Error, also when the conversion outlasts
+ *	the maximum time given by bme280_compute_wait_time
+ *
+ *
+*/
+BME280_RETURN_FUNCTION_TYPE bme280_wait_for_conversion(struct bme280_t *p_bme280) {
+    u8 v_maxtime_u8 = BME280_INIT_VALUE;
+    u32 v_typtime_u32 = BME280_INIT_VALUE;
+    /* check the p_bme280 structure pointer as NULL*/
+    if (p_bme280 == BME280_NULL) {
+        return E_BME280_NULL_PTR;
+    } else {
+        bme280_compute_wait_time(p_bme280, &v_maxtime_u8);
+        bme280_compute_typical_wait_time(p_bme280, &v_typtime_u32);
+        /* no point in asking before the typical time is over*/
+        sensor_bus_delay(p_bme280->bus, v_typtime_u32);
+        return bme280_poll_status(p_bme280, BME280_STAT_REG_MEASURING__MSK,
+                                  v_maxtime_u8 * 1000 - v_typtime_u32);
+    }
+}
+/*!
+ * @brief This API is used to poll the status register 0xF3
+ *	until all the bits of the given mask are clear
+ *
+ *
+ *	@param v_mask_u8 : BME280_STAT_REG_MEASURING__MSK and/or
+ *	BME280_STAT_REG_IM_UPDATE__MSK
+ *	@param v_timeout_u32 : give up after this many microseconds
+ *
+ *
+ *	@return results of bus communication function
+ *	@retval 0 -> Success
+ *	@retval -1 -> Error or timeout
+ *
+ *
+*/
+BME280_RETURN_FUNCTION_TYPE bme280_poll_status(struct bme280_t *p_bme280, u8 v_mask_u8,
+        u32 v_timeout_u32) {
+    /* used to return the communication result*/
+    BME280_RETURN_FUNCTION_TYPE com_rslt = ERROR;
+    u8 v_status_u8 = BME280_INIT_VALUE;
+    u64 v_deadline_u64 = BME280_INIT_VALUE;
+    /* check the p_bme280 structure pointer as NULL*/
+    if (p_bme280 == BME280_NULL) {
+        return E_BME280_NULL_PTR;
+    } else {
+        v_deadline_u64 = sensor_bus_clock(p_bme280->bus) + v_timeout_u32;
+        for (;;) {
+            com_rslt = BME280_BUS_READ_FUNC(p_bme280->bus,
+                                            p_bme280->dev_addr,
+                                            BME280_STAT_REG, &v_status_u8,
+                                            BME280_GEN_READ_WRITE_DATA_LENGTH);
+            if (com_rslt != SUCCESS)
+                break;
+            if (!(v_status_u8 & v_mask_u8))
+                break;
+            if (sensor_bus_clock(p_bme280->bus) >= v_deadline_u64) {
+                com_rslt = ERROR;
+                break;
+            }
+            sensor_bus_delay(p_bme280->bus,
+                             BME280_STATUS_POLL_INTERVAL_US);
         }
-        bme280_compute_wait_time(&v_waittime_u8r);
-        p_bme280->delay_msec(v_waittime_u8r);
-        /* read the force-mode value of pressure
-        temperature and humidity*/
-        com_rslt +=
-            bme280_read_uncomp_pressure_temperature_humidity(
-                v_uncom_pressure_s32, v_uncom_temperature_s32,
-                v_uncom_humidity_s32);
-
-        /* read the control humidity register value*/
-        com_rslt += bme280_read_register(
-                        BME280_CTRL_HUMIDITY_REG,
-                        &v_data_u8, BME280_GEN_READ_WRITE_DATA_LENGTH);
-        p_bme280->ctrl_hum_reg = v_data_u8;
-        /* read the configuration register value*/
-        com_rslt += bme280_read_register(BME280_CONFIG_REG,
-                                         &v_data_u8, BME280_GEN_READ_WRITE_DATA_LENGTH);
-        p_bme280->config_reg = v_data_u8;
-
-        /* read the control measurement register value*/
-        com_rslt += bme280_read_register(BME280_CTRL_MEAS_REG,
-                                         &v_data_u8, BME280_GEN_READ_WRITE_DATA_LENGTH);
-        p_bme280->ctrl_meas_reg = v_data_u8;
     }
     return com_rslt;
 }
@@ -1897,17 +1993,22 @@ bme280_get_forced_uncomp_pressure_temperature_humidity(
  *
  *
  */
-BME280_RETURN_FUNCTION_TYPE bme280_write_register(u8 v_addr_u8,
+BME280_RETURN_FUNCTION_TYPE bme280_write_register(struct bme280_t *p_bme280, u8 v_addr_u8,
         u8 *v_data_u8, u8 v_len_u8) {
     /* used to return the communication result*/
     BME280_RETURN_FUNCTION_TYPE com_rslt = ERROR;
+    u8 a_pairs_u8[2 * v_len_u8];
+    u8 v_pos_u8 = BME280_INIT_VALUE;
     /* check the p_bme280 structure pointer as NULL*/
     if (p_bme280 == BME280_NULL) {
         return E_BME280_NULL_PTR;
     } else {
-        com_rslt = p_bme280->BME280_BUS_WRITE_FUNC(
-                       p_bme280->dev_addr,
-                       v_addr_u8, v_data_u8, v_len_u8);
+        /* registers are not auto-incremented on writes */
+        for (v_pos_u8 = BME280_INIT_VALUE; v_pos_u8 < v_len_u8; v_pos_u8++) {
+            a_pairs_u8[2 * v_pos_u8] = v_addr_u8 + v_pos_u8;
+            a_pairs_u8[2 * v_pos_u8 + 1] = v_data_u8[v_pos_u8];
+        }
+        com_rslt = bme280_write_register_pairs(p_bme280, a_pairs_u8, v_len_u8);
     }
     return com_rslt;
 }
@@ -1928,7 +2029,7 @@ BME280_RETURN_FUNCTION_TYPE bme280_write_register(u8 v_addr_u8,
  *
  *
  */
-BME280_RETURN_FUNCTION_TYPE bme280_read_register(u8 v_addr_u8,
+BME280_RETURN_FUNCTION_TYPE bme280_read_register(struct bme280_t *p_bme280, u8 v_addr_u8,
         u8 *v_data_u8, u8 v_len_u8) {
     /* used to return the communication result*/
     BME280_RETURN_FUNCTION_TYPE com_rslt = ERROR;
@@ -1936,12 +2037,203 @@ BME280_RETURN_FUNCTION_TYPE bme280_read_register(u8 v_addr_u8,
     if (p_bme280 == BME280_NULL) {
         return E_BME280_NULL_PTR;
     } else {
-        com_rslt = p_bme280->BME280_BUS_READ_FUNC(
+        com_rslt = BME280_BUS_READ_FUNC(p_bme280->bus,
                        p_bme280->dev_addr,
                        v_addr_u8, v_data_u8, v_len_u8);
     }
     return com_rslt;
 }
+/*!
+ * @brief
+ *	This API writes a run of (register, value) pairs
+ *	in a single bus transaction
+ *
+ *
+ *	@param v_pairs_u8 -> Register addresses and data, interleaved
+ *	@param v_cnt_u8 -> no of pairs to write
+ *
+ *
+ *	@return results of bus communication function
+ *	@retval 0 -> Success
+ *	@retval -1 -> Error
+ *
+ *
+ */
+BME280_RETURN_FUNCTION_TYPE bme280_write_register_pairs(struct bme280_t *p_bme280, u8 *v_pairs_u8,
+        u8 v_cnt_u8) {
+    /* used to return the communication result*/
+    BME280_RETURN_FUNCTION_TYPE com_rslt = ERROR;
+    /* check the p_bme280 structure pointer as NULL*/
+    if (p_bme280 == BME280_NULL) {
+        return E_BME280_NULL_PTR;
+    } else {
+        com_rslt = BME280_BUS_WRITE_PAIRS_FUNC(p_bme280->bus,
+                                               p_bme280->dev_addr, v_pairs_u8, v_cnt_u8);
+    }
+    return com_rslt;
+}
+/*!
+ * @brief
+ *	This API writes the control humidity, control measurement
+ *	and configuration registers in a single bus transaction
+ *
+ *	@note The control measurement register is first written
+ *	with the sleep mode, since writes to the configuration
+ *	register may be ignored in normal mode. The humidity
+ *	setting becomes effective with the final control
+ *	measurement write. No soft reset is needed.
+ *
+ *	@param v_ctrl_hum_u8 -> The value of control humidity register
+ *	@param v_ctrl_meas_u8 -> The value of control measurement register
+ *	@param v_config_u8 -> The value of configuration register
+ *
+ *
+ *	@return results of bus communication function
+ *	@retval 0 -> Success
+ *	@retval -1 -> Error
+ *
+ *
+ */
+BME280_RETURN_FUNCTION_TYPE bme280_write_settings(struct bme280_t *p_bme280, u8 v_ctrl_hum_u8,
+        u8 v_ctrl_meas_u8, u8 v_config_u8) {
+    u8 a_pairs_u8[BME280_SETTINGS_PAIRS_SIZE] = {
+        BME280_CTRL_MEAS_REG,
+        BME280_SET_BITSLICE(v_ctrl_meas_u8,
+                            BME280_CTRL_MEAS_REG_POWER_MODE, BME280_SLEEP_MODE),
+        BME280_CONFIG_REG, v_config_u8,
+        BME280_CTRL_HUMIDITY_REG, v_ctrl_hum_u8,
+        BME280_CTRL_MEAS_REG, v_ctrl_meas_u8
+    };
+
+    return bme280_write_register_pairs(p_bme280, a_pairs_u8,
+                                       BME280_SETTINGS_PAIRS_LENGTH);
+}
+/*!
+ * @brief
+ *	This API writes the control humidity, control measurement
+ *	and configuration registers in a single bus transaction and,
+ *	when that succeeds, takes the written values as the stored
+ *	copies, no read back needed
+ *
+ *	@note A forced mode conversion ends in sleep mode, that is
+ *	what gets stored for it
+ *
+ *	@param v_ctrl_hum_u8 -> Value of the control humidity register
+ *	@param v_ctrl_meas_u8 -> Value of the control measurement register
+ *	@param v_config_u8 -> Value of the configuration register
+ *
+ *
+ *	@return results of bus communication function
+ *	@retval 0 -> Success
+ *	@retval -1 -> Error
+ *
+ *
+ */
+BME280_RETURN_FUNCTION_TYPE bme280_apply_settings(struct bme280_t *p_bme280, u8 v_ctrl_hum_u8,
+        u8 v_ctrl_meas_u8, u8 v_config_u8) {
+    /* used to return the communication result*/
+    BME280_RETURN_FUNCTION_TYPE com_rslt = ERROR;
+    /* check the p_bme280 structure pointer as NULL*/
+    if (p_bme280 == BME280_NULL) {
+        return E_BME280_NULL_PTR;
+    } else {
+        com_rslt = bme280_write_settings(p_bme280, v_ctrl_hum_u8,
+                                         v_ctrl_meas_u8, v_config_u8);
+        if (com_rslt == SUCCESS)
+            bme280_store_settings(p_bme280, v_ctrl_hum_u8,
+                                  bme280_settled_ctrl_meas(v_ctrl_meas_u8),
+                                  v_config_u8);
+    }
+    return com_rslt;
+}
+/*!
+ * @brief
+ *	This API reads the control registers (0xF2 to 0xF5) in
+ *	a single bus transaction and compares them with the
+ *	stored copies, on a mismatch the stored copies are
+ *	written to the chip again
+ *
+ *
+ *	@param v_mismatch_u8 -> 1 when the chip had to be resynced
+ *
+ *
+ *	@return results of bus communication function
+ *	@retval 0 -> Success
+ *	@retval -1 -> Error
+ *
+ *
+ */
+BME280_RETURN_FUNCTION_TYPE bme280_verify_settings(struct bme280_t *p_bme280, u8 *v_mismatch_u8) {
+    /* used to return the communication result*/
+    BME280_RETURN_FUNCTION_TYPE com_rslt = ERROR;
+    u8 a_data_u8[BME280_SETTINGS_DATA_SIZE] = {
+        BME280_INIT_VALUE, BME280_INIT_VALUE,
+        BME280_INIT_VALUE, BME280_INIT_VALUE
+    };
+    *v_mismatch_u8 = BME280_INIT_VALUE;
+    /* check the p_bme280 structure pointer as NULL*/
+    if (p_bme280 == BME280_NULL) {
+        return E_BME280_NULL_PTR;
+    } else {
+        com_rslt = BME280_BUS_READ_FUNC(p_bme280->bus,
+                       p_bme280->dev_addr,
+                       BME280_CTRL_HUMIDITY_REG,
+                       a_data_u8, BME280_SETTINGS_DATA_LENGTH);
+        if (com_rslt != SUCCESS)
+            return com_rslt;
+        if (((a_data_u8[BME280_SETTINGS_CTRL_HUMIDITY_BYTE] ^
+                p_bme280->ctrl_hum_reg) &
+                BME280_CTRL_HUMIDITY_REG_OVERSAMP_HUMIDITY__MSK) ||
+                (bme280_settled_ctrl_meas(
+                     a_data_u8[BME280_SETTINGS_CTRL_MEAS_BYTE]) !=
+                 p_bme280->ctrl_meas_reg) ||
+                ((a_data_u8[BME280_SETTINGS_CONFIG_BYTE] ^
+                  p_bme280->config_reg) & BME280_CONFIG_REG_MSK)) {
+            *v_mismatch_u8 = 1;
+            com_rslt = bme280_write_settings(p_bme280, p_bme280->ctrl_hum_reg,
+                                             p_bme280->ctrl_meas_reg,
+                                             p_bme280->config_reg);
+        }
+    }
+    return com_rslt;
+}
+/*!
+ * @brief
+ *	This API reads the control humidity, status, control
+ *	measurement and configuration registers (0xF2 to 0xF5)
+ *	in a single bus transaction and updates the stored copies
+ *	and the oversampling settings
+ *
+ *
+ *	@return results of bus communication function
+ *	@retval 0 -> Success
+ *	@retval -1 -> Error
+ *
+ *
+ */
+BME280_RETURN_FUNCTION_TYPE bme280_read_settings(struct bme280_t *p_bme280) {
+    /* used to return the communication result*/
+    BME280_RETURN_FUNCTION_TYPE com_rslt = ERROR;
+    u8 a_data_u8[BME280_SETTINGS_DATA_SIZE] = {
+        BME280_INIT_VALUE, BME280_INIT_VALUE,
+        BME280_INIT_VALUE, BME280_INIT_VALUE
+    };
+    /* check the p_bme280 structure pointer as NULL*/
+    if (p_bme280 == BME280_NULL) {
+        return E_BME280_NULL_PTR;
+    } else {
+        com_rslt = BME280_BUS_READ_FUNC(p_bme280->bus,
+                       p_bme280->dev_addr,
+                       BME280_CTRL_HUMIDITY_REG,
+                       a_data_u8, BME280_SETTINGS_DATA_LENGTH);
+        if (com_rslt == SUCCESS)
+            bme280_store_settings(p_bme280,
+                a_data_u8[BME280_SETTINGS_CTRL_HUMIDITY_BYTE],
+                a_data_u8[BME280_SETTINGS_CTRL_MEAS_BYTE],
+                a_data_u8[BME280_SETTINGS_CONFIG_BYTE]);
+    }
+    return com_rslt;
+}
 #ifdef BME280_ENABLE_FLOAT
 /*!
  * @brief Reads actual temperature from uncompensated temperature
@@ -1957,7 +2249,7 @@ BME280_RETURN_FUNCTION_TYPE bme280_read_register(u8 v_addr_u8,
  *  @return  Return the actual temperature in floating point
  *
 */
-double bme280_compensate_temperature_double(s32 v_uncom_temperature_s32) {
+double bme280_compensate_temperature_double(struct bme280_t *p_bme280, s32 v_uncom_temperature_s32) {
     double v_x1_u32 = BME280_INIT_VALUE;
     double v_x2_u32 = BME280_INIT_VALUE;
     double temperature = BME280_INIT_VALUE;
@@ -1989,7 +2281,7 @@ double bme280_compensate_temperature_double(s32 v_uncom_temperature_s32) {
  *  @return  Return the actual pressure in floating point
  *
 */
-double bme280_compensate_pressure_double(s32 v_uncom_pressure_s32) {
+double bme280_compensate_pressure_double(struct bme280_t *p_bme280, s32 v_uncom_pressure_s32) {
     double v_x1_u32 = BME280_INIT_VALUE;
     double v_x2_u32 = BME280_INIT_VALUE;
     double pressure = BME280_INIT_VALUE;
@@ -2033,20 +2325,19 @@ double bme280_compensate_pressure_double(s32 v_uncom_pressure_s32) {
  *  @return Return the actual humidity in floating point
  *
 */
-double bme280_compensate_humidity_double(s32 v_uncom_humidity_s32) {
+double bme280_compensate_humidity_double(struct bme280_t *p_bme280, s32 v_uncom_humidity_s32) {
     double var_h = BME280_INIT_VALUE;
 
     var_h = (((double)p_bme280->cal_param.t_fine) - 76800.0);
-    if (var_h != BME280_INIT_VALUE)
-        var_h = (v_uncom_humidity_s32 -
-                 (((double)p_bme280->cal_param.dig_H4) * 64.0 +
-                  ((double)p_bme280->cal_param.dig_H5) / 16384.0 * var_h)) *
-                (((double)p_bme280->cal_param.dig_H2) / 65536.0 *
-                 (1.0 + ((double) p_bme280->cal_param.dig_H6)
-                  / 67108864.0 * var_h * (1.0 + ((double)
-                                          p_bme280->cal_param.dig_H3) / 67108864.0 * var_h)));
-    else
-        return BME280_INVALID_DATA;
+    /* nothing is divided by var_h, a t_fine of 76800 (15 DegC) is a
+       valid reading, not an error as the vendor code has it */
+    var_h = (v_uncom_humidity_s32 -
+             (((double)p_bme280->cal_param.dig_H4) * 64.0 +
+              ((double)p_bme280->cal_param.dig_H5) / 16384.0 * var_h)) *
+            (((double)p_bme280->cal_param.dig_H2) / 65536.0 *
+             (1.0 + ((double) p_bme280->cal_param.dig_H6)
+              / 67108864.0 * var_h * (1.0 + ((double)
+                                      p_bme280->cal_param.dig_H3) / 67108864.0 * var_h)));
     var_h = var_h * (1.0 - ((double)
                             p_bme280->cal_param.dig_H1) * var_h / 524288.0);
     if (var_h > 100.0)
@@ -2058,6 +2349,44 @@ double bme280_compensate_humidity_double(s32 v_uncom_humidity_s32) {
 }
 #endif
 #if defined(BME280_ENABLE_INT64) && defined(BME280_64BITSUPPORT_PRESENT)
+/*!
+ *	@brief This function brings the int64 pressure stage of
+ *	p_bme280->coef up to date with p_bme280->cal_param.t_fine,
+ *	only the int64 backend pays for the 64 bit products
+ *
+ *
+*/
+static void bme280_pressure_stage_int64(struct bme280_t *p_bme280) {
+    struct bme280_coefficients_t *coef = &p_bme280->coef;
+    s32 v_t_fine_s32 = p_bme280->cal_param.t_fine;
+    s64 v_x1_s64r = BME280_INIT_VALUE;
+    s64 v_x2_s64r = BME280_INIT_VALUE;
+
+    if (coef->p64_valid && (coef->p64_t_fine == v_t_fine_s32))
+        return;
+
+    v_x1_s64r = ((s64)v_t_fine_s32) - 128000;
+    v_x2_s64r = v_x1_s64r * v_x1_s64r *
+                (s64)p_bme280->cal_param.dig_P6;
+    v_x2_s64r = v_x2_s64r + ((v_x1_s64r *
+                              (s64)p_bme280->cal_param.dig_P5)
+                             << BME280_SHIFT_BIT_POSITION_BY_17_BITS);
+    coef->p64_x2 = v_x2_s64r +
+                   (((s64)p_bme280->cal_param.dig_P4)
+                    << BME280_SHIFT_BIT_POSITION_BY_35_BITS);
+    v_x1_s64r = ((v_x1_s64r * v_x1_s64r *
+                  (s64)p_bme280->cal_param.dig_P3)
+                 >> BME280_SHIFT_BIT_POSITION_BY_08_BITS) +
+                ((v_x1_s64r * (s64)p_bme280->cal_param.dig_P2)
+                 << BME280_SHIFT_BIT_POSITION_BY_12_BITS);
+    coef->p64_x1 = (((((s64)1)
+                      << BME280_SHIFT_BIT_POSITION_BY_47_BITS) + v_x1_s64r)) *
+                   ((s64)p_bme280->cal_param.dig_P1)
+                   >> BME280_SHIFT_BIT_POSITION_BY_33_BITS;
+
+    coef->p64_t_fine = v_t_fine_s32;
+    coef->p64_valid = 1;
+}
 /*!
  * @brief Reads actual pressure from uncompensated pressure
  * @note Returns the value in Pa as unsigned 32 bit
@@ -2074,30 +2403,15 @@ double bme280_compensate_humidity_double(s32 v_uncom_humidity_s32) {
  *  @return Return the actual pressure in u32
  *
 */
-u32 bme280_compensate_pressure_int64(s32 v_uncom_pressure_s32) {
+u32 bme280_compensate_pressure_int64(struct bme280_t *p_bme280, s32 v_uncom_pressure_s32) {
     s64 v_x1_s64r = BME280_INIT_VALUE;
     s64 v_x2_s64r = BME280_INIT_VALUE;
     s64 pressure = BME280_INIT_VALUE;
 
-    v_x1_s64r = ((s64)p_bme280->cal_param.t_fine)
-                - 128000;
-    v_x2_s64r = v_x1_s64r * v_x1_s64r *
-                (s64)p_bme280->cal_param.dig_P6;
-    v_x2_s64r = v_x2_s64r + ((v_x1_s64r *
-                              (s64)p_bme280->cal_param.dig_P5)
-                             << BME280_SHIFT_BIT_POSITION_BY_17_BITS);
-    v_x2_s64r = v_x2_s64r +
-                (((s64)p_bme280->cal_param.dig_P4)
-                 << BME280_SHIFT_BIT_POSITION_BY_35_BITS);
-    v_x1_s64r = ((v_x1_s64r * v_x1_s64r *
-                  (s64)p_bme280->cal_param.dig_P3)
-                 >> BME280_SHIFT_BIT_POSITION_BY_08_BITS) +
-                ((v_x1_s64r * (s64)p_bme280->cal_param.dig_P2)
-                 << BME280_SHIFT_BIT_POSITION_BY_12_BITS);
-    v_x1_s64r = (((((s64)1)
-                   << BME280_SHIFT_BIT_POSITION_BY_47_BITS) + v_x1_s64r)) *
-                ((s64)p_bme280->cal_param.dig_P1)
-                >> BME280_SHIFT_BIT_POSITION_BY_33_BITS;
+    /* x1 and x2 depend on t_fine only*/
+    bme280_pressure_stage_int64(p_bme280);
+    v_x1_s64r = p_bme280->coef.p64_x1;
+    v_x2_s64r = p_bme280->coef.p64_x2;
     pressure = 1048576 - v_uncom_pressure_s32;
     /* Avoid exception caused by division by zero */
     if (v_x1_s64r != BME280_INIT_VALUE)
@@ -2140,10 +2454,11 @@ u32 bme280_compensate_pressure_int64(s32 v_uncom_pressure_s32) {
  *
 */
 u32 bme280_compensate_pressure_int64_twentyfour_bit_output(
+    struct bme280_t *p_bme280,
     s32 v_uncom_pressure_s32) {
     u32 pressure = BME280_INIT_VALUE;
 
-    pressure = bme280_compensate_pressure_int64(
+    pressure = bme280_compensate_pressure_int64(p_bme280,
                    v_uncom_pressure_s32);
     pressure = (u32)(pressure >> BME280_SHIFT_BIT_POSITION_BY_01_BIT);
     return pressure;
@@ -2162,7 +2477,7 @@ u32 bme280_compensate_pressure_int64_twentyfour_bit_output(
  *
  *
  */
-BME280_RETURN_FUNCTION_TYPE bme280_compute_wait_time(u8
+BME280_RETURN_FUNCTION_TYPE bme280_compute_wait_time(struct bme280_t *p_bme280, u8
         *v_delaytime_u8) {
     /* used to return the communication result*/
     BME280_RETURN_FUNCTION_TYPE com_rslt = SUCCESS;
@@ -2182,3 +2497,36 @@ BME280_RETURN_FUNCTION_TYPE bme280_compute_wait_time(u8
                         T_SETUP_HUMIDITY_MAX : 0) + 15) / 16;
     return com_rslt;
 }
+/*!
+ * @brief Computing the typical conversion time
+ *
+ *
+ *
+ *
+ *  @param v_delaytime_u32 : The typical conversion time in microseconds
+ *
+ *
+ *	@retval 0 -> Success
+ *
+ *
+ */
+BME280_RETURN_FUNCTION_TYPE bme280_compute_typical_wait_time(struct bme280_t *p_bme280, u32
+        *v_delaytime_u32) {
+    /* used to return the communication result*/
+    BME280_RETURN_FUNCTION_TYPE com_rslt = SUCCESS;
+
+    *v_delaytime_u32 = (T_INIT_TYP +
+                        T_MEASURE_PER_OSRS_TYP *
+                        (((1 <<
+                           p_bme280->oversamp_temperature)
+                          >> BME280_SHIFT_BIT_POSITION_BY_01_BIT)
+                         + ((1 << p_bme280->oversamp_pressure)
+                            >> BME280_SHIFT_BIT_POSITION_BY_01_BIT) +
+                         ((1 << p_bme280->oversamp_humidity)
+                          >> BME280_SHIFT_BIT_POSITION_BY_01_BIT))
+                        + (p_bme280->oversamp_pressure ?
+                           T_SETUP_PRESSURE_TYP : 0) +
+                        (p_bme280->oversamp_humidity ?
+                         T_SETUP_HUMIDITY_TYP : 0)) * 1000 / 16;
+    return com_rslt;
+}
@@ -59,6 +59,7 @@
 #ifndef __BME280_H__
 #define __BME280_H__
 
+#include "sensor-bus.h"
 
 /*!
 * @brief The following definition uses for define the data types
@@ -326,105 +327,33 @@ define the data types manually
 	large libraries), please do not set the define. */
 #define BME280_ENABLE_INT64
 /***************************************************************/
-/**\name	BUS READ AND WRITE FUNCTION POINTERS        */
+/**\name	BUS READ AND WRITE FUNCTIONS        */
 /***************************************************************/
 /*!
-	@brief Define the calling convention of YOUR bus communication routine.
-	@note This includes types of parameters. This example shows the
-	configuration for an SPI bus link.
-
-    If your communication function looks like this:
-
-    write_my_bus_xy(u8 device_addr, u8 register_addr,
-    u8 * data, u8 length);
-
-    The BME280_WR_FUNC_PTR would equal:
-
-	BME280_WR_FUNC_PTR s8 (* bus_write)(u8,
-    u8, u8 *, u8)
-
-    Parameters can be mixed as needed refer to the
-    refer BME280_BUS_WRITE_FUNC  macro.
+	@brief link macros between API function calls and the sensor bus
+	@note The bus is a struct sensor_bus_t, see sensor-bus.h.
 
+    Reads are one combined transaction, the BME280 auto-increments
+    the register address, so any register block comes back at once.
 
+    Registers are not auto-incremented on writes, consecutive
+    registers are sent as (register, value) pairs in one message.
 */
-/** defines the return parameter type of the BME280_WR_FUNCTION */
-#define BME280_BUS_WR_RETURN_TYPE s8
-
-/* links the order of parameters defined in
-BME280_BUS_WR_PARAM_TYPE to function calls used inside the API*/
-#define BME280_BUS_WR_PARAM_TYPES u8, u8,\
-		u8 *, u8
-
-/* links the order of parameters defined in
-BME280_BUS_WR_PARAM_TYPE to function calls used inside the API*/
-#define BME280_BUS_WR_PARAM_ORDER(device_addr, register_addr,\
-		register_data, wr_len)
-
-/* never change this line */
-#define BME280_BUS_WRITE_FUNC(device_addr, register_addr,\
-register_data, wr_len) bus_write(device_addr, register_addr,\
-		register_data, wr_len)
-/*!
-	@brief link macro between API function calls and bus read function
-	@note The bus write function can change since this is a
-	system dependant issue.
-
-    If the bus_read parameter calling order is like: reg_addr,
-    reg_data, wr_len it would be as it is here.
+#define BME280_BUS_READ_FUNC(bus, device_addr, register_addr,\
+		register_data, rd_len)sensor_bus_read(bus, device_addr,\
+		register_addr, register_data, rd_len)
 
-    If the parameters are differently ordered or your communication
-    function like I2C need to know the device address,
-    you can change this macro accordingly.
-
-
-    BME280_BUS_READ_FUNC(dev_addr, reg_addr, reg_data, wr_len)\
-    bus_read(dev_addr, reg_addr, reg_data, wr_len)
-
-    This macro lets all API functions call YOUR communication routine in a
-    way that equals your definition in the
-    refer BME280_WR_FUNC_PTR definition.
-
-    @note: this macro also includes the "MSB='1'
-    for reading BME280 addresses.
-
-*/
-/*defines the return parameter type of the BME280_RD_FUNCTION
-*/
-#define BME280_BUS_RD_RETURN_TYPE s8
-
-/**\brief defines the calling parameter types of the BME280_RD_FUNCTION
-*/
-#define BME280_BUS_RD_PARAM_TYPES (u8, u8,\
-		u8 *, u8)
-
-/* links the order of parameters defined in \
-BME280_BUS_RD_PARAM_TYPE to function calls used inside the API
-*/
-#define BME280_BUS_RD_PARAM_ORDER (device_addr, register_addr,\
-		register_data)
-
-/* never change this line */
-#define BME280_BUS_READ_FUNC(device_addr, register_addr,\
-		register_data, rd_len)bus_read(device_addr, register_addr,\
-		register_data, rd_len)
+#define BME280_BUS_WRITE_PAIRS_FUNC(bus, device_addr, register_pairs,\
+		pairs_cnt)sensor_bus_write(bus, device_addr, register_pairs,\
+		2 * (pairs_cnt))
 /****************************************/
 /**\name	DELAY       */
 /****************************************/
-/* defines the return parameter type of the BME280_DELAY_FUNCTION
-*/
-#define BME280_DELAY_RETURN_TYPE void
-
-/* defines the calling parameter types of the BME280_DELAY_FUNCTION
-*/
-#define BME280_DELAY_PARAM_TYPES u16
+#define BME280_DELAY_FUNC(bus, delay_in_msec)\
+		sensor_bus_delay(bus, (delay_in_msec) * 1000)
 /***************************************************************/
 /**\name	GET AND SET BITSLICE FUNCTIONS       */
 /***************************************************************/
-/* never change this line */
-#define BME280_DELAY_FUNC(delay_in_msec)\
-		delay_func(delay_in_msec)
-
 #define BME280_GET_BITSLICE(regvar, bitname)\
 		((regvar & bitname##__MSK) >> bitname##__POS)
 
@@ -464,11 +393,14 @@ BME280_BUS_RD_PARAM_TYPE to function calls used inside the API
 /* numeric definitions */
 #define	BME280_PRESSURE_TEMPERATURE_CALIB_DATA_LENGTH	    (26)
 #define	BME280_HUMIDITY_CALIB_DATA_LENGTH	    (7)
+#define	BME280_TEMPERATURE_CALIB_DATA_LENGTH	    (6)
 #define	BME280_GEN_READ_WRITE_DATA_LENGTH		(1)
 #define	BME280_HUMIDITY_DATA_LENGTH				(2)
 #define	BME280_TEMPERATURE_DATA_LENGTH			(3)
 #define	BME280_PRESSURE_DATA_LENGTH				(3)
 #define	BME280_ALL_DATA_FRAME_LENGTH			(8)
+#define	BME280_SETTINGS_DATA_LENGTH				(4)
+#define	BME280_SETTINGS_PAIRS_LENGTH			(4)
 #define	BME280_INIT_VALUE						(0)
 #define	BME280_INVALID_DATA						(0)
 
@@ -492,6 +424,22 @@ BME280_BUS_RD_PARAM_TYPE to function calls used inside the API
 #define BME280_SLEEP_MODE                    (0x00)
 #define BME280_FORCED_MODE                   (0x01)
 #define BME280_NORMAL_MODE                   (0x03)
+/****************************************************/
+/**\name	FORCED MODE WAIT DEFINITIONS  */
+/***************************************************/
+#define BME280_FORCED_WAIT_FIXED             (0x00)
+#define BME280_FORCED_WAIT_POLL              (0x01)
+/****************************************************/
+/**\name	COMPENSATION BACKEND DEFINITIONS  */
+/***************************************************/
+#define BME280_COMPENSATION_INT32            (0x00)
+#define BME280_COMPENSATION_INT64            (0x01)
+#define BME280_COMPENSATION_DOUBLE           (0x02)
+/* backend a device starts with, set at build time
+   with -DBME280_COMPENSATION_DEFAULT=... */
+#ifndef BME280_COMPENSATION_DEFAULT
+#define BME280_COMPENSATION_DEFAULT          BME280_COMPENSATION_INT32
+#endif
 #define BME280_SOFT_RESET_CODE               (0xB6)
 /****************************************************/
 /**\name	STANDBY DEFINITIONS  */
@@ -559,6 +507,19 @@ BME280_BUS_RD_PARAM_TYPE to function calls used inside the API
 
 #define T_SETUP_HUMIDITY_MAX                   (10)
 /* 10/16 = 0.625 ms */
+
+#define T_INIT_TYP                             (16)
+/* 16/16 = 1 ms */
+#define T_MEASURE_PER_OSRS_TYP                 (32)
+/* 32/16 = 2 ms */
+#define T_SETUP_PRESSURE_TYP                   (8)
+/* 8/16 = 0.5 ms */
+#define T_SETUP_HUMIDITY_TYP                   (8)
+/* 8/16 = 0.5 ms */
+
+#define BME280_STATUS_POLL_INTERVAL_US         (500)
+/* start-up is 2 ms max, the NVM copy is part of it */
+#define BME280_NVM_COPY_TIMEOUT_US             (10000)
 /****************************************************/
 /**\name	DEFINITIONS FOR ARRAY SIZE OF DATA   */
 /***************************************************/
@@ -566,6 +527,8 @@ BME280_BUS_RD_PARAM_TYPE to function calls used inside the API
 #define	BME280_TEMPERATURE_DATA_SIZE	(3)
 #define	BME280_PRESSURE_DATA_SIZE		(3)
 #define	BME280_DATA_FRAME_SIZE			(8)
+#define	BME280_SETTINGS_DATA_SIZE		(4)
+#define	BME280_SETTINGS_PAIRS_SIZE		(8)
 /**< data frames includes temperature,
 pressure and humidity*/
 #define	BME280_CALIB_DATA_SIZE			(26)
@@ -587,6 +550,11 @@ pressure and humidity*/
 #define	BME280_DATA_FRAME_TEMPERATURE_XLSB_BYTE	(5)
 #define	BME280_DATA_FRAME_HUMIDITY_MSB_BYTE		(6)
 #define	BME280_DATA_FRAME_HUMIDITY_LSB_BYTE		(7)
+
+#define	BME280_SETTINGS_CTRL_HUMIDITY_BYTE		(0)
+#define	BME280_SETTINGS_STATUS_BYTE				(1)
+#define	BME280_SETTINGS_CTRL_MEAS_BYTE			(2)
+#define	BME280_SETTINGS_CONFIG_BYTE				(3)
 /****************************************************/
 /**\name	ARRAY PARAMETER FOR CALIBRATION     */
 /***************************************************/
@@ -670,6 +638,7 @@ pressure and humidity*/
 #define BME280_CTRL_MEAS_REG                 (0xF4)  /*Ctrl Measure Register */
 #define BME280_CTRL_HUMIDITY_REG             (0xF2)  /*Ctrl Humidity Register*/
 #define BME280_CONFIG_REG                    (0xF5)  /*Configuration Register */
+#define BME280_CONFIG_REG_MSK                (0xFD)  /*bit 1 is reserved */
 #define BME280_PRESSURE_MSB_REG              (0xF7)  /*Pressure MSB Register */
 #define BME280_PRESSURE_LSB_REG              (0xF8)  /*Pressure LSB Register */
 #define BME280_PRESSURE_XLSB_REG             (0xF9)  /*Pressure XLSB Register */
@@ -767,17 +736,6 @@ FOR PRESSURE AND TEMPERATURE DATA  */
 #define BME280_TEMPERATURE_XLSB_REG_DATA__MSK      (0xF0)
 #define BME280_TEMPERATURE_XLSB_REG_DATA__LEN      (4)
 #define BME280_TEMPERATURE_XLSB_REG_DATA__REG      (BME280_TEMPERATURE_XLSB_REG)
-/****************************************************/
-/**\name	BUS READ AND WRITE FUNCTION POINTERS */
-/***************************************************/
-#define BME280_WR_FUNC_PTR\
-		s8 (*bus_write)(u8, u8,\
-		u8 *, u8)
-
-#define BME280_RD_FUNC_PTR\
-		s8 (*bus_read)(u8, u8,\
-		u8 *, u8)
-
 #define BME280_MDELAY_DATA_TYPE u16
 
 #define	BME280_3MS_DELAY	3
@@ -810,12 +768,42 @@ struct bme280_calibration_param_t {
 
     s32 t_fine;/**<calibration T_FINE data*/
 };
+/*!
+ * @brief This structure holds the compensation terms derived
+ *	from the calibration parameters by bme280_compute_coefficients.
+ *	The stage terms depend on t_fine only and are kept
+ *	for as long as t_fine does not change, each backend builds
+ *	its own stage when it needs it
+ */
+struct bme280_coefficients_t {
+    s32 t1;/**<dig_T1*/
+    s32 t1_x2;/**<dig_T1 << 1*/
+    s32 p4_16;/**<dig_P4 << 16*/
+    s32 h4_20;/**<dig_H4 << 20*/
+
+    u8 p_valid;/**<p_x1 and p_x2 are for p_t_fine*/
+    s32 p_t_fine;/**<t_fine the pressure stage is for*/
+    s32 p_x1;/**<pressure divisor*/
+    s32 p_x2;/**<pressure offset, already shifted by 12*/
+    u8 h_valid;/**<h_h5 and h_scale are for h_t_fine*/
+    s32 h_t_fine;/**<t_fine the humidity stage is for*/
+    s32 h_h5;/**<dig_H5 * (t_fine - 76800)*/
+    s32 h_scale;/**<humidity factor from dig_H2, dig_H3 and dig_H6*/
+#if defined(BME280_ENABLE_INT64) && defined(BME280_64BITSUPPORT_PRESENT)
+    u8 p64_valid;/**<p64_x1 and p64_x2 are for p64_t_fine*/
+    s32 p64_t_fine;/**<t_fine the 64 bit pressure stage is for*/
+    s64 p64_x1;/**<64 bit pressure divisor*/
+    s64 p64_x2;/**<64 bit pressure offset*/
+#endif
+};
 /*!
  * @brief This structure holds BME280 initialization parameters
  */
 struct bme280_t {
     struct bme280_calibration_param_t cal_param;
     /**< calibration parameters*/
+    struct bme280_coefficients_t coef;
+    /**< terms derived from cal_param*/
 
     u8 chip_id;/**< chip id of the sensor*/
     u8 dev_addr;/**< device address of the sensor*/
@@ -827,13 +815,19 @@ struct bme280_t {
     u8 ctrl_meas_reg;/**< status of control measurement register*/
     u8 config_reg;/**< status of configuration register*/
 
-    BME280_WR_FUNC_PTR;/**< bus write function pointer*/
-    BME280_RD_FUNC_PTR;/**< bus read function pointer*/
-    void (*delay_msec)(BME280_MDELAY_DATA_TYPE);/**< delay function pointer*/
+    struct sensor_bus_t *bus;/**< bus the sensor is attached to*/
+    u8 forced_wait;/**< how forced mode waits for the conversion*/
+    u8 compensation;/**< compensation backend*/
 };
 /**************************************************************/
 /**\name	FUNCTION DECLARATIONS                         */
 /**************************************************************/
+/*!
+ * @note Every API takes the device it works on, p_bme280, as the
+ * first parameter; the driver keeps no state of its own, so any
+ * number of sensors can be driven from as many threads, one
+ * thread per device at a time.
+ */
 /**************************************************************/
 /**\name	FUNCTION FOR  INTIALIZATION                       */
 /**************************************************************/
@@ -843,7 +837,7 @@ struct bme280_t {
  *  and assign the chip id and I2C address of the BME280 sensor
  *	chip id is read in the register 0xD0 bit from 0 to 7
  *
- *	 @param bme280 structure pointer.
+ *	 @param p_bme280 structure pointer.
  *
  *	@note While changing the parameter of the bme280_t
  *	@note consider the following point:
@@ -862,7 +856,30 @@ struct bme280_t {
  *
  *
 */
-BME280_RETURN_FUNCTION_TYPE bme280_init(struct bme280_t *bme280);
+BME280_RETURN_FUNCTION_TYPE bme280_init(struct bme280_t *p_bme280);
+/*!
+ *	@brief This function is used for initialize the sensor
+ *	with trimming parameters saved earlier
+ *
+ *	The saved parameters are used when the chip id matches
+ *	and dig_T1 to dig_T3, read in one transaction, are the
+ *	same as in the chip, else the full set is read.
+ *
+ *	@param p_bme280 structure pointer.
+ *	@param v_chip_id_u8 : chip id the parameters were saved for
+ *	@param v_cal : saved parameters, BME280_NULL for none
+ *	@param v_cached_u8 : 1 when the saved parameters were used
+ *
+ *
+ *	@return results of bus communication function
+ *	@retval 0 -> Success
+ *	@retval -1 -> Error
+ *
+ *
+*/
+BME280_RETURN_FUNCTION_TYPE bme280_init_cached(struct bme280_t *p_bme280,
+        u8 v_chip_id_u8, const struct bme280_calibration_param_t *v_cal,
+        u8 *v_cached_u8);
 /**************************************************************/
 /**\name	FUNCTION FOR  INTIALIZATION UNCOMPENSATED TEMPERATURE */
 /**************************************************************/
@@ -884,6 +901,7 @@ BME280_RETURN_FUNCTION_TYPE bme280_init(struct bme280_t *bme280);
  *
 */
 BME280_RETURN_FUNCTION_TYPE bme280_read_uncomp_temperature(
+    struct bme280_t *p_bme280,
     s32 *v_uncomp_temperature_s32);
 /**************************************************************/
 /**\name	FUNCTION FOR  INTIALIZATION TRUE TEMPERATURE */
@@ -901,7 +919,7 @@ BME280_RETURN_FUNCTION_TYPE bme280_read_uncomp_temperature(
  *  @return Returns the actual temperature
  *
 */
-s32 bme280_compensate_temperature_int32(s32 v_uncomp_temperature_s32);
+s32 bme280_compensate_temperature_int32(struct bme280_t *p_bme280, s32 v_uncomp_temperature_s32);
 /*!
  * @brief Reads actual temperature from uncompensated temperature
  * @note Returns the value with 500LSB/DegC centred around 24 DegC
@@ -916,6 +934,7 @@ s32 bme280_compensate_temperature_int32(s32 v_uncomp_temperature_s32);
  *
 */
 s16 bme280_compensate_temperature_int32_sixteen_bit_output(
+    struct bme280_t *p_bme280,
     s32 v_uncomp_temperature_s32);
 /**************************************************************/
 /**\name	FUNCTION FOR  INTIALIZATION UNCOMPENSATED PRESSURE */
@@ -940,6 +959,7 @@ s16 bme280_compensate_temperature_int32_sixteen_bit_output(
  *
 */
 BME280_RETURN_FUNCTION_TYPE bme280_read_uncomp_pressure(
+    struct bme280_t *p_bme280,
     s32 *v_uncomp_pressure_s32);
 /**************************************************************/
 /**\name	FUNCTION FOR  INTIALIZATION TRUE PRESSURE */
@@ -959,7 +979,7 @@ BME280_RETURN_FUNCTION_TYPE bme280_read_uncomp_pressure(
  *  @return Return the actual pressure output as u32
  *
 */
-u32 bme280_compensate_pressure_int32(s32 v_uncomp_pressure_s32);
+u32 bme280_compensate_pressure_int32(struct bme280_t *p_bme280, s32 v_uncomp_pressure_s32);
 /**************************************************************/
 /**\name	FUNCTION FOR  INTIALIZATION UNCOMPENSATED HUMIDITY */
 /**************************************************************/
@@ -982,6 +1002,7 @@ u32 bme280_compensate_pressure_int32(s32 v_uncomp_pressure_s32);
  *
 */
 BME280_RETURN_FUNCTION_TYPE bme280_read_uncomp_humidity(
+    struct bme280_t *p_bme280,
     s32 *v_uncomp_humidity_s32);
 /**************************************************************/
 /**\name	FUNCTION FOR  INTIALIZATION RELATIVE HUMIDITY */
@@ -1000,7 +1021,7 @@ BME280_RETURN_FUNCTION_TYPE bme280_read_uncomp_humidity(
  *  @return Return the actual relative humidity output as u32
  *
 */
-u32 bme280_compensate_humidity_int32(s32 v_uncomp_humidity_s32);
+u32 bme280_compensate_humidity_int32(struct bme280_t *p_bme280, s32 v_uncomp_humidity_s32);
 /*!
  * @brief Reads actual humidity from uncompensated humidity
  * @note Returns the value in %rH as unsigned 16bit integer
@@ -1016,6 +1037,7 @@ u32 bme280_compensate_humidity_int32(s32 v_uncomp_humidity_s32);
  *
 */
 u16 bme280_compensate_humidity_int32_sixteen_bit_output(
+    struct bme280_t *p_bme280,
     s32 v_uncomp_humidity_s32);
 /**************************************************************/
 /**\name	FUNCTION FOR  INTIALIZATION UNCOMPENSATED PRESSURE,
@@ -1041,8 +1063,41 @@ u16 bme280_compensate_humidity_int32_sixteen_bit_output(
  *
 */
 BME280_RETURN_FUNCTION_TYPE bme280_read_uncomp_pressure_temperature_humidity(
+    struct bme280_t *p_bme280,
     s32 *v_uncomp_pressure_s32,
     s32 *v_uncomp_temperature_s32, s32 *v_uncomp_humidity_s32);
+/*!
+ * @brief This API is used to read the raw data frame, pressure,
+ *	temperature and humidity registers 0xF7 to 0xFE, as they are
+ *
+ *
+ *  @param  v_frame_u8: BME280_DATA_FRAME_SIZE bytes for the frame
+ *
+ *
+ *
+ *	@return results of bus communication function
+ *	@retval 0 -> Success
+ *	@retval -1 -> Error
+ *
+ *
+*/
+BME280_RETURN_FUNCTION_TYPE bme280_read_data_frame(
+    struct bme280_t *p_bme280, u8 *v_frame_u8);
+/*!
+ * @brief This API is used to take the uncompensated pressure,
+ *	temperature and humidity out of a raw data frame
+ *
+ *
+ *  @param  v_frame_u8: the BME280_DATA_FRAME_SIZE bytes of 0xF7 to 0xFE
+ *  @param  v_uncomp_pressure_s32: The value of uncompensated pressure.
+ *  @param  v_uncomp_temperature_s32: The value of uncompensated temperature
+ *  @param  v_uncomp_humidity_s32: The value of uncompensated humidity.
+ *
+ *
+*/
+void bme280_decode_data_frame(const u8 *v_frame_u8,
+                              s32 *v_uncomp_pressure_s32,
+                              s32 *v_uncomp_temperature_s32, s32 *v_uncomp_humidity_s32);
 /**************************************************************/
 /**\name	FUNCTION FOR TRUE UNCOMPENSATED PRESSURE,
  TEMPERATURE AND HUMIDITY */
@@ -1065,7 +1120,50 @@ BME280_RETURN_FUNCTION_TYPE bme280_read_uncomp_pressure_temperature_humidity(
  *
 */
 BME280_RETURN_FUNCTION_TYPE bme280_read_pressure_temperature_humidity(
+    struct bme280_t *p_bme280,
     u32 *v_pressure_u32, s32 *v_temperature_s32, u32 *v_humidity_u32);
+/*!
+ * @brief This API is used to compensate one frame of uncompensated
+ *	pressure, temperature and humidity with the backend chosen by
+ *	bme280_set_compensation
+ *
+ *	@note The results are in the units of the int32 backend
+ *	whatever the backend: pressure in Pa, temperature in
+ *	0.01 DegC and humidity in 1/1024 %rH, rounded to nearest
+ *
+ *	@param  v_uncomp_pressure_s32: The value of uncompensated pressure.
+ *	@param  v_uncomp_temperature_s32: The value of uncompensated temperature
+ *	@param  v_uncomp_humidity_s32: The value of uncompensated humidity.
+ *	@param  v_pressure_u32 : The value of compensated pressure.
+ *	@param  v_temperature_s32 : The value of compensated temperature.
+ *	@param  v_humidity_u32 : The value of compensated humidity.
+ *
+ *
+*/
+void bme280_compensate_pressure_temperature_humidity(
+    struct bme280_t *p_bme280,
+    s32 v_uncomp_pressure_s32, s32 v_uncomp_temperature_s32,
+    s32 v_uncomp_humidity_s32,
+    u32 *v_pressure_u32, s32 *v_temperature_s32, u32 *v_humidity_u32);
+/*!
+ * @brief This API is used to choose the compensation backend
+ *
+ *	@param v_compensation_u8 : the backend
+ *  value   |   backend
+ * ---------|----------------------------
+ *  0x00    | BME280_COMPENSATION_INT32
+ *  0x01    | BME280_COMPENSATION_INT64
+ *  0x02    | BME280_COMPENSATION_DOUBLE
+ *
+ *	@return results of the selection
+ *	@retval 0 -> Success
+ *	@retval -1 -> Error, the backend is not built in, see
+ *	BME280_ENABLE_INT64 and BME280_ENABLE_FLOAT
+ *
+ *
+*/
+BME280_RETURN_FUNCTION_TYPE bme280_set_compensation(struct bme280_t *p_bme280,
+        u8 v_compensation_u8);
 /**************************************************************/
 /**\name	FUNCTION FOR CALIBRATION */
 /**************************************************************/
@@ -1097,7 +1195,20 @@ BME280_RETURN_FUNCTION_TYPE bme280_read_pressure_temperature_humidity(
  *
  *
 */
-BME280_RETURN_FUNCTION_TYPE bme280_get_calib_param(void);
+BME280_RETURN_FUNCTION_TYPE bme280_get_calib_param(struct bme280_t *p_bme280);
+/*!
+ *	@brief This API derives the compensation terms of
+ *	p_bme280->coef from p_bme280->cal_param, it has to be
+ *	called whenever cal_param changes. bme280_get_calib_param
+ *	and bme280_init_cached call it
+ *
+ *	@note The integer compensation functions give the same
+ *	results as the datasheet formulas, only the work that depends
+ *	on the calibration or on t_fine alone is not redone per sample
+ *
+ *
+*/
+void bme280_compute_coefficients(struct bme280_t *p_bme280);
 /**************************************************************/
 /**\name	FUNCTION FOR TEMPERATURE OVER SAMPLING */
 /**************************************************************/
@@ -1127,6 +1238,7 @@ BME280_RETURN_FUNCTION_TYPE bme280_get_calib_param(void);
  *
 */
 BME280_RETURN_FUNCTION_TYPE bme280_get_oversamp_temperature(
+    struct bme280_t *p_bme280,
     u8 *v_value_u8);
 /*!
  *	@brief This API is used to set
@@ -1154,6 +1266,7 @@ BME280_RETURN_FUNCTION_TYPE bme280_get_oversamp_temperature(
  *
 */
 BME280_RETURN_FUNCTION_TYPE bme280_set_oversamp_temperature(
+    struct bme280_t *p_bme280,
     u8 v_value_u8);
 /**************************************************************/
 /**\name	FUNCTION FOR PRESSURE OVER SAMPLING */
@@ -1184,6 +1297,7 @@ BME280_RETURN_FUNCTION_TYPE bme280_set_oversamp_temperature(
  *
 */
 BME280_RETURN_FUNCTION_TYPE bme280_get_oversamp_pressure(
+    struct bme280_t *p_bme280,
     u8 *v_value_u8);
 /*!
  *	@brief This API is used to set
@@ -1211,6 +1325,7 @@ BME280_RETURN_FUNCTION_TYPE bme280_get_oversamp_pressure(
  *
 */
 BME280_RETURN_FUNCTION_TYPE bme280_set_oversamp_pressure(
+    struct bme280_t *p_bme280,
     u8 v_value_u8);
 /**************************************************************/
 /**\name	FUNCTION FOR HUMIDITY OVER SAMPLING */
@@ -1240,7 +1355,7 @@ BME280_RETURN_FUNCTION_TYPE bme280_set_oversamp_pressure(
  *
  *
 */
-BME280_RETURN_FUNCTION_TYPE bme280_get_oversamp_humidity(u8 *v_value_u8);
+BME280_RETURN_FUNCTION_TYPE bme280_get_oversamp_humidity(struct bme280_t *p_bme280, u8 *v_value_u8);
 /*!
  *	@brief This API is used to set
  *	the humidity oversampling setting in the register 0xF2
@@ -1281,6 +1396,7 @@ BME280_RETURN_FUNCTION_TYPE bme280_get_oversamp_humidity(u8 *v_value_u8);
  *
 */
 BME280_RETURN_FUNCTION_TYPE bme280_set_oversamp_humidity(
+    struct bme280_t *p_bme280,
     u8 v_value_u8);
 /**************************************************************/
 /**\name	FUNCTION FOR POWER MODE*/
@@ -1304,7 +1420,7 @@ BME280_RETURN_FUNCTION_TYPE bme280_set_oversamp_humidity(
  *
  *
 */
-BME280_RETURN_FUNCTION_TYPE bme280_get_power_mode(u8 *v_power_mode_u8);
+BME280_RETURN_FUNCTION_TYPE bme280_get_power_mode(struct bme280_t *p_bme280, u8 *v_power_mode_u8);
 /*!
  *	@brief This API used to set the
  *	Operational Mode from the sensor in the register 0xF4 bit 0 and 1
@@ -1324,7 +1440,7 @@ BME280_RETURN_FUNCTION_TYPE bme280_get_power_mode(u8 *v_power_mode_u8);
  *
  *
 */
-BME280_RETURN_FUNCTION_TYPE bme280_set_power_mode(u8 v_power_mode_u8);
+BME280_RETURN_FUNCTION_TYPE bme280_set_power_mode(struct bme280_t *p_bme280, u8 v_power_mode_u8);
 /**************************************************************/
 /**\name	FUNCTION FOR SOFT RESET*/
 /**************************************************************/
@@ -1343,7 +1459,7 @@ BME280_RETURN_FUNCTION_TYPE bme280_set_power_mode(u8 v_power_mode_u8);
  *
  *
 */
-BME280_RETURN_FUNCTION_TYPE bme280_set_soft_rst(void);
+BME280_RETURN_FUNCTION_TYPE bme280_set_soft_rst(struct bme280_t *p_bme280);
 /**************************************************************/
 /**\name	FUNCTION FOR SPI ENABLE*/
 /**************************************************************/
@@ -1367,7 +1483,7 @@ BME280_RETURN_FUNCTION_TYPE bme280_set_soft_rst(void);
  *
  *
 */
-BME280_RETURN_FUNCTION_TYPE bme280_get_spi3(u8 *v_enable_disable_u8);
+BME280_RETURN_FUNCTION_TYPE bme280_get_spi3(struct bme280_t *p_bme280, u8 *v_enable_disable_u8);
 /*!
  *	@brief This API used to set the sensor
  *	SPI mode(communication type) in the register 0xF5 bit 0
@@ -1388,7 +1504,7 @@ BME280_RETURN_FUNCTION_TYPE bme280_get_spi3(u8 *v_enable_disable_u8);
  *
  *
 */
-BME280_RETURN_FUNCTION_TYPE bme280_set_spi3(u8 v_enable_disable_u8);
+BME280_RETURN_FUNCTION_TYPE bme280_set_spi3(struct bme280_t *p_bme280, u8 v_enable_disable_u8);
 /**************************************************************/
 /**\name	FUNCTION FOR IIR FILTER*/
 /**************************************************************/
@@ -1414,7 +1530,7 @@ BME280_RETURN_FUNCTION_TYPE bme280_set_spi3(u8 v_enable_disable_u8);
  *
  *
 */
-BME280_RETURN_FUNCTION_TYPE bme280_get_filter(u8 *v_value_u8);
+BME280_RETURN_FUNCTION_TYPE bme280_get_filter(struct bme280_t *p_bme280, u8 *v_value_u8);
 /*!
  *	@brief This API is used to write filter setting
  *	in the register 0xF5 bit 3 and 4
@@ -1437,7 +1553,7 @@ BME280_RETURN_FUNCTION_TYPE bme280_get_filter(u8 *v_value_u8);
  *
  *
 */
-BME280_RETURN_FUNCTION_TYPE bme280_set_filter(u8 v_value_u8);
+BME280_RETURN_FUNCTION_TYPE bme280_set_filter(struct bme280_t *p_bme280, u8 v_value_u8);
 /**************************************************************/
 /**\name	FUNCTION FOR STANDBY DURATION*/
 /**************************************************************/
@@ -1464,7 +1580,7 @@ BME280_RETURN_FUNCTION_TYPE bme280_set_filter(u8 v_value_u8);
  *
  *
 */
-BME280_RETURN_FUNCTION_TYPE bme280_get_standby_durn(u8 *v_standby_durn_u8);
+BME280_RETURN_FUNCTION_TYPE bme280_get_standby_durn(struct bme280_t *p_bme280, u8 *v_standby_durn_u8);
 /*!
  *	@brief This API used to write the
  *	standby duration time from the sensor in the register 0xF5 bit 5 to 7
@@ -1488,7 +1604,7 @@ BME280_RETURN_FUNCTION_TYPE bme280_get_standby_durn(u8 *v_standby_durn_u8);
  *	the contents of the register t_sb.
  *	Standby time can be set using BME280_STANDBY_TIME_125_MS.
  *
- *	@note Usage Hint : bme280_set_standby_durn(BME280_STANDBY_TIME_125_MS)
+ *	@note Usage Hint : bme280_set_standby_durn(p_bme280, BME280_STANDBY_TIME_125_MS)
  *
  *
  *
@@ -1498,7 +1614,7 @@ BME280_RETURN_FUNCTION_TYPE bme280_get_standby_durn(u8 *v_standby_durn_u8);
  *
  *
 */
-BME280_RETURN_FUNCTION_TYPE bme280_set_standby_durn(u8 v_standby_durn_u8);
+BME280_RETURN_FUNCTION_TYPE bme280_set_standby_durn(struct bme280_t *p_bme280, u8 v_standby_durn_u8);
 /**************************************************************/
 /**\name	FUNCTION FOR WORK MODE*/
 /**************************************************************/
@@ -1523,7 +1639,7 @@ BME280_RETURN_FUNCTION_TYPE bme280_set_standby_durn(u8 v_standby_durn_u8);
  *
  *
 */
-/*BME280_RETURN_FUNCTION_TYPE bme280_set_work_mode(u8 v_work_mode_u8);*/
+/*BME280_RETURN_FUNCTION_TYPE bme280_set_work_mode(struct bme280_t *p_bme280, u8 v_work_mode_u8);*/
 /**************************************************************/
 /**\name	FUNCTION FOR FORCE MODE DATA READ*/
 /**************************************************************/
@@ -1545,8 +1661,83 @@ BME280_RETURN_FUNCTION_TYPE bme280_set_standby_durn(u8 v_standby_durn_u8);
 */
 BME280_RETURN_FUNCTION_TYPE
 bme280_get_forced_uncomp_pressure_temperature_humidity(
+    struct bme280_t *p_bme280,
     s32 *v_uncom_pressure_s32,
     s32 *v_uncom_temperature_s32, s32 *v_uncom_humidity_s32);
+/*!
+ * @brief This API is used to start one conversion in forced
+ *	mode and read the raw data frame, registers 0xF7 to 0xFE,
+ *	as soon as the conversion is complete
+ *
+ *	@note The wait is selected by the forced_wait member
+ *
+ *	@param  v_frame_u8: BME280_DATA_FRAME_SIZE bytes for the frame
+ *
+ *
+ *	@return results of bus communication function
+ *	@retval 0 -> Success
+ *	@retval -1 -> Error
+ *
+ *
+*/
+BME280_RETURN_FUNCTION_TYPE
+bme280_get_forced_data_frame(struct bme280_t *p_bme280, u8 *v_frame_u8);
+/*!
+ * @brief This API is used to start one conversion in forced
+ *	mode and read the true pressure, temperature and humidity
+ *	as soon as the conversion is complete
+ *
+ *	@note The wait is selected by the forced_wait member
+ *	@note BME280_FORCED_WAIT_FIXED -> bme280_compute_wait_time
+ *	@note BME280_FORCED_WAIT_POLL -> measuring bit of 0xF3
+ *
+ *	@param  v_pressure_u32 : The value of compensated pressure.
+ *	@param  v_temperature_s32 : The value of compensated temperature.
+ *	@param  v_humidity_u32 : The value of compensated humidity.
+ *
+ *
+ *	@return results of bus communication function
+ *	@retval 0 -> Success
+ *	@retval -1 -> Error
+ *
+ *
+*/
+BME280_RETURN_FUNCTION_TYPE
+bme280_get_forced_pressure_temperature_humidity(
+    struct bme280_t *p_bme280,
+    u32 *v_pressure_u32, s32 *v_temperature_s32, u32 *v_humidity_u32);
+/*!
+ * @brief This API is used to wait for the end of a conversion,
+ *	it sleeps the typical conversion time and then polls
+ *	the measuring bit of the status register 0xF3
+ *
+ *
+ *	@return results of bus communication function
+ *	@retval 0 -> Success
+ *	@retval -1 -> Error, also when the conversion outlasts
+ *	the maximum time given by bme280_compute_wait_time
+ *
+ *
+*/
+BME280_RETURN_FUNCTION_TYPE bme280_wait_for_conversion(struct bme280_t *p_bme280);
+/*!
+ * @brief This API is used to poll the status register 0xF3
+ *	until all the bits of the given mask are clear
+ *
+ *
+ *	@param v_mask_u8 : BME280_STAT_REG_MEASURING__MSK and/or
+ *	BME280_STAT_REG_IM_UPDATE__MSK
+ *	@param v_timeout_u32 : give up after this many microseconds
+ *
+ *
+ *	@return results of bus communication function
+ *	@retval 0 -> Success
+ *	@retval -1 -> Error or timeout
+ *
+ *
+*/
+BME280_RETURN_FUNCTION_TYPE bme280_poll_status(struct bme280_t *p_bme280, u8 v_mask_u8,
+        u32 v_timeout_u32);
 /**************************************************************/
 /**\name	FUNCTION FOR COMMON READ AND WRITE */
 /**************************************************************/
@@ -1567,7 +1758,7 @@ bme280_get_forced_uncomp_pressure_temperature_humidity(
  *
  *
  */
-BME280_RETURN_FUNCTION_TYPE bme280_write_register(u8 v_addr_u8,
+BME280_RETURN_FUNCTION_TYPE bme280_write_register(struct bme280_t *p_bme280, u8 v_addr_u8,
         u8 *v_data_u8, u8 v_len_u8);
 /*!
  * @brief
@@ -1586,8 +1777,109 @@ BME280_RETURN_FUNCTION_TYPE bme280_write_register(u8 v_addr_u8,
  *
  *
  */
-BME280_RETURN_FUNCTION_TYPE bme280_read_register(u8 v_addr_u8,
+BME280_RETURN_FUNCTION_TYPE bme280_read_register(struct bme280_t *p_bme280, u8 v_addr_u8,
         u8 *v_data_u8, u8 v_len_u8);
+/*!
+ * @brief
+ *	This API writes a run of (register, value) pairs
+ *	in a single bus transaction
+ *
+ *
+ *	@param v_pairs_u8 -> Register addresses and data, interleaved
+ *	@param v_cnt_u8 -> no of pairs to write
+ *
+ *
+ *	@return results of bus communication function
+ *	@retval 0 -> Success
+ *	@retval -1 -> Error
+ *
+ *
+ */
+BME280_RETURN_FUNCTION_TYPE bme280_write_register_pairs(struct bme280_t *p_bme280, u8 *v_pairs_u8,
+        u8 v_cnt_u8);
+/**************************************************************/
+/**\name	FUNCTION FOR SETTINGS IN ONE TRANSACTION */
+/**************************************************************/
+/*!
+ * @brief
+ *	This API writes the control humidity, control measurement
+ *	and configuration registers in a single bus transaction
+ *
+ *	@note The control measurement register is first written
+ *	with the sleep mode, since writes to the configuration
+ *	register may be ignored in normal mode. The humidity
+ *	setting becomes effective with the final control
+ *	measurement write. No soft reset is needed.
+ *
+ *	@param v_ctrl_hum_u8 -> The value of control humidity register
+ *	@param v_ctrl_meas_u8 -> The value of control measurement register
+ *	@param v_config_u8 -> The value of configuration register
+ *
+ *
+ *	@return results of bus communication function
+ *	@retval 0 -> Success
+ *	@retval -1 -> Error
+ *
+ *
+ */
+BME280_RETURN_FUNCTION_TYPE bme280_write_settings(struct bme280_t *p_bme280, u8 v_ctrl_hum_u8,
+        u8 v_ctrl_meas_u8, u8 v_config_u8);
+/*!
+ * @brief
+ *	This API writes the control humidity, control measurement
+ *	and configuration registers in a single bus transaction and,
+ *	when that succeeds, takes the written values as the stored
+ *	copies, no read back needed
+ *
+ *	@note A forced mode conversion ends in sleep mode, that is
+ *	what gets stored for it
+ *
+ *	@param v_ctrl_hum_u8 -> Value of the control humidity register
+ *	@param v_ctrl_meas_u8 -> Value of the control measurement register
+ *	@param v_config_u8 -> Value of the configuration register
+ *
+ *
+ *	@return results of bus communication function
+ *	@retval 0 -> Success
+ *	@retval -1 -> Error
+ *
+ *
+ */
+BME280_RETURN_FUNCTION_TYPE bme280_apply_settings(struct bme280_t *p_bme280, u8 v_ctrl_hum_u8,
+        u8 v_ctrl_meas_u8, u8 v_config_u8);
+/*!
+ * @brief
+ *	This API reads the control registers (0xF2 to 0xF5) in
+ *	a single bus transaction and compares them with the
+ *	stored copies, on a mismatch the stored copies are
+ *	written to the chip again
+ *
+ *
+ *	@param v_mismatch_u8 -> 1 when the chip had to be resynced
+ *
+ *
+ *	@return results of bus communication function
+ *	@retval 0 -> Success
+ *	@retval -1 -> Error
+ *
+ *
+ */
+BME280_RETURN_FUNCTION_TYPE bme280_verify_settings(struct bme280_t *p_bme280, u8 *v_mismatch_u8);
+/*!
+ * @brief
+ *	This API reads the control humidity, status, control
+ *	measurement and configuration registers (0xF2 to 0xF5)
+ *	in a single bus transaction and updates the stored copies
+ *	and the oversampling settings
+ *
+ *
+ *	@return results of bus communication function
+ *	@retval 0 -> Success
+ *	@retval -1 -> Error
+ *
+ *
+ */
+BME280_RETURN_FUNCTION_TYPE bme280_read_settings(struct bme280_t *p_bme280);
 /**************************************************************/
 /**\name	FUNCTION FOR FLOAT OUTPUT TEMPERATURE*/
 /**************************************************************/
@@ -1607,6 +1899,7 @@ BME280_RETURN_FUNCTION_TYPE bme280_read_register(u8 v_addr_u8,
  *
 */
 double bme280_compensate_temperature_double(
+    struct bme280_t *p_bme280,
     s32 v_uncom_temperature_s32);
 /**************************************************************/
 /**\name	FUNCTION FOR FLOAT OUTPUT PRESSURE*/
@@ -1624,7 +1917,7 @@ double bme280_compensate_temperature_double(
  *  @return  Return the actual pressure in floating point
  *
 */
-double bme280_compensate_pressure_double(s32 v_uncom_pressure_s32);
+double bme280_compensate_pressure_double(struct bme280_t *p_bme280, s32 v_uncom_pressure_s32);
 /**************************************************************/
 /**\name	FUNCTION FOR FLOAT OUTPUT HUMIDITY*/
 /**************************************************************/
@@ -1640,7 +1933,7 @@ double bme280_compensate_pressure_double(s32 v_uncom_pressure_s32);
  *  @return Return the actual humidity in floating point
  *
 */
-double bme280_compensate_humidity_double(s32 v_uncom_humidity_s32);
+double bme280_compensate_humidity_double(struct bme280_t *p_bme280, s32 v_uncom_humidity_s32);
 #endif
 /**************************************************************/
 /**\name	FUNCTION FOR 64BIT OUTPUT PRESSURE*/
@@ -1662,7 +1955,7 @@ double bme280_compensate_humidity_double(s32 v_uncom_humidity_s32);
  *  @return Return the actual pressure in u32
  *
 */
-u32 bme280_compensate_pressure_int64(s32 v_uncom_pressure_s32);
+u32 bme280_compensate_pressure_int64(struct bme280_t *p_bme280, s32 v_uncom_pressure_s32);
 /**************************************************************/
 /**\name	FUNCTION FOR 24BIT OUTPUT PRESSURE*/
 /**************************************************************/
@@ -1681,6 +1974,7 @@ u32 bme280_compensate_pressure_int64(s32 v_uncom_pressure_s32);
  *
 */
 u32 bme280_compensate_pressure_int64_twentyfour_bit_output(
+    struct bme280_t *p_bme280,
     s32 v_uncom_pressure_s32);
 #endif
 /**************************************************************/
@@ -1699,6 +1993,21 @@ u32 bme280_compensate_pressure_int64_twentyfour_bit_output(
  *
  *
  */
-BME280_RETURN_FUNCTION_TYPE bme280_compute_wait_time(u8
+BME280_RETURN_FUNCTION_TYPE bme280_compute_wait_time(struct bme280_t *p_bme280, u8
         *v_delaytime_u8r);
+/*!
+ * @brief Computing the typical conversion time
+ *
+ *
+ *
+ *
+ *  @param v_delaytime_u32 : The typical conversion time in microseconds
+ *
+ *
+ *	@retval 0 -> Success
+ *
+ *
+ */
+BME280_RETURN_FUNCTION_TYPE bme280_compute_typical_wait_time(struct bme280_t *p_bme280, u32
+        *v_delaytime_u32);
 #endif
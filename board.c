@@ -0,0 +1,486 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+#include "board.h"
+#include "dmem.h"
+#include "dlog.h"
+
+#ifndef BME280_VERIFY_EVERY
+#define BME280_VERIFY_EVERY 15
+#endif
+
+const char * const board_channel_name[BOARD_CH_COUNT] = {
+    [BOARD_CH_TEMPERATURE] = "temperature",
+    [BOARD_CH_PRESSURE] = "pressure",
+    [BOARD_CH_HUMIDITY] = "humidity",
+    [BOARD_CH_VISIBLE] = "visible",
+    [BOARD_CH_IR] = "ir",
+    [BOARD_CH_UV] = "uv",
+};
+
+int board_channel_parse(const char * name) {
+    for (int c = 0; c < BOARD_CH_COUNT; c++) {
+        if (strcmp(name, board_channel_name[c]) == 0)
+            return c;
+    }
+    return -1;
+}
+
+struct board_t * board_new(const char * spec, const struct board_config_t * config) {
+    struct board_t * board = xmalloc(sizeof(*board));
+    pthread_condattr_t attr;
+    char * addrs;
+    char * save = NULL;
+
+    memset(board, 0, sizeof(*board));
+    pthread_mutex_init(&board->lock, NULL);
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&board->cond, &attr);
+    pthread_condattr_destroy(&attr);
+    board->device = xstrdup(spec);
+    board->config = config;
+    board->si1132_gpio = -1;
+    board->si1132.irq_fd = -1;
+    board->wake_fd = -1;
+
+    if ((addrs = strrchr(board->device, '@')) != NULL) {
+        *addrs++ = 0;
+        for (char * a = strtok_r(addrs, ",", &save); a; a = strtok_r(NULL, ",", &save)) {
+            unsigned long addr = strtoul(a, NULL, 0);
+
+            if ((addr != BME280_I2C_ADDRESS1) && (addr != BME280_I2C_ADDRESS2)) {
+                daemon_log(LOG_ERR, "%s invalid bme280 address %s", spec, a);
+                board_free(board);
+                return NULL;
+            }
+            if (board->bme280_count == BOARD_MAX_BME280) {
+                daemon_log(LOG_ERR, "%s too many bme280", spec);
+                board_free(board);
+                return NULL;
+            }
+            if ((board->bme280_count) && (board->bme280[0].dev_addr == addr)) {
+                daemon_log(LOG_ERR, "%s duplicate bme280 address %s", spec, a);
+                board_free(board);
+                return NULL;
+            }
+            board->bme280[board->bme280_count++].dev_addr = addr;
+        }
+    }
+    if (!board->bme280_count) {
+        board->bme280[board->bme280_count++].dev_addr = BME280_I2C_ADDRESS1;
+    }
+
+    board->dev[BOARD_DEV_SI1132] = (struct board_device_t) {name: "si1132", addr: Si1132_ADDR};
+    for (int i = 0; i < board->bme280_count; i++) {
+        board->dev[BOARD_DEV_BME280(i)] = (struct board_device_t) {name: "bme280", addr: board->bme280[i].dev_addr};
+    }
+    board->dev_count = 1 + board->bme280_count;
+    return board;
+}
+
+void board_free(struct board_t * board) {
+    if (board) {
+        si1132_end(&board->si1132);
+        sensor_bus_close(board->bus);
+        if (board->wake_fd >= 0)
+            close(board->wake_fd);
+        pthread_cond_destroy(&board->cond);
+        pthread_mutex_destroy(&board->lock);
+        FREE(board->device);
+        xfree(board);
+    }
+}
+
+int board_open(struct board_t * board) {
+    if ((board->bus = sensor_bus_open(board->device)) == NULL) {
+        daemon_log(LOG_ERR, "Unable to open sensor bus %s", board->device);
+        return -1;
+    }
+    if ((board->wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)) < 0) {
+        daemon_log(LOG_ERR, "%s eventfd error (%d) %s", board->device, errno, strerror(errno));
+        return -1;
+    }
+    board->profile = board->config->profile;
+    board->bme280_cycle = bme280_profile_cycle_usec(board->profile, board->config->power_mode);
+    return 0;
+}
+
+//------------------------------------------------------------------------------------------------------------
+//
+// Bring-up
+//
+//------------------------------------------------------------------------------------------------------------
+
+static int board_device_begin(struct board_t * board, int d, const struct bme280_profile_t * profile) {
+    if (d == BOARD_DEV_SI1132) {
+        si1132_end(&board->si1132);
+        return si1132_begin(&board->si1132, board->bus, board->config->si1132_mode, board->si1132_gpio);
+    }
+    struct bme280_t * bme280 = &board->bme280[d - 1];
+    int result;
+
+    result = bme280_begin(bme280, board->bus, bme280->dev_addr, board->config->power_mode,
+                          board->config->forced_wait, profile, board->config->calib_dir);
+    if ((result == 0) && (bme280_set_compensation(bme280, board->config->compensation) != SUCCESS)) {
+        daemon_log(LOG_WARNING, "bme280 0x%02x: compensation backend %u not built in, using int32",
+                   bme280->dev_addr, board->config->compensation);
+    }
+    return result;
+}
+
+/* call with board->lock held */
+static void board_device_down(struct board_t * board, struct board_device_t * dev) {
+    dev->up = false;
+    dev->downs++;
+    dev->backoff_ms = BOARD_RECOVER_MIN_MS;
+    dev->retry_at = sensor_bus_monotonic(board->bus) + dev->backoff_ms * 1000ULL;
+    pthread_cond_signal(&board->cond);
+}
+
+/* Count the outcome of a sample or verify call, a run of failures
+   takes the device out of sampling */
+static void board_report(struct board_t * board, int d, int result) {
+    struct board_device_t * dev = &board->dev[d];
+
+    pthread_mutex_lock(&board->lock);
+    if (result < 0) {
+        dev->errors++;
+        if ((++dev->consecutive >= BOARD_FAIL_LIMIT) && (dev->up)) {
+            daemon_log(LOG_WARNING, "%s %s 0x%02x failed %u times in a row, recovering", board->device,
+                       dev->name, dev->addr, dev->consecutive);
+            board_device_down(board, dev);
+        }
+    } else {
+        dev->consecutive = 0;
+    }
+    pthread_mutex_unlock(&board->lock);
+}
+
+static bool board_device_up(struct board_t * board, int d) {
+    bool up;
+
+    pthread_mutex_lock(&board->lock);
+    up = board->dev[d].up;
+    pthread_mutex_unlock(&board->lock);
+    return up;
+}
+
+/* Re-initializes the devices that are down, the sampling worker never
+   waits for a recovery, it just leaves the device out meanwhile */
+static void * board_recovery_loop(void * p) {
+    struct board_t * board = p;
+
+    pthread_mutex_lock(&board->lock);
+    while (!board->stop) {
+        uint64_t now = sensor_bus_monotonic(board->bus);
+        uint64_t next = now + BOARD_RECOVER_MAX_MS * 1000ULL;
+        struct timespec ts;
+
+        for (int d = 0; (d < board->dev_count) && (!board->stop); d++) {
+            struct board_device_t * dev = &board->dev[d];
+            const struct bme280_profile_t * profile = board->profile;
+            int result;
+
+            if (dev->up)
+                continue;
+            if (dev->retry_at > now) {
+                if (dev->retry_at < next)
+                    next = dev->retry_at;
+                continue;
+            }
+            pthread_mutex_unlock(&board->lock);
+            result = board_device_begin(board, d, profile);
+            pthread_mutex_lock(&board->lock);
+            /* board_apply_profile skips a device that is down, one
+               switched to while it came up takes it here, the device
+               goes up with the lock still held after the last check */
+            while ((result == 0) && (d != BOARD_DEV_SI1132) && (profile != board->profile)) {
+                profile = board->profile;
+                pthread_mutex_unlock(&board->lock);
+                result = bme280_apply_profile(&board->bme280[d - 1], profile, board->config->power_mode);
+                pthread_mutex_lock(&board->lock);
+            }
+            now = sensor_bus_monotonic(board->bus);
+            if (result == 0) {
+                daemon_log(LOG_INFO, "%s %s 0x%02x recovered", board->device, dev->name, dev->addr);
+                dev->up = true;
+                dev->consecutive = 0;
+                dev->recoveries++;
+            } else {
+                dev->recover_failed++;
+                dev->backoff_ms = (dev->backoff_ms * 2 > BOARD_RECOVER_MAX_MS) ? BOARD_RECOVER_MAX_MS : dev->backoff_ms * 2;
+                dev->retry_at = now + dev->backoff_ms * 1000ULL;
+                daemon_log(LOG_DEBUG, "%s %s 0x%02x re-init failed, next try in %u ms", board->device,
+                           dev->name, dev->addr, dev->backoff_ms);
+                if (dev->retry_at < next)
+                    next = dev->retry_at;
+            }
+        }
+        if (board->stop)
+            break;
+        ts.tv_sec = next / 1000000;
+        ts.tv_nsec = (next % 1000000) * 1000;
+        pthread_cond_timedwait(&board->cond, &board->lock, &ts);
+    }
+    pthread_mutex_unlock(&board->lock);
+    return NULL;
+}
+
+typedef struct sensor_init_t {
+    struct board_t * board;
+    int dev;
+    pthread_t th;
+    int result;
+    uint64_t usec;
+} SENSOR_INIT_T;
+
+static void * sensor_init_thread(void * p) {
+    SENSOR_INIT_T * sensor = p;
+    struct board_t * board = sensor->board;
+    uint64_t start = sensor_bus_clock(board->bus);
+
+    /* before the workers, no profile switch yet */
+    sensor->result = board_device_begin(board, sensor->dev, board->profile);
+    sensor->usec = sensor_bus_clock(board->bus) - start;
+    return NULL;
+}
+
+/* Every device waits for itself, the bus is only held during
+   transfers, so the bring-ups run side by side. Devices that do not
+   come up are left to the recovery thread. */
+int board_begin(struct board_t * board) {
+    SENSOR_INIT_T sensors[BOARD_MAX_DEV] = {};
+    uint64_t start = sensor_bus_clock(board->bus);
+    int failed = 0;
+    int i;
+
+    for (i = 0; i < board->dev_count; i++) {
+        sensors[i] = (SENSOR_INIT_T) {board: board, dev: i};
+        if (pthread_create(&sensors[i].th, NULL, sensor_init_thread, &sensors[i]) != 0) {
+            daemon_log(LOG_WARNING, "%s pthread_create error, %s init inline", __FUNCTION__, board->dev[i].name);
+            sensors[i].th = 0;
+            sensor_init_thread(&sensors[i]);
+        }
+    }
+    for (i = 0; i < board->dev_count; i++) {
+        if (sensors[i].th)
+            pthread_join(sensors[i].th, NULL);
+        daemon_log(sensors[i].result ? LOG_ERR : LOG_INFO, "%s %s 0x%02x init %s in %.3f ms", board->device,
+                   board->dev[i].name, board->dev[i].addr, sensors[i].result ? "failed" : "ok", sensors[i].usec / 1000.0);
+        pthread_mutex_lock(&board->lock);
+        if (sensors[i].result == 0) {
+            board->dev[i].up = true;
+        } else {
+            board_device_down(board, &board->dev[i]);
+            failed++;
+        }
+        pthread_mutex_unlock(&board->lock);
+    }
+    daemon_log(LOG_INFO, "%s sensors ready in %.3f ms", board->device, (sensor_bus_clock(board->bus) - start) / 1000.0);
+
+    if (pthread_create(&board->recovery_th, NULL, board_recovery_loop, board) != 0) {
+        daemon_log(LOG_ERR, "%s pthread_create error (%d) %s, no device recovery", board->device, errno, strerror(errno));
+        board->recovery_th = 0;
+    }
+    return failed ? -1 : 0;
+}
+
+void board_end(struct board_t * board) {
+    pthread_mutex_lock(&board->lock);
+    board->stop = true;
+    pthread_cond_signal(&board->cond);
+    pthread_mutex_unlock(&board->lock);
+    if (board->recovery_th)
+        pthread_join(board->recovery_th, NULL);
+    board->recovery_th = 0;
+}
+
+/* a BME280 channel sampled faster than the chip converts would only
+   read the same data again, or overrun in forced mode */
+static uint64_t board_channel_period(struct board_t * board, int c) {
+    if ((BOARD_CH(c) & BOARD_CH_BME280) && (board->period[c] < board->bme280_cycle))
+        return board->bme280_cycle;
+    return board->period[c];
+}
+
+void board_schedule_init(struct board_t * board, const uint64_t * period) {
+    schedule_init(&board->schedule);
+    for (int c = 0; c < BOARD_CH_COUNT; c++) {
+        board->period[c] = period[c];
+        schedule_add(&board->schedule, board_channel_name[c], board_channel_period(board, c));
+        if (board->period[c] != board_channel_period(board, c))
+            daemon_log(LOG_WARNING, "%s %s every %u usec, the bme280 %s profile takes that long", board->device,
+                       board_channel_name[c], board->bme280_cycle, board->profile->name);
+    }
+}
+
+void board_adapt_init(struct board_t * board, uint64_t min_period, const float * threshold) {
+    adapt_init(&board->adapt, min_period);
+    for (int c = 0; c < BOARD_CH_COUNT; c++)
+        adapt_add(&board->adapt, c, threshold[c], board->period[c]);
+}
+
+void board_adapt(struct board_t * board, unsigned int changed, const float * change, const uint64_t * interval) {
+    for (int c = 0; c < BOARD_CH_COUNT; c++) {
+        uint64_t period;
+
+        if ((!(changed & BOARD_CH(c))) ||
+                ((period = adapt_update(&board->adapt, c, change[c], interval[c])) == 0) ||
+                (period == board->period[c]))
+            continue;
+        daemon_log(LOG_DEBUG, "%s %s %s, every %llu ms", board->device, board_channel_name[c],
+                   (period < board->period[c]) ? "moving" : "settling", (unsigned long long)period / 1000);
+        board->period[c] = period;
+        schedule_set_period(&board->schedule, c, board_channel_period(board, c));
+    }
+}
+
+void board_request_profile(struct board_t * board, const struct bme280_profile_t * profile) {
+    uint64_t one = 1;
+
+    pthread_mutex_lock(&board->lock);
+    board->pending_profile = profile;
+    pthread_mutex_unlock(&board->lock);
+    if (write(board->wake_fd, &one, sizeof(one)) < 0)
+        daemon_log(LOG_ERR, "%s eventfd write error (%d) %s", board->device, errno, strerror(errno));
+}
+
+/* On the sampling worker, between bursts. The devices that are down
+   take the new profile when the recovery brings them up. */
+void board_apply_profile(struct board_t * board) {
+    const struct bme280_profile_t * profile;
+    uint64_t count;
+
+    if (read(board->wake_fd, &count, sizeof(count)) < 0)
+        return;
+    pthread_mutex_lock(&board->lock);
+    profile = board->pending_profile;
+    board->pending_profile = NULL;
+    if (profile)
+        board->profile = profile;
+    pthread_mutex_unlock(&board->lock);
+    if (!profile)
+        return;
+
+    for (int i = 0; i < board->bme280_count; i++) {
+        int result;
+
+        if (!board_device_up(board, BOARD_DEV_BME280(i)))
+            continue;
+        result = bme280_apply_profile(&board->bme280[i], profile, board->config->power_mode);
+        board_report(board, BOARD_DEV_BME280(i), result);
+        if (result != 0)
+            daemon_log(LOG_ERR, "%s bme280 0x%02x unable to switch to the %s profile", board->device,
+                       board->bme280[i].dev_addr, profile->name);
+    }
+    board->bme280_cycle = bme280_profile_cycle_usec(profile, board->config->power_mode);
+    for (int c = 0; c < BOARD_CH_COUNT; c++) {
+        if (BOARD_CH(c) & BOARD_CH_BME280)
+            schedule_set_period(&board->schedule, c, board_channel_period(board, c));
+    }
+    daemon_log(LOG_INFO, "%s bme280 %s profile, %u usec a conversion", board->device, profile->name,
+               board->bme280_cycle);
+}
+
+//------------------------------------------------------------------------------------------------------------
+//
+// Sampling
+//
+//------------------------------------------------------------------------------------------------------------
+
+/* The driver trusts its copy of the control registers, once in a
+   while make sure the chip still agrees (brown-out, reset) */
+void board_verify(struct board_t * board) {
+    u8 mismatch = 0;
+    int result;
+
+    if (++board->cycle % BME280_VERIFY_EVERY)
+        return;
+    for (int i = 0; i < board->bme280_count; i++) {
+        if (!board_device_up(board, BOARD_DEV_BME280(i)))
+            continue;
+        if ((result = bme280_verify_settings(&board->bme280[i], &mismatch)) != 0) {
+            daemon_log(LOG_ERR, "%s %s 0x%02x error communication with bme280", __FUNCTION__, board->device,
+                       board->bme280[i].dev_addr);
+        } else if (mismatch) {
+            daemon_log(LOG_WARNING, "%s bme280 0x%02x settings differ from the driver copy, resynced", board->device,
+                       board->bme280[i].dev_addr);
+        }
+        board_report(board, BOARD_DEV_BME280(i), result);
+    }
+}
+
+int board_read_si1132(struct board_t * board, struct si1132_data_t * data) {
+    int result;
+
+    if (!board_device_up(board, BOARD_DEV_SI1132))
+        return BOARD_DEVICE_DOWN;
+    result = Si1132_read_all(&board->si1132, data);
+    board_report(board, BOARD_DEV_SI1132, result);
+    return result;
+}
+
+int board_read_bme280(struct board_t * board, int idx, struct bme280_sample_t * sample) {
+    struct bme280_t * bme280 = &board->bme280[idx];
+    int result;
+
+    if (!board_device_up(board, BOARD_DEV_BME280(idx)))
+        return BOARD_DEVICE_DOWN;
+    if (board->config->power_mode == BME280_FORCED_MODE) {
+        result = bme280_get_forced_pressure_temperature_humidity(bme280,
+                 &sample->pressure, &sample->temperature, &sample->humidity);
+    } else {
+        result = bme280_read_pressure_temperature_humidity(bme280,
+                 &sample->pressure, &sample->temperature, &sample->humidity);
+    }
+    board_report(board, BOARD_DEV_BME280(idx), result);
+    return result;
+}
+
+/* Raw register frames for capture, with the same health accounting */
+int board_read_si1132_raw(struct board_t * board, unsigned char * buf) {
+    int result;
+
+    if (!board_device_up(board, BOARD_DEV_SI1132))
+        return BOARD_DEVICE_DOWN;
+    result = Si1132_read_raw(&board->si1132, buf);
+    board_report(board, BOARD_DEV_SI1132, result);
+    return result;
+}
+
+int board_read_bme280_raw(struct board_t * board, int idx, u8 * frame) {
+    struct bme280_t * bme280 = &board->bme280[idx];
+    int result;
+
+    if (!board_device_up(board, BOARD_DEV_BME280(idx)))
+        return BOARD_DEVICE_DOWN;
+    if (board->config->power_mode == BME280_FORCED_MODE) {
+        result = bme280_get_forced_data_frame(bme280, frame);
+    } else {
+        result = bme280_read_data_frame(bme280, frame);
+    }
+    board_report(board, BOARD_DEV_BME280(idx), result);
+    return result;
+}
+
+void board_log_stats(struct board_t * board) {
+    pthread_mutex_lock(&board->lock);
+    for (int d = 0; d < board->dev_count; d++) {
+        struct board_device_t * dev = &board->dev[d];
+
+        daemon_log(LOG_INFO, "%s %s 0x%02x %s, %llu errors, %u in a row, down %llu times, %llu recoveries, %llu failed re-inits",
+                   board->device, dev->name, dev->addr, dev->up ? "up" : "down", (unsigned long long)dev->errors,
+                   dev->consecutive, (unsigned long long)dev->downs, (unsigned long long)dev->recoveries,
+                   (unsigned long long)dev->recover_failed);
+    }
+    pthread_mutex_unlock(&board->lock);
+    if (board->bus)
+        sensor_bus_log_stats(board->bus);
+}
@@ -0,0 +1,135 @@
+#ifndef BOARD_H_INCLUDED
+#define BOARD_H_INCLUDED
+#include <stdbool.h>
+#include <pthread.h>
+
+#include "bme280-i2c.h"
+#include "si1132.h"
+#include "sensor-bus.h"
+#include "schedule.h"
+#include "adapt.h"
+
+/* One weather board: an adapter with a Si1132 and one or two BME280.
+ * Boards are given as "device[@addr[,addr]]", e.g. /dev/i2c-1@0x76,0x77
+ * or sim:fast, the BME280 address defaults to 0x76.
+ */
+
+#define BOARD_MAX_BME280 2
+/* device slots, the Si1132 first, then the BME280 */
+#define BOARD_DEV_SI1132 0
+#define BOARD_DEV_BME280(i) (1 + (i))
+#define BOARD_MAX_DEV (1 + BOARD_MAX_BME280)
+
+/* A device that fails this many samples in a row is taken out of
+   sampling and handed to the recovery thread, which re-initializes it
+   with a growing back-off */
+#ifndef BOARD_FAIL_LIMIT
+#define BOARD_FAIL_LIMIT 3
+#endif
+#define BOARD_RECOVER_MIN_MS 500
+#define BOARD_RECOVER_MAX_MS 60000
+
+/* Measurement channels, each sampled on a period of its own. A device
+   is read when any of its channels is due, the ones due together share
+   one burst. The channel is its index in the board schedule. */
+enum {
+    BOARD_CH_TEMPERATURE = 0,
+    BOARD_CH_PRESSURE,
+    BOARD_CH_HUMIDITY,
+    BOARD_CH_VISIBLE,
+    BOARD_CH_IR,
+    BOARD_CH_UV,
+    BOARD_CH_COUNT
+};
+#define BOARD_CH(c) (1u << (c))
+#define BOARD_CH_BME280 (BOARD_CH(BOARD_CH_TEMPERATURE) | BOARD_CH(BOARD_CH_PRESSURE) | BOARD_CH(BOARD_CH_HUMIDITY))
+#define BOARD_CH_SI1132 (BOARD_CH(BOARD_CH_VISIBLE) | BOARD_CH(BOARD_CH_IR) | BOARD_CH(BOARD_CH_UV))
+
+extern const char * const board_channel_name[BOARD_CH_COUNT];
+
+/* board_read_* result for a device that is down and being recovered */
+#define BOARD_DEVICE_DOWN -2
+
+struct board_config_t {
+    u8 power_mode;          /* BME280_NORMAL_MODE or BME280_FORCED_MODE */
+    u8 forced_wait;         /* BME280_FORCED_WAIT_FIXED or _POLL */
+    unsigned char si1132_mode; /* Si1132_MODE_AUTO or Si1132_MODE_FORCED */
+    u8 compensation;        /* BME280_COMPENSATION_INT32, _INT64 or _DOUBLE */
+    const struct bme280_profile_t * profile;    /* at start, see board_request_profile */
+    const char * calib_dir;
+};
+
+struct bme280_sample_t {
+    s32 temperature;        /* 0.01 DegC */
+    u32 pressure;           /* Pa */
+    u32 humidity;           /* 1/1024 %RH */
+};
+
+struct board_device_t {
+    const char * name;
+    u8 addr;
+    bool up;
+    unsigned int consecutive;   /* failed calls in a row */
+    uint64_t errors;            /* failed sample or verify calls */
+    uint64_t downs;             /* times taken out of sampling */
+    uint64_t recoveries;        /* successful re-inits */
+    uint64_t recover_failed;    /* failed re-init attempts */
+    uint32_t backoff_ms;
+    uint64_t retry_at;          /* usec, monotonic */
+};
+
+struct board_t {
+    char * device;
+    struct sensor_bus_t * bus;
+    const struct board_config_t * config;
+    struct si1132_t si1132;
+    int si1132_gpio;        /* sysfs GPIO on the Si1132 INT line, -1 when not wired */
+    int bme280_count;
+    struct bme280_t bme280[BOARD_MAX_BME280];
+    int dev_count;
+    struct board_device_t dev[BOARD_MAX_DEV];
+    unsigned int cycle;
+    pthread_t th;
+    struct schedule_t schedule;     /* of the sampling worker, one entry per channel */
+    uint64_t period[BOARD_CH_COUNT];    /* asked for, or by adapt, usec */
+    struct adapt_t adapt;
+    uint32_t bme280_cycle;          /* usec, of the current profile, no use sampling faster */
+    int wake_fd;                    /* eventfd, the worker has a pending_profile */
+    /* recovery path, lock guards dev[] and stop */
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    pthread_t recovery_th;
+    bool stop;
+    const struct bme280_profile_t * profile;
+    const struct bme280_profile_t * pending_profile;
+};
+
+struct board_t * board_new(const char * spec, const struct board_config_t * config);
+void board_free(struct board_t * board);
+int board_open(struct board_t * board);
+int board_begin(struct board_t * board);
+void board_end(struct board_t * board);
+/* period[BOARD_CH_COUNT], usec, the BME280 channels are held to the
+   profile's cycle */
+void board_schedule_init(struct board_t * board, const uint64_t * period);
+/* after board_schedule_init, min_period 0 keeps the periods fixed,
+   threshold[BOARD_CH_COUNT] in the units of the output */
+void board_adapt_init(struct board_t * board, uint64_t min_period, const float * threshold);
+/* on the worker outside schedule_due .. schedule_next, change[c] is how
+   far the channels in changed moved since their previous reading,
+   interval[c] the usec between the two */
+void board_adapt(struct board_t * board, unsigned int changed, const float * change, const uint64_t * interval);
+/* any thread, the worker switches when wake_fd is readable and it
+   calls board_apply_profile */
+void board_request_profile(struct board_t * board, const struct bme280_profile_t * profile);
+void board_apply_profile(struct board_t * board);
+int board_channel_parse(const char * name);
+void board_verify(struct board_t * board);
+int board_read_si1132(struct board_t * board, struct si1132_data_t * data);
+int board_read_bme280(struct board_t * board, int idx, struct bme280_sample_t * sample);
+/* Si1132_RESULT_DATA_SIZE and BME280_DATA_FRAME_SIZE bytes */
+int board_read_si1132_raw(struct board_t * board, unsigned char * buf);
+int board_read_bme280_raw(struct board_t * board, int idx, u8 * frame);
+void board_log_stats(struct board_t * board);
+
+#endif // BOARD_H_INCLUDED
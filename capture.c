@@ -0,0 +1,68 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "capture.h"
+
+void capture_header_init(struct capture_header_t * header) {
+    memset(header, 0, sizeof(*header));
+    header->magic = CAPTURE_MAGIC_HEADER;
+    header->version = CAPTURE_VERSION;
+    header->header_size = sizeof(struct capture_header_t);
+    header->record_size = sizeof(struct capture_record_t);
+}
+
+void capture_calib_pack(struct capture_calib_t * calib, const struct bme280_calibration_param_t * cal_param) {
+    memset(calib, 0, sizeof(*calib));
+    calib->T1 = cal_param->dig_T1;
+    calib->T2 = cal_param->dig_T2;
+    calib->T3 = cal_param->dig_T3;
+    calib->P1 = cal_param->dig_P1;
+    calib->P2 = cal_param->dig_P2;
+    calib->P3 = cal_param->dig_P3;
+    calib->P4 = cal_param->dig_P4;
+    calib->P5 = cal_param->dig_P5;
+    calib->P6 = cal_param->dig_P6;
+    calib->P7 = cal_param->dig_P7;
+    calib->P8 = cal_param->dig_P8;
+    calib->P9 = cal_param->dig_P9;
+    calib->H1 = cal_param->dig_H1;
+    calib->H2 = cal_param->dig_H2;
+    calib->H3 = cal_param->dig_H3;
+    calib->H4 = cal_param->dig_H4;
+    calib->H5 = cal_param->dig_H5;
+    calib->H6 = cal_param->dig_H6;
+}
+
+void capture_calib_unpack(struct bme280_calibration_param_t * cal_param, const struct capture_calib_t * calib) {
+    memset(cal_param, 0, sizeof(*cal_param));
+    cal_param->dig_T1 = calib->T1;
+    cal_param->dig_T2 = calib->T2;
+    cal_param->dig_T3 = calib->T3;
+    cal_param->dig_P1 = calib->P1;
+    cal_param->dig_P2 = calib->P2;
+    cal_param->dig_P3 = calib->P3;
+    cal_param->dig_P4 = calib->P4;
+    cal_param->dig_P5 = calib->P5;
+    cal_param->dig_P6 = calib->P6;
+    cal_param->dig_P7 = calib->P7;
+    cal_param->dig_P8 = calib->P8;
+    cal_param->dig_P9 = calib->P9;
+    cal_param->dig_H1 = calib->H1;
+    cal_param->dig_H2 = calib->H2;
+    cal_param->dig_H3 = calib->H3;
+    cal_param->dig_H4 = calib->H4;
+    cal_param->dig_H5 = calib->H5;
+    cal_param->dig_H6 = calib->H6;
+}
+
+void capture_format_time(char * buf, size_t size, uint64_t time_usec, bool msec) {
+    time_t timer = time_usec / 1000000;
+    struct tm tm_info;
+    size_t n;
+
+    localtime_r(&timer, &tm_info);
+    n = strftime(buf, size, "%Y-%m-%d %H:%M:%S", &tm_info);
+    if (msec)
+        snprintf(buf + n, size - n, ".%03u", (unsigned int)(time_usec % 1000000) / 1000);
+}
@@ -0,0 +1,84 @@
+#ifndef CAPTURE_H_INCLUDED
+#define CAPTURE_H_INCLUDED
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "bme280.h"
+#include "si1132.h"
+
+/* Raw capture, -F raw:file. The daemon only does bus I/O and appends
+ * fixed size records with the register frames as read; wb_raw
+ * compensates them later, elsewhere.
+ *
+ * The stream is a run of segments: a capture_header_t, then records.
+ * The header has one slot per board with the trimming parameters of
+ * its BME280. A new header is written whenever a parameter block not in
+ * the current one is first needed (a device that came up late or was
+ * swapped), so a header applies to the records that follow it.
+ *
+ * Everything is in the byte order of the capturing host, wb_raw
+ * refuses a stream whose magic does not match its own.
+ */
+
+#define CAPTURE_MAGIC_HEADER 0x48524257     /* "WBRH" little endian */
+#define CAPTURE_MAGIC_RECORD 0x52524257     /* "WBRR" */
+#define CAPTURE_VERSION 1
+#define CAPTURE_MAX_SLOTS 8
+#define CAPTURE_MAX_BME280 2
+#define CAPTURE_BUS_SIZE 32
+
+/* record flags, set for each frame that was read */
+#define CAPTURE_SI1132_OK 0x01
+#define CAPTURE_BME280_OK(i) (0x02 << (i))
+/* sampled under a second apart, the time goes out with milliseconds */
+#define CAPTURE_TIME_MSEC 0x80
+
+struct capture_calib_t {
+    uint16_t T1;
+    int16_t T2, T3;
+    uint16_t P1;
+    int16_t P2, P3, P4, P5, P6, P7, P8, P9;
+    uint8_t H1, H3;
+    int16_t H2, H4, H5;
+    int8_t H6;
+} __attribute__((packed));
+
+struct capture_device_t {
+    uint8_t addr;
+    uint8_t chip_id;
+    uint8_t valid;              /* calib is known */
+    struct capture_calib_t calib;
+} __attribute__((packed));
+
+struct capture_slot_t {
+    char bus[CAPTURE_BUS_SIZE];
+    uint8_t bme280_count;
+    struct capture_device_t bme280[CAPTURE_MAX_BME280];
+} __attribute__((packed));
+
+struct capture_header_t {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t header_size;
+    uint16_t record_size;
+    uint16_t slot_count;
+    struct capture_slot_t slot[CAPTURE_MAX_SLOTS];
+} __attribute__((packed));
+
+struct capture_record_t {
+    uint32_t magic;
+    uint8_t slot;
+    uint8_t flags;
+    uint16_t reserved;
+    uint64_t time_usec;         /* CLOCK_REALTIME */
+    uint8_t si1132[Si1132_RESULT_DATA_SIZE];
+    uint8_t bme280[CAPTURE_MAX_BME280][BME280_DATA_FRAME_SIZE];
+} __attribute__((packed));
+
+void capture_header_init(struct capture_header_t * header);
+void capture_calib_pack(struct capture_calib_t * calib, const struct bme280_calibration_param_t * cal_param);
+void capture_calib_unpack(struct bme280_calibration_param_t * cal_param, const struct capture_calib_t * calib);
+/* the "time" of a record, local, "%Y-%m-%d %H:%M:%S" and ".mmm" with msec */
+void capture_format_time(char * buf, size_t size, uint64_t time_usec, bool msec);
+
+#endif // CAPTURE_H_INCLUDED
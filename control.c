@@ -0,0 +1,92 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "control.h"
+#include "dmem.h"
+#include "dlog.h"
+
+char * control_path(const char * pid_file) {
+    size_t len = strlen(pid_file);
+    char * path = xmalloc(len + sizeof(".ctl"));
+
+    strcpy(path, pid_file);
+    if ((len > 4) && (strcmp(path + len - 4, ".pid") == 0))
+        len -= 4;
+    strcpy(path + len, ".ctl");
+    return path;
+}
+
+static int control_address(const char * path, struct sockaddr_un * addr) {
+    memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr->sun_path)) {
+        daemon_log(LOG_ERR, "%s control socket path too long", path);
+        return -1;
+    }
+    strcpy(addr->sun_path, path);
+    return 0;
+}
+
+int control_open(const char * path) {
+    struct sockaddr_un addr;
+    int fd;
+
+    if (control_address(path, &addr) < 0)
+        return -1;
+    if ((fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0)) < 0) {
+        daemon_log(LOG_ERR, "%s socket error (%d) %s", __FUNCTION__, errno, strerror(errno));
+        return -1;
+    }
+    /* left over by a daemon that did not exit cleanly, the pid file
+       says there is no other one running */
+    unlink(path);
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        daemon_log(LOG_ERR, "%s bind %s error (%d) %s", __FUNCTION__, path, errno, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+void control_close(int fd, const char * path) {
+    if (fd >= 0) {
+        close(fd);
+        unlink(path);
+    }
+}
+
+ssize_t control_recv(int fd, char * buf, size_t size) {
+    ssize_t len;
+
+    if ((len = recv(fd, buf, size - 1, 0)) < 0) {
+        if ((errno != EAGAIN) && (errno != EINTR))
+            daemon_log(LOG_ERR, "%s recv error (%d) %s", __FUNCTION__, errno, strerror(errno));
+        return 0;
+    }
+    buf[len] = 0;
+    /* a trailing newline from socat and the like */
+    while ((len > 0) && ((buf[len - 1] == '\n') || (buf[len - 1] == '\r')))
+        buf[--len] = 0;
+    return len;
+}
+
+int control_send(const char * path, const char * command) {
+    struct sockaddr_un addr;
+    int fd;
+    int result = 0;
+
+    if (control_address(path, &addr) < 0)
+        return -1;
+    if ((fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0)) < 0)
+        return -1;
+    if (sendto(fd, command, strlen(command), 0, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+        result = -1;
+    close(fd);
+    return result;
+}
@@ -0,0 +1,22 @@
+#ifndef CONTROL_H_INCLUDED
+#define CONTROL_H_INCLUDED
+#include <stddef.h>
+#include <sys/types.h>
+
+/* Commands to the running daemon, one text datagram each on a unix
+ * socket next to the pid file, e.g. "profile low-noise". Nothing is
+ * sent back, the daemon logs what it did.
+ */
+
+#define CONTROL_MAX_COMMAND 128
+
+/* the socket path of the daemon with this pid file, xmalloc'ed */
+char * control_path(const char * pid_file);
+/* the daemon side, a non blocking socket bound to path, -1 on error */
+int control_open(const char * path);
+void control_close(int fd, const char * path);
+/* the next command, NUL terminated, 0 when there is none */
+ssize_t control_recv(int fd, char * buf, size_t size);
+int control_send(const char * path, const char * command);
+
+#endif // CONTROL_H_INCLUDED
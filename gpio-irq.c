@@ -0,0 +1,90 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <poll.h>
+
+#include "gpio-irq.h"
+#include "dlog.h"
+
+#define GPIO_SYSFS "/sys/class/gpio"
+/* udev needs a moment to fix the permissions of a fresh export */
+#define GPIO_EXPORT_RETRIES 20
+#define GPIO_EXPORT_RETRY_US 5000
+
+static int gpio_write_file(const char * path, const char * value) {
+    int fd;
+    int ret = 0;
+
+    if ((fd = open(path, O_WRONLY | O_CLOEXEC)) < 0)
+        return -1;
+    if (write(fd, value, strlen(value)) < 0)
+        ret = -1;
+    close(fd);
+    return ret;
+}
+
+int gpio_irq_open(int gpio, const char * edge) {
+    char path[128];
+    char num[16];
+    int fd;
+    int i;
+
+    snprintf(num, sizeof(num), "%d", gpio);
+    snprintf(path, sizeof(path), GPIO_SYSFS "/gpio%d/value", gpio);
+    if (access(path, F_OK) < 0) {
+        if ((gpio_write_file(GPIO_SYSFS "/export", num) < 0) && (errno != EBUSY)) {
+            daemon_log(LOG_ERR, "Unable to export gpio %d (%d) %s", gpio, errno, strerror(errno));
+            return -1;
+        }
+    }
+
+    for (i = 0; i < GPIO_EXPORT_RETRIES; i++) {
+        snprintf(path, sizeof(path), GPIO_SYSFS "/gpio%d/direction", gpio);
+        if (gpio_write_file(path, "in") == 0)
+            break;
+        usleep(GPIO_EXPORT_RETRY_US);
+    }
+    snprintf(path, sizeof(path), GPIO_SYSFS "/gpio%d/edge", gpio);
+    if ((i == GPIO_EXPORT_RETRIES) || (gpio_write_file(path, edge) < 0)) {
+        daemon_log(LOG_ERR, "Unable to set up gpio %d as %s edge input (%d) %s", gpio, edge, errno, strerror(errno));
+        return -1;
+    }
+
+    snprintf(path, sizeof(path), GPIO_SYSFS "/gpio%d/value", gpio);
+    if ((fd = open(path, O_RDONLY | O_CLOEXEC)) < 0) {
+        daemon_log(LOG_ERR, "Unable to open %s (%d) %s", path, errno, strerror(errno));
+        return -1;
+    }
+    gpio_irq_level(fd);
+    return fd;
+}
+
+void gpio_irq_close(int fd) {
+    if (fd >= 0)
+        close(fd);
+}
+
+int gpio_irq_level(int fd) {
+    char c;
+
+    if ((lseek(fd, 0, SEEK_SET) < 0) || (read(fd, &c, 1) != 1))
+        return -1;
+    return c == '1';
+}
+
+int gpio_irq_wait(int fd, int timeout_ms) {
+    struct pollfd pfd = {fd: fd, events: POLLPRI | POLLERR};
+    int ret;
+
+    while ((ret = poll(&pfd, 1, timeout_ms)) < 0) {
+        if (errno != EINTR)
+            return -1;
+    }
+    if (ret == 0)
+        return 0;
+    gpio_irq_level(fd);
+    return 1;
+}
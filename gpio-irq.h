@@ -0,0 +1,16 @@
+#ifndef GPIO_IRQ_H_INCLUDED
+#define GPIO_IRQ_H_INCLUDED
+
+/* Interrupt lines through the sysfs GPIO interface. The value file of
+ * an input with an edge configured reports POLLPRI on every edge. */
+
+/* export the pin, make it an input and arm "rising", "falling" or "both",
+   returns the value fd or -1 */
+int gpio_irq_open(int gpio, const char * edge);
+void gpio_irq_close(int fd);
+/* current level, also acknowledges a pending edge */
+int gpio_irq_level(int fd);
+/* 1 on an edge, 0 on timeout, -1 on error */
+int gpio_irq_wait(int fd, int timeout_ms);
+
+#endif // GPIO_IRQ_H_INCLUDED
@@ -0,0 +1,118 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+
+#include "i2c-bus.h"
+#include "dmem.h"
+#include "dlog.h"
+
+/* Adapter timeout per transaction, a wedged bus fails the ioctl
+   with ETIMEDOUT instead of blocking the caller */
+#ifndef I2C_BUS_TIMEOUT_MS
+#define I2C_BUS_TIMEOUT_MS 100
+#endif
+#ifndef I2C_BUS_RETRIES
+#define I2C_BUS_RETRIES 1
+#endif
+
+struct i2c_bus_t {
+    struct sensor_bus_t bus;
+    int fd;
+};
+
+static int i2c_bus_read(struct sensor_bus_t * bus, uint8_t dev_addr, uint8_t reg_addr, uint8_t * data, uint16_t len) {
+    struct i2c_bus_t * i2c = (struct i2c_bus_t *)bus;
+    struct i2c_msg msgs[2] = {
+        {addr: dev_addr, flags: 0, len: 1, buf: &reg_addr},
+        {addr: dev_addr, flags: I2C_M_RD, len: len, buf: data},
+    };
+    struct i2c_rdwr_ioctl_data xfer = {msgs: msgs, nmsgs: 2};
+
+    if (ioctl(i2c->fd, I2C_RDWR, &xfer) != 2) {
+        daemon_log(LOG_DEBUG, "%s %s 0x%02x reg 0x%02x len %u (%d) %s", __FUNCTION__, bus->name,
+                   dev_addr, reg_addr, len, errno, strerror(errno));
+        return -1;
+    }
+    return 0;
+}
+
+/* Every read is a write of its register address and a read, the batch
+   is one I2C_RDWR with repeated starts in between and a single stop */
+static int i2c_bus_read_many(struct sensor_bus_t * bus, struct sensor_bus_xfer_t ** xfers, int count) {
+    struct i2c_bus_t * i2c = (struct i2c_bus_t *)bus;
+    struct i2c_msg msgs[2 * SENSOR_BUS_BATCH_MAX];
+    struct i2c_rdwr_ioctl_data xfer = {msgs: msgs, nmsgs: 2 * count};
+
+    if ((count > SENSOR_BUS_BATCH_MAX) || (2 * count > I2C_RDWR_IOCTL_MAX_MSGS)) {
+        errno = EINVAL;
+        return -1;
+    }
+    for (int i = 0; i < count; i++) {
+        msgs[2 * i] = (struct i2c_msg) {addr: xfers[i]->dev_addr, flags: 0, len: 1, buf: &xfers[i]->reg_addr};
+        msgs[2 * i + 1] = (struct i2c_msg) {addr: xfers[i]->dev_addr, flags: I2C_M_RD, len: xfers[i]->len, buf: xfers[i]->data};
+    }
+    if (ioctl(i2c->fd, I2C_RDWR, &xfer) != 2 * count) {
+        daemon_log(LOG_DEBUG, "%s %s %d reads (%d) %s", __FUNCTION__, bus->name, count, errno, strerror(errno));
+        return -1;
+    }
+    return 0;
+}
+
+static int i2c_bus_write(struct sensor_bus_t * bus, uint8_t dev_addr, const uint8_t * data, uint16_t len) {
+    struct i2c_bus_t * i2c = (struct i2c_bus_t *)bus;
+    struct i2c_msg msg = {addr: dev_addr, flags: 0, len: len, buf: (uint8_t *)data};
+    struct i2c_rdwr_ioctl_data xfer = {msgs: &msg, nmsgs: 1};
+
+    if (ioctl(i2c->fd, I2C_RDWR, &xfer) != 1) {
+        daemon_log(LOG_DEBUG, "%s %s 0x%02x reg 0x%02x len %u (%d) %s", __FUNCTION__, bus->name,
+                   dev_addr, len ? data[0] : 0, len, errno, strerror(errno));
+        return -1;
+    }
+    return 0;
+}
+
+static void i2c_bus_close(struct sensor_bus_t * bus) {
+    struct i2c_bus_t * i2c = (struct i2c_bus_t *)bus;
+
+    close(i2c->fd);
+    FREE(bus->name);
+    xfree(i2c);
+}
+
+static const struct sensor_bus_ops_t i2c_bus_ops = {
+    read: i2c_bus_read,
+    write: i2c_bus_write,
+    read_many: i2c_bus_read_many,
+    delay: sensor_bus_sleep,
+    clock: sensor_bus_monotonic,
+    close: i2c_bus_close,
+};
+
+struct sensor_bus_t * i2c_bus_open(const char * device) {
+    struct i2c_bus_t * i2c;
+    int fd;
+
+    if ((fd = open(device, O_RDWR | O_CLOEXEC)) < 0) {
+        daemon_log(LOG_ERR, "Unable to open %s (%d) %s", device, errno, strerror(errno));
+        return NULL;
+    }
+    /* I2C_TIMEOUT is in units of 10 ms */
+    if (ioctl(fd, I2C_TIMEOUT, (I2C_BUS_TIMEOUT_MS + 9) / 10) < 0) {
+        daemon_log(LOG_WARNING, "%s I2C_TIMEOUT (%d) %s", device, errno, strerror(errno));
+    }
+    if (ioctl(fd, I2C_RETRIES, I2C_BUS_RETRIES) < 0) {
+        daemon_log(LOG_WARNING, "%s I2C_RETRIES (%d) %s", device, errno, strerror(errno));
+    }
+
+    i2c = xmalloc(sizeof(*i2c));
+    i2c->bus.ops = &i2c_bus_ops;
+    i2c->bus.name = xstrdup(device);
+    i2c->fd = fd;
+    return &i2c->bus;
+}
@@ -0,0 +1,11 @@
+#ifndef I2C_BUS_H_INCLUDED
+#define I2C_BUS_H_INCLUDED
+#include "sensor-bus.h"
+
+/* Native /dev/i2c-N backend. Every read or write is one I2C_RDWR
+ * ioctl, i.e. one bus transaction, however many bytes it moves.
+ * Reads queued together by the arbiter share one ioctl. */
+
+struct sensor_bus_t * i2c_bus_open(const char * device);
+
+#endif // I2C_BUS_H_INCLUDED
@@ -0,0 +1,117 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <math.h>
+#include <string.h>
+#include "metrics.h"
+#include "dmem.h"
+
+/* Magnus coefficients over water, Sonntag 1990 */
+#define MAGNUS_A 17.62f
+#define MAGNUS_B 243.12f
+#define MAGNUS_ES0 6.112f
+
+static const struct {
+    const char * name;
+    unsigned int mask;
+} metric_names[] = {
+    {"dew_point", METRIC_DEW_POINT},
+    {"heat_index", METRIC_HEAT_INDEX},
+    {"absolute_humidity", METRIC_ABS_HUMIDITY},
+    {"sea_level", METRIC_SEA_LEVEL},
+    {"all", METRIC_ALL},
+};
+
+float metrics_sea_level_factor(float altitude) {
+    return powf(1.0f - altitude / 44330.0f, -1.0f / 0.1903f);
+}
+
+static void metrics_temperature_terms(struct metrics_cache_t * cache, s32 temperature) {
+    float t = temperature / 100.0f;
+    float f = t * 1.8f + 32.0f;
+    float es;
+
+    cache->magnus = MAGNUS_A * t / (MAGNUS_B + t);
+    es = MAGNUS_ES0 * expf(cache->magnus);
+    /* e = RH / 100 * es hPa, 216.7 g K / m3 / hPa * e / T */
+    cache->abs_k = 2.167f * es / (273.15f + t);
+    cache->hi[0] = -42.379f + 2.04901523f * f - 0.00683783f * f * f;
+    cache->hi[1] = 10.14333127f - 0.22475541f * f + 0.00122874f * f * f;
+    cache->hi[2] = -0.05481717f + 0.00085282f * f - 0.00000199f * f * f;
+    cache->hi_simple = 0.5f * (f + 61.0f + (f - 68.0f) * 1.2f);
+    cache->temperature = temperature;
+}
+
+static float metrics_heat_index(const struct metrics_cache_t * cache, s32 temperature, float rh) {
+    float f = (temperature / 100.0f) * 1.8f + 32.0f;
+    float hi = cache->hi_simple + 0.5f * rh * 0.094f;
+
+    if ((hi + f) / 2.0f >= 80.0f) {
+        hi = cache->hi[0] + (cache->hi[1] + cache->hi[2] * rh) * rh;
+        if ((rh < 13.0f) && (f >= 80.0f) && (f <= 112.0f))
+            hi -= (13.0f - rh) / 4.0f * sqrtf((17.0f - fabsf(f - 95.0f)) / 17.0f);
+        else if ((rh > 85.0f) && (f >= 80.0f) && (f <= 87.0f))
+            hi += (rh - 85.0f) / 10.0f * (87.0f - f) / 5.0f;
+    }
+    return (hi - 32.0f) / 1.8f;
+}
+
+void metrics_compute(struct metrics_cache_t * cache, unsigned int mask, float sea_level_factor,
+                     s32 temperature, u32 humidity, u32 pressure, struct metrics_t * metrics) {
+    /* 1/1024 %RH, kept off 0 for the log */
+    float rh = (humidity ? humidity : 1) / 1024.0f;
+
+    if ((!cache->valid) || (cache->temperature != temperature)) {
+        metrics_temperature_terms(cache, temperature);
+        cache->valid = true;
+    }
+    if ((mask & METRIC_DEW_POINT) && ((!cache->humidity_valid) || (cache->humidity != humidity))) {
+        cache->humidity_log = logf(rh / 100.0f);
+        cache->humidity = humidity;
+        cache->humidity_valid = true;
+    }
+
+    if (mask & METRIC_DEW_POINT) {
+        float gamma = cache->humidity_log + cache->magnus;
+        metrics->dew_point = MAGNUS_B * gamma / (MAGNUS_A - gamma);
+    }
+    if (mask & METRIC_HEAT_INDEX)
+        metrics->heat_index = metrics_heat_index(cache, temperature, rh);
+    if (mask & METRIC_ABS_HUMIDITY)
+        metrics->abs_humidity = cache->abs_k * rh;
+    if (mask & METRIC_SEA_LEVEL)
+        metrics->sea_level = pressure / 100.0f * sea_level_factor;
+}
+
+void metrics_json(char * buf, size_t size, unsigned int mask, const struct metrics_t * metrics) {
+    int n = 0;
+
+    buf[0] = 0;
+    if (mask & METRIC_DEW_POINT)
+        n += snprintf(buf + n, size - n, ", \"dew_point_C\": %.2f", metrics->dew_point);
+    if (mask & METRIC_HEAT_INDEX)
+        n += snprintf(buf + n, size - n, ", \"heat_index_C\": %.2f", metrics->heat_index);
+    if (mask & METRIC_ABS_HUMIDITY)
+        n += snprintf(buf + n, size - n, ", \"absolute_humidity\": %.2f", metrics->abs_humidity);
+    if (mask & METRIC_SEA_LEVEL)
+        snprintf(buf + n, size - n, ", \"sea_level_pressure\": %.2f", metrics->sea_level);
+}
+
+int metrics_parse(const char * list) {
+    char * s = xstrdup(list), * save = NULL;
+    int mask = 0;
+
+    for (char * name = strtok_r(s, ",", &save); name; name = strtok_r(NULL, ",", &save)) {
+        size_t i;
+        for (i = 0; i < sizeof(metric_names) / sizeof(metric_names[0]); i++) {
+            if (strcmp(name, metric_names[i].name) == 0)
+                break;
+        }
+        if (i == sizeof(metric_names) / sizeof(metric_names[0])) {
+            mask = -1;
+            break;
+        }
+        mask |= metric_names[i].mask;
+    }
+    xfree(s);
+    return mask;
+}
@@ -0,0 +1,57 @@
+#ifndef METRICS_H_INCLUDED
+#define METRICS_H_INCLUDED
+#include <stdbool.h>
+#include <stddef.h>
+#include "bme280.h"
+
+/* Quantities derived from one BME280 sample, computed once in the daemon
+ * so consumers do not each redo them:
+ *   dew point           Magnus formula over water, degC
+ *   heat index          NOAA (Rothfusz regression with its adjustments), degC
+ *   absolute humidity   g/m3
+ *   sea level pressure  QNH from the station altitude, standard atmosphere, hPa
+ *
+ * Everything that depends on the temperature alone (the saturation vapour
+ * pressure, the Magnus term, the heat index polynomial in humidity) is
+ * kept in a per-device cache and only redone when the temperature reading
+ * changes, the log of the humidity likewise.
+ */
+
+#define METRIC_DEW_POINT        0x01
+#define METRIC_HEAT_INDEX       0x02
+#define METRIC_ABS_HUMIDITY     0x04
+#define METRIC_SEA_LEVEL        0x08
+#define METRIC_ALL              0x0f
+
+struct metrics_t {
+    float dew_point;        /* degC */
+    float heat_index;       /* degC */
+    float abs_humidity;     /* g/m3 */
+    float sea_level;        /* hPa */
+};
+
+struct metrics_cache_t {
+    bool valid;             /* temperature terms */
+    bool humidity_valid;    /* humidity_log */
+    s32 temperature;        /* the reading the temperature terms are for */
+    u32 humidity;           /* the reading humidity_log is for */
+    float magnus;           /* 17.62 T / (243.12 + T) */
+    float abs_k;            /* absolute humidity per %RH */
+    float hi[3];            /* heat index in degF as hi[0] + hi[1] RH + hi[2] RH^2 */
+    float hi_simple;        /* the simple heat index formula without its RH term */
+    float humidity_log;     /* ln(RH / 100) */
+};
+
+/* multiplier from station to sea level pressure for a station at
+   altitude metres, the inverse of the altitude formula */
+float metrics_sea_level_factor(float altitude);
+/* temperature in 0.01 degC, humidity in 1/1024 %RH and pressure in Pa as
+   struct bme280_sample_t has them, only the metrics in mask are set */
+void metrics_compute(struct metrics_cache_t * cache, unsigned int mask, float sea_level_factor,
+                     s32 temperature, u32 humidity, u32 pressure, struct metrics_t * metrics);
+/* the metrics in mask as JSON members, each with a leading ", " */
+void metrics_json(char * buf, size_t size, unsigned int mask, const struct metrics_t * metrics);
+/* "dew_point,heat_index,..." or "all" to a mask, -1 for an unknown name */
+int metrics_parse(const char * list);
+
+#endif // METRICS_H_INCLUDED
@@ -0,0 +1,121 @@
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include "reactor.h"
+#include "dmem.h"
+#include "dlog.h"
+
+#define REACTOR_MAX_EVENTS 8
+
+struct reactor_handler_t {
+    int fd;
+    reactor_callback_t callback;
+    void * arg;
+    struct reactor_handler_t * next;
+};
+
+struct reactor_t {
+    int epoll_fd;
+    bool stop;
+    uint64_t wakeups;
+    struct reactor_handler_t * handlers;
+    /* removed during a round, freed after it, a later event of the
+       same round may still point to them */
+    struct reactor_handler_t * removed;
+};
+
+struct reactor_t * reactor_new() {
+    struct reactor_t * reactor = xmalloc(sizeof(*reactor));
+
+    memset(reactor, 0, sizeof(*reactor));
+    if ((reactor->epoll_fd = epoll_create1(EPOLL_CLOEXEC)) < 0) {
+        daemon_log(LOG_ERR, "%s epoll_create1 error (%d) %s", __FUNCTION__, errno, strerror(errno));
+        xfree(reactor);
+        return NULL;
+    }
+    return reactor;
+}
+
+static void reactor_free_list(struct reactor_handler_t * handler) {
+    while (handler) {
+        struct reactor_handler_t * next = handler->next;
+
+        xfree(handler);
+        handler = next;
+    }
+}
+
+void reactor_free(struct reactor_t * reactor) {
+    if (reactor) {
+        reactor_free_list(reactor->handlers);
+        reactor_free_list(reactor->removed);
+        close(reactor->epoll_fd);
+        xfree(reactor);
+    }
+}
+
+int reactor_add(struct reactor_t * reactor, int fd, uint32_t events, reactor_callback_t callback, void * arg) {
+    struct reactor_handler_t * handler = xmalloc(sizeof(*handler));
+    struct epoll_event event = {events: events, data: {ptr: handler}};
+
+    *handler = (struct reactor_handler_t) {fd: fd, callback: callback, arg: arg, next: reactor->handlers};
+    if (epoll_ctl(reactor->epoll_fd, EPOLL_CTL_ADD, fd, &event) < 0) {
+        daemon_log(LOG_ERR, "%s fd %d epoll_ctl error (%d) %s", __FUNCTION__, fd, errno, strerror(errno));
+        xfree(handler);
+        return -1;
+    }
+    reactor->handlers = handler;
+    return 0;
+}
+
+int reactor_del(struct reactor_t * reactor, int fd) {
+    for (struct reactor_handler_t ** h = &reactor->handlers; *h; h = &(*h)->next) {
+        struct reactor_handler_t * handler = *h;
+
+        if (handler->fd != fd)
+            continue;
+        *h = handler->next;
+        handler->callback = NULL;
+        handler->next = reactor->removed;
+        reactor->removed = handler;
+        return epoll_ctl(reactor->epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+    }
+    return -1;
+}
+
+int reactor_run(struct reactor_t * reactor) {
+    struct epoll_event events[REACTOR_MAX_EVENTS];
+
+    reactor->stop = false;
+    while (!reactor->stop) {
+        int n;
+
+        if ((n = epoll_wait(reactor->epoll_fd, events, REACTOR_MAX_EVENTS, -1)) < 0) {
+            if (errno == EINTR)
+                continue;
+            daemon_log(LOG_ERR, "%s epoll_wait error (%d) %s", __FUNCTION__, errno, strerror(errno));
+            return -1;
+        }
+        reactor->wakeups++;
+        for (int i = 0; i < n; i++) {
+            struct reactor_handler_t * handler = events[i].data.ptr;
+
+            if (handler->callback)
+                handler->callback(reactor, handler->fd, events[i].events, handler->arg);
+        }
+        reactor_free_list(reactor->removed);
+        reactor->removed = NULL;
+    }
+    return 0;
+}
+
+void reactor_stop(struct reactor_t * reactor) {
+    reactor->stop = true;
+}
+
+uint64_t reactor_wakeups(struct reactor_t * reactor) {
+    return reactor->wakeups;
+}
@@ -0,0 +1,32 @@
+#ifndef REACTOR_H_INCLUDED
+#define REACTOR_H_INCLUDED
+#include <stdint.h>
+#include <stdbool.h>
+#include <sys/epoll.h>
+
+/* A small epoll loop: file descriptors with a callback each, no
+ * timeout, so a thread sleeping in reactor_run wakes up only when one
+ * of its fds is ready. Timers are timerfds and wakeups from other
+ * threads eventfds like any other fd.
+ *
+ * A reactor belongs to the thread that runs it, the callbacks run on
+ * that thread and reactor_add, reactor_del and reactor_stop are called
+ * from it (or before reactor_run).
+ */
+
+struct reactor_t;
+
+typedef void (* reactor_callback_t)(struct reactor_t * reactor, int fd, uint32_t events, void * arg);
+
+struct reactor_t * reactor_new();
+void reactor_free(struct reactor_t * reactor);
+/* events are EPOLLIN, EPOLLOUT ... level triggered */
+int reactor_add(struct reactor_t * reactor, int fd, uint32_t events, reactor_callback_t callback, void * arg);
+int reactor_del(struct reactor_t * reactor, int fd);
+/* dispatch until reactor_stop, 0 then, -1 on an epoll error */
+int reactor_run(struct reactor_t * reactor);
+/* reactor_run returns once the callbacks of the current round are done */
+void reactor_stop(struct reactor_t * reactor);
+uint64_t reactor_wakeups(struct reactor_t * reactor);
+
+#endif // REACTOR_H_INCLUDED
@@ -0,0 +1,193 @@
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/timerfd.h>
+
+#include "schedule.h"
+#include "dlog.h"
+
+uint64_t schedule_monotonic() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+static uint64_t schedule_realtime() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+uint64_t schedule_parse_period(const char * s) {
+    char * end = NULL;
+    double value = strtod(s, &end);
+    uint64_t period;
+
+    if ((end == s) || (value <= 0))
+        return 0;
+    if ((*end == 0) || (strcmp(end, "s") == 0)) {
+        period = value * 1e6;
+    } else if (strcmp(end, "ms") == 0) {
+        period = value * 1e3;
+    } else if (strcmp(end, "m") == 0) {
+        period = value * 60e6;
+    } else if (strcmp(end, "h") == 0) {
+        period = value * 3600e6;
+    } else if (strcasecmp(end, "hz") == 0) {
+        period = 1e6 / value;
+    } else {
+        return 0;
+    }
+    return (period < SCHEDULE_MIN_PERIOD_USEC) ? 0 : period;
+}
+
+void schedule_init(struct schedule_t * schedule) {
+    memset(schedule, 0, sizeof(*schedule));
+    pthread_mutex_init(&schedule->lock, NULL);
+}
+
+int schedule_add(struct schedule_t * schedule, const char * name, uint64_t period) {
+    if (schedule->count == SCHEDULE_MAX_ENTRIES)
+        return -1;
+    schedule->entry[schedule->count] = (struct schedule_entry_t) {name: name, period: period};
+    return schedule->count++;
+}
+
+static inline bool schedule_before(const struct schedule_t * schedule, int a, int b) {
+    return schedule->entry[a].deadline < schedule->entry[b].deadline;
+}
+
+static void schedule_push(struct schedule_t * schedule, int e) {
+    int i = schedule->heap_count++;
+
+    while ((i > 0) && (schedule_before(schedule, e, schedule->heap[(i - 1) / 2]))) {
+        schedule->heap[i] = schedule->heap[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    schedule->heap[i] = e;
+}
+
+static int schedule_pop(struct schedule_t * schedule) {
+    int top = schedule->heap[0];
+    int last = schedule->heap[--schedule->heap_count];
+    int i = 0;
+
+    for (;;) {
+        int child = 2 * i + 1;
+
+        if (child >= schedule->heap_count)
+            break;
+        if ((child + 1 < schedule->heap_count) && (schedule_before(schedule, schedule->heap[child + 1], schedule->heap[child])))
+            child++;
+        if (!schedule_before(schedule, schedule->heap[child], last))
+            break;
+        schedule->heap[i] = schedule->heap[child];
+        i = child;
+    }
+    schedule->heap[i] = last;
+    return top;
+}
+
+void schedule_start(struct schedule_t * schedule) {
+    uint64_t now = schedule_monotonic();
+
+    pthread_mutex_lock(&schedule->lock);
+    schedule->heap_count = 0;
+    schedule->due = 0;
+    for (int e = 0; e < schedule->count; e++) {
+        schedule->entry[e].deadline = now;
+        schedule->entry[e].align = true;
+        schedule_push(schedule, e);
+    }
+    pthread_mutex_unlock(&schedule->lock);
+}
+
+void schedule_set_period(struct schedule_t * schedule, int e, uint64_t period) {
+    struct schedule_entry_t * entry = &schedule->entry[e];
+    uint64_t now = schedule_monotonic();
+
+    pthread_mutex_lock(&schedule->lock);
+    entry->period = period;
+    if (entry->deadline > now + period) {
+        entry->deadline = now;
+        entry->align = true;
+        /* the heap is small, build it again rather than sift a key
+           that went down */
+        schedule->heap_count = 0;
+        for (int i = 0; i < schedule->count; i++)
+            schedule_push(schedule, i);
+    }
+    pthread_mutex_unlock(&schedule->lock);
+}
+
+int schedule_arm(struct schedule_t * schedule, int fd) {
+    uint64_t deadline = schedule->entry[schedule->heap[0]].deadline;
+    struct itimerspec its = {
+        it_value: {tv_sec: deadline / 1000000, tv_nsec: (deadline % 1000000) * 1000},
+    };
+
+    return timerfd_settime(fd, TFD_TIMER_ABSTIME, &its, NULL);
+}
+
+unsigned int schedule_due(struct schedule_t * schedule, uint64_t now) {
+    while ((schedule->heap_count) && (schedule->entry[schedule->heap[0]].deadline <= now + SCHEDULE_COALESCE_USEC))
+        schedule->due |= 1u << schedule_pop(schedule);
+    return schedule->due;
+}
+
+void schedule_next(struct schedule_t * schedule, uint64_t started) {
+    uint64_t now = schedule_monotonic();
+    uint64_t realtime = schedule_realtime();
+
+    pthread_mutex_lock(&schedule->lock);
+    if (schedule->due)
+        schedule->wakeups++;
+    for (int e = 0; e < schedule->count; e++) {
+        struct schedule_entry_t * entry = &schedule->entry[e];
+        uint64_t late;
+
+        if (!(schedule->due & (1u << e)))
+            continue;
+        late = (started > entry->deadline) ? started - entry->deadline : 0;
+        entry->samples++;
+        entry->jitter_sum += late;
+        if (late > entry->jitter_max)
+            entry->jitter_max = late;
+        if (entry->align) {
+            entry->deadline = now + (entry->period - realtime % entry->period);
+            entry->align = false;
+        } else {
+            entry->deadline += entry->period;
+        }
+        if (entry->deadline <= now) {
+            uint64_t missed = (now - entry->deadline) / entry->period + 1;
+            entry->overruns += missed;
+            entry->deadline += missed * entry->period;
+        }
+        schedule_push(schedule, e);
+    }
+    schedule->due = 0;
+    pthread_mutex_unlock(&schedule->lock);
+}
+
+void schedule_log_stats(struct schedule_t * schedule, const char * name) {
+    uint64_t samples = 0;
+
+    pthread_mutex_lock(&schedule->lock);
+    for (int e = 0; e < schedule->count; e++) {
+        struct schedule_entry_t * entry = &schedule->entry[e];
+
+        daemon_log(LOG_INFO, "%s %s every %llu.%03llu ms: %llu samples, %llu overruns, jitter avg %llu max %llu usec",
+                   name, entry->name, (unsigned long long)entry->period / 1000, (unsigned long long)entry->period % 1000,
+                   (unsigned long long)entry->samples, (unsigned long long)entry->overruns,
+                   (unsigned long long)(entry->samples ? entry->jitter_sum / entry->samples : 0),
+                   (unsigned long long)entry->jitter_max);
+        samples += entry->samples;
+    }
+    daemon_log(LOG_INFO, "%s %llu samples in %llu wakeups", name, (unsigned long long)samples,
+               (unsigned long long)schedule->wakeups);
+    pthread_mutex_unlock(&schedule->lock);
+}
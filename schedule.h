@@ -0,0 +1,76 @@
+#ifndef SCHEDULE_H_INCLUDED
+#define SCHEDULE_H_INCLUDED
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+/* Sampling on absolute CLOCK_MONOTONIC deadlines, so the time spent
+ * sampling does not add up. Every entry (a measurement channel) has a
+ * period of its own, the entries are kept in a min-heap on their next
+ * deadline and the timer is armed for the earliest one.
+ *
+ * The first sample of every entry is taken at once, the next deadline
+ * is put on a wall clock multiple of its period (a 20 s period samples
+ * at :00, :20, :40) and the rest follow it. With periods that divide
+ * each other the deadlines then meet, the entries due within
+ * SCHEDULE_COALESCE_USEC of each other are handed out together and
+ * sampled in one wakeup.
+ *
+ * A sample that ends after the entry's next deadline has passed is an
+ * overrun, the missed deadlines are skipped rather than caught up in a
+ * burst. Jitter is how late a sample starts against its deadline.
+ */
+
+#define SCHEDULE_MIN_PERIOD_USEC 10000ULL
+#define SCHEDULE_COALESCE_USEC 2000ULL
+#define SCHEDULE_MAX_ENTRIES 8
+
+struct schedule_entry_t {
+    const char * name;
+    uint64_t period;            /* usec */
+    uint64_t deadline;          /* usec, CLOCK_MONOTONIC */
+    bool align;                 /* the next deadline goes on a wall clock multiple */
+    uint64_t samples;
+    uint64_t overruns;          /* deadlines skipped */
+    uint64_t jitter_sum;        /* usec */
+    uint64_t jitter_max;
+};
+
+struct schedule_t {
+    int count;
+    struct schedule_entry_t entry[SCHEDULE_MAX_ENTRIES];
+    /* entry indices, the earliest deadline first */
+    int heap_count;
+    int heap[SCHEDULE_MAX_ENTRIES];
+    unsigned int due;           /* taken out by schedule_due */
+    /* stats, under lock for schedule_log_stats from another thread */
+    pthread_mutex_t lock;
+    uint64_t wakeups;
+};
+
+/* "20", "20s", "100ms", "5m", "1h" or "10Hz", 0 when it does not parse
+   or is under SCHEDULE_MIN_PERIOD_USEC */
+uint64_t schedule_parse_period(const char * s);
+void schedule_init(struct schedule_t * schedule);
+/* the index of the new entry, which is its bit in the due masks, -1
+   when there is no room */
+int schedule_add(struct schedule_t * schedule, const char * name, uint64_t period);
+/* from the thread that runs the schedule, outside schedule_due ..
+   schedule_next. An entry that would now wait longer than the new
+   period starts over at once. */
+void schedule_set_period(struct schedule_t * schedule, int e, uint64_t period);
+/* the first deadline of every entry is now */
+void schedule_start(struct schedule_t * schedule);
+/* arm fd, a CLOCK_MONOTONIC timerfd, for the earliest deadline */
+int schedule_arm(struct schedule_t * schedule, int fd);
+/* the mask of the entries due by now, they are out of the heap until
+   schedule_next */
+unsigned int schedule_due(struct schedule_t * schedule, uint64_t now);
+/* account for the sample of the due entries that started at started
+   (schedule_monotonic) and has just ended, then move them to their
+   next deadlines */
+void schedule_next(struct schedule_t * schedule, uint64_t started);
+void schedule_log_stats(struct schedule_t * schedule, const char * name);
+uint64_t schedule_monotonic();
+
+#endif // SCHEDULE_H_INCLUDED
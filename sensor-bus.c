@@ -0,0 +1,232 @@
+#define _GNU_SOURCE
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+
+#include "sensor-bus.h"
+#include "i2c-bus.h"
+#include "sim-bus.h"
+#include "dlog.h"
+
+struct sensor_bus_t * sensor_bus_open(const char * device) {
+    struct sensor_bus_t * bus;
+
+    if (!device)
+        return NULL;
+
+    if ((strncmp(device, "sim", 3) == 0) && ((device[3] == 0) || (device[3] == ':'))) {
+        bus = sim_bus_open(device[3] ? device + 4 : "");
+    } else {
+        bus = i2c_bus_open(device);
+    }
+    if (bus) {
+        pthread_mutex_init(&bus->lock, NULL);
+        pthread_cond_init(&bus->cond, NULL);
+        bus->head = bus->tail = NULL;
+        bus->depth = 0;
+        bus->busy = false;
+        memset(&bus->stats, 0, sizeof(bus->stats));
+    }
+    return bus;
+}
+
+void sensor_bus_get_stats(struct sensor_bus_t * bus, struct sensor_bus_stats_t * stats) {
+    pthread_mutex_lock(&bus->lock);
+    *stats = bus->stats;
+    pthread_mutex_unlock(&bus->lock);
+}
+
+void sensor_bus_log_stats(struct sensor_bus_t * bus) {
+    struct sensor_bus_stats_t stats;
+
+    sensor_bus_get_stats(bus, &stats);
+    daemon_log(LOG_INFO, "%s %llu transfers, %llu in %llu batches, %llu waited %.3f ms avg %.3f ms max, queue depth max %u",
+               bus->name, (unsigned long long)stats.transfers, (unsigned long long)stats.batched,
+               (unsigned long long)stats.batches, (unsigned long long)stats.waited,
+               stats.waited ? stats.wait_usec / 1000.0 / stats.waited : 0.0, stats.wait_max / 1000.0,
+               stats.depth_max);
+    daemon_log(LOG_INFO, "%s errors: %s %llu, %s %llu, %s %llu, %s %llu, %s %llu", bus->name,
+               sensor_bus_error_name(SENSOR_BUS_ERR_NACK), (unsigned long long)stats.errors[SENSOR_BUS_ERR_NACK],
+               sensor_bus_error_name(SENSOR_BUS_ERR_TIMEOUT), (unsigned long long)stats.errors[SENSOR_BUS_ERR_TIMEOUT],
+               sensor_bus_error_name(SENSOR_BUS_ERR_ARBITRATION), (unsigned long long)stats.errors[SENSOR_BUS_ERR_ARBITRATION],
+               sensor_bus_error_name(SENSOR_BUS_ERR_BUS), (unsigned long long)stats.errors[SENSOR_BUS_ERR_BUS],
+               sensor_bus_error_name(SENSOR_BUS_ERR_OTHER), (unsigned long long)stats.errors[SENSOR_BUS_ERR_OTHER]);
+}
+
+enum sensor_bus_error_t sensor_bus_error_class(int error) {
+    switch (error) {
+    case ENXIO:
+    case EREMOTEIO:
+    case ENODEV:
+        return SENSOR_BUS_ERR_NACK;
+    case ETIMEDOUT:
+        return SENSOR_BUS_ERR_TIMEOUT;
+    case EAGAIN:
+        return SENSOR_BUS_ERR_ARBITRATION;
+    case EIO:
+    case EPROTO:
+    case EBADMSG:
+        return SENSOR_BUS_ERR_BUS;
+    default:
+        return SENSOR_BUS_ERR_OTHER;
+    }
+}
+
+const char * sensor_bus_error_name(enum sensor_bus_error_t cls) {
+    static const char * const names[SENSOR_BUS_ERR_MAX] = {
+        [SENSOR_BUS_ERR_NACK] = "nack",
+        [SENSOR_BUS_ERR_TIMEOUT] = "timeout",
+        [SENSOR_BUS_ERR_ARBITRATION] = "arbitration",
+        [SENSOR_BUS_ERR_BUS] = "bus",
+        [SENSOR_BUS_ERR_OTHER] = "other",
+    };
+
+    return (cls < SENSOR_BUS_ERR_MAX) ? names[cls] : "?";
+}
+
+void sensor_bus_close(struct sensor_bus_t * bus) {
+    if (bus) {
+        sensor_bus_log_stats(bus);
+        pthread_cond_destroy(&bus->cond);
+        pthread_mutex_destroy(&bus->lock);
+        bus->ops->close(bus);
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------
+//
+// Arbiter
+//
+//------------------------------------------------------------------------------------------------------------
+
+/* errno belongs to the thread issuing the queue, it travels back to
+   the owner of the transaction in xfer->error */
+static void sensor_bus_issue_one(struct sensor_bus_t * bus, struct sensor_bus_xfer_t * xfer) {
+    if (xfer->read) {
+        xfer->result = bus->ops->read(bus, xfer->dev_addr, xfer->reg_addr, xfer->data, xfer->len);
+    } else {
+        xfer->result = bus->ops->write(bus, xfer->dev_addr, xfer->data, xfer->len);
+    }
+    xfer->error = (xfer->result < 0) ? errno : 0;
+}
+
+/* Issue a detached queue in order. Runs of reads go out as one batch
+   when the backend can, writes always go alone: a failed batch does
+   not say how far it got, reads are simply issued again one by one,
+   a write (e.g. a Si1132 command) must not be repeated */
+static void sensor_bus_issue(struct sensor_bus_t * bus, struct sensor_bus_xfer_t * list, struct sensor_bus_stats_t * stats) {
+    struct sensor_bus_xfer_t * batch[SENSOR_BUS_BATCH_MAX];
+
+    while (list) {
+        int count = 0;
+
+        if (bus->ops->read_many) {
+            for (struct sensor_bus_xfer_t * x = list; x && x->read && (count < SENSOR_BUS_BATCH_MAX); x = x->next) {
+                batch[count++] = x;
+            }
+        }
+        if (count > 1) {
+            stats->batches++;
+            stats->batched += count;
+            if (bus->ops->read_many(bus, batch, count) == 0) {
+                for (int i = 0; i < count; i++)
+                    batch[i]->result = batch[i]->error = 0;
+            } else {
+                for (int i = 0; i < count; i++)
+                    sensor_bus_issue_one(bus, batch[i]);
+            }
+            list = batch[count - 1]->next;
+        } else {
+            sensor_bus_issue_one(bus, list);
+            list = list->next;
+        }
+    }
+}
+
+static int sensor_bus_submit(struct sensor_bus_t * bus, struct sensor_bus_xfer_t * xfer) {
+    int result;
+
+    pthread_mutex_lock(&bus->lock);
+    xfer->next = NULL;
+    xfer->done = false;
+    xfer->queued = sensor_bus_monotonic(bus);
+    if (bus->tail)
+        bus->tail->next = xfer;
+    else
+        bus->head = xfer;
+    bus->tail = xfer;
+    if (++bus->depth > bus->stats.depth_max)
+        bus->stats.depth_max = bus->depth;
+    if (bus->busy)
+        bus->stats.waited++;
+
+    while (!xfer->done) {
+        if (bus->busy) {
+            pthread_cond_wait(&bus->cond, &bus->lock);
+            continue;
+        }
+        /* nobody is on the bus, serve whatever is queued, ours included */
+        bus->busy = true;
+        while (bus->head) {
+            struct sensor_bus_xfer_t * list = bus->head;
+            struct sensor_bus_stats_t stats = {};
+            uint64_t now = sensor_bus_monotonic(bus);
+
+            bus->head = bus->tail = NULL;
+            bus->depth = 0;
+            for (struct sensor_bus_xfer_t * x = list; x; x = x->next) {
+                uint64_t wait = now - x->queued;
+
+                bus->stats.transfers++;
+                bus->stats.wait_usec += wait;
+                if (wait > bus->stats.wait_max)
+                    bus->stats.wait_max = wait;
+            }
+            pthread_mutex_unlock(&bus->lock);
+            sensor_bus_issue(bus, list, &stats);
+            pthread_mutex_lock(&bus->lock);
+            bus->stats.batches += stats.batches;
+            bus->stats.batched += stats.batched;
+            while (list) {
+                struct sensor_bus_xfer_t * next = list->next;
+
+                if (list->result < 0)
+                    bus->stats.errors[sensor_bus_error_class(list->error)]++;
+                list->done = true;
+                list = next;
+            }
+        }
+        bus->busy = false;
+        pthread_cond_broadcast(&bus->cond);
+    }
+    result = xfer->result;
+    pthread_mutex_unlock(&bus->lock);
+    if (result < 0)
+        errno = xfer->error;
+    return result;
+}
+
+int sensor_bus_read(struct sensor_bus_t * bus, uint8_t dev_addr, uint8_t reg_addr, uint8_t * data, uint16_t len) {
+    struct sensor_bus_xfer_t xfer = {dev_addr: dev_addr, reg_addr: reg_addr, read: true, data: data, len: len};
+
+    return sensor_bus_submit(bus, &xfer);
+}
+
+int sensor_bus_write(struct sensor_bus_t * bus, uint8_t dev_addr, const uint8_t * data, uint16_t len) {
+    struct sensor_bus_xfer_t xfer = {dev_addr: dev_addr, read: false, data: (uint8_t *)data, len: len};
+
+    return sensor_bus_submit(bus, &xfer);
+}
+
+void sensor_bus_sleep(struct sensor_bus_t * bus, uint32_t usec) {
+    struct timespec ts = {tv_sec: usec / 1000000, tv_nsec: (usec % 1000000) * 1000};
+
+    while (clock_nanosleep(CLOCK_MONOTONIC, 0, &ts, &ts) == EINTR);
+}
+
+uint64_t sensor_bus_monotonic(struct sensor_bus_t * bus) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
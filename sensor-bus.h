@@ -0,0 +1,108 @@
+#ifndef SENSOR_BUS_H_INCLUDED
+#define SENSOR_BUS_H_INCLUDED
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+/* Bus used by the sensor drivers. A backend fills the ops table and
+ * embeds struct sensor_bus_t as the first member of its own state.
+ * read and write are one bus transaction each.
+ *
+ * Reads and writes go through the bus arbiter: a caller queues its
+ * transaction and either waits for it or, when nobody is busy with the
+ * bus, becomes the one issuing the queue for everybody. Drivers on
+ * different threads need no locks of their own, backends only ever see
+ * one transaction (or batch) at a time. */
+
+struct sensor_bus_t;
+
+/* one queued transaction */
+struct sensor_bus_xfer_t {
+    struct sensor_bus_xfer_t * next;
+    uint8_t dev_addr;
+    uint8_t reg_addr;       /* reads only */
+    bool read;
+    uint8_t * data;
+    uint16_t len;
+    int result;
+    int error;              /* errno of a failed transaction */
+    bool done;
+    uint64_t queued;        /* usec, when it entered the queue */
+};
+
+struct sensor_bus_ops_t {
+    /* write reg_addr, repeated start, read len bytes */
+    int (*read)(struct sensor_bus_t * bus, uint8_t dev_addr, uint8_t reg_addr, uint8_t * data, uint16_t len);
+    /* write len bytes, the first one is usually a register address */
+    int (*write)(struct sensor_bus_t * bus, uint8_t dev_addr, const uint8_t * data, uint16_t len);
+    /* optional, several reads in one go, each as read above; 0 when
+       all of them succeeded, any failure fails the whole batch */
+    int (*read_many)(struct sensor_bus_t * bus, struct sensor_bus_xfer_t ** xfers, int count);
+    void (*delay)(struct sensor_bus_t * bus, uint32_t usec);
+    /* monotonic time in usec */
+    uint64_t (*clock)(struct sensor_bus_t * bus);
+    void (*close)(struct sensor_bus_t * bus);
+};
+
+/* Failed transactions by errno class */
+enum sensor_bus_error_t {
+    SENSOR_BUS_ERR_NACK = 0,    /* no device or no ack (ENXIO, EREMOTEIO) */
+    SENSOR_BUS_ERR_TIMEOUT,     /* adapter timeout, wedged bus (ETIMEDOUT) */
+    SENSOR_BUS_ERR_ARBITRATION, /* lost arbitration (EAGAIN) */
+    SENSOR_BUS_ERR_BUS,         /* bus or protocol error (EIO, EPROTO, EBADMSG) */
+    SENSOR_BUS_ERR_OTHER,
+    SENSOR_BUS_ERR_MAX,
+};
+
+struct sensor_bus_stats_t {
+    uint64_t transfers;     /* transactions issued */
+    uint64_t batches;       /* read_many calls */
+    uint64_t batched;       /* transactions that went in a batch */
+    uint64_t waited;        /* transactions that found the bus busy */
+    uint64_t wait_usec;     /* total queueing delay */
+    uint64_t wait_max;      /* longest queueing delay, usec */
+    unsigned int depth_max; /* deepest queue seen */
+    uint64_t errors[SENSOR_BUS_ERR_MAX];
+};
+
+struct sensor_bus_t {
+    const struct sensor_bus_ops_t * ops;
+    char * name;
+    /* arbiter, set up by sensor_bus_open */
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    struct sensor_bus_xfer_t * head;
+    struct sensor_bus_xfer_t * tail;
+    unsigned int depth;
+    bool busy;
+    struct sensor_bus_stats_t stats;
+};
+
+#ifndef SENSOR_BUS_BATCH_MAX
+#define SENSOR_BUS_BATCH_MAX 16
+#endif
+
+/* "sim[:options]" opens the simulated bus, anything else is an i2c-dev node */
+struct sensor_bus_t * sensor_bus_open(const char * device);
+void sensor_bus_close(struct sensor_bus_t * bus);
+void sensor_bus_get_stats(struct sensor_bus_t * bus, struct sensor_bus_stats_t * stats);
+void sensor_bus_log_stats(struct sensor_bus_t * bus);
+enum sensor_bus_error_t sensor_bus_error_class(int error);
+const char * sensor_bus_error_name(enum sensor_bus_error_t cls);
+
+/* Default delay and clock for backends that run in real time */
+void sensor_bus_sleep(struct sensor_bus_t * bus, uint32_t usec);
+uint64_t sensor_bus_monotonic(struct sensor_bus_t * bus);
+
+int sensor_bus_read(struct sensor_bus_t * bus, uint8_t dev_addr, uint8_t reg_addr, uint8_t * data, uint16_t len);
+int sensor_bus_write(struct sensor_bus_t * bus, uint8_t dev_addr, const uint8_t * data, uint16_t len);
+
+static inline void sensor_bus_delay(struct sensor_bus_t * bus, uint32_t usec) {
+    bus->ops->delay(bus, usec);
+}
+
+static inline uint64_t sensor_bus_clock(struct sensor_bus_t * bus) {
+    return bus->ops->clock(bus);
+}
+
+#endif // SENSOR_BUS_H_INCLUDED
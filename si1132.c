@@ -1,113 +1,260 @@
 #define _GNU_SOURCE
 #include <stdio.h>
-#include <unistd.h>
-#include <wiringPiI2C.h>
+#include <string.h>
 #include "si1132.h"
+#include "gpio-irq.h"
 #include "dlog.h"
 
-int si1132_begin(const char *device) {
-    si1132Fd = wiringPiI2CSetupInterface(device, Si1132_ADDR);
-    if (si1132Fd < 0) {
-        daemon_log(LOG_ERR,"ERROR: si1132 open failed");
+static int Si1132_I2C_read8(struct si1132_t *si1132, unsigned char reg) {
+    unsigned char val;
+    if (sensor_bus_read(si1132->bus, si1132->addr, reg, &val, 1) < 0)
+        return -1;
+    return val;
+}
+
+static int Si1132_I2C_read16(struct si1132_t *si1132, unsigned char reg) {
+    unsigned char buf[2];
+    if (sensor_bus_read(si1132->bus, si1132->addr, reg, buf, sizeof(buf)) < 0)
+        return -1;
+    return buf[0] | (buf[1] << 8);
+}
+
+static int Si1132_I2C_write8(struct si1132_t *si1132, unsigned char reg, unsigned char val) {
+    unsigned char buf[2] = {reg, val};
+    return sensor_bus_write(si1132->bus, si1132->addr, buf, sizeof(buf));
+}
+
+/* The chip auto-increments the register address on writes too,
+   so adjacent registers go out in one transaction */
+static int Si1132_I2C_writeBlock(struct si1132_t *si1132, unsigned char reg, const unsigned char *vals, int cnt) {
+    unsigned char buf[cnt + 1];
+    buf[0] = reg;
+    memcpy(&buf[1], vals, cnt);
+    return sensor_bus_write(si1132->bus, si1132->addr, buf, sizeof(buf));
+}
+
+/* Wait until RESPONSE moves away from the value it had before the
+   command, that is the sequencer's completion counter */
+static int Si1132_I2C_waitResponse(struct si1132_t *si1132, int prev) {
+    uint64_t deadline = sensor_bus_clock(si1132->bus) + Si1132_CMD_TIMEOUT_US;
+    int response;
+
+    for (;;) {
+        if ((response = Si1132_I2C_read8(si1132, Si1132_REG_RESPONSE)) < 0)
+            return -1;
+        if (response != prev)
+            break;
+        if (sensor_bus_clock(si1132->bus) >= deadline) {
+            daemon_log(LOG_ERR, "ERROR: si1132 command timeout");
+            return -1;
+        }
+        sensor_bus_delay(si1132->bus, Si1132_POLL_INTERVAL_US);
+    }
+    if (response & Si1132_RESPONSE_ERROR) {
+        daemon_log(LOG_ERR, "ERROR: si1132 command failed 0x%02x", response);
+        /* a NOP clears the error */
+        Si1132_I2C_write8(si1132, Si1132_REG_COMMAND, Si1132_NOP);
         return -1;
     }
+    return 0;
+}
+
+static int Si1132_I2C_command(struct si1132_t *si1132, unsigned char cmd) {
+    int prev;
 
-    if (wiringPiI2CReadReg8(si1132Fd, Si1132_REG_PARTID) != 0x32) {
+    if ((prev = Si1132_I2C_read8(si1132, Si1132_REG_RESPONSE)) < 0)
+        return -1;
+    if (Si1132_I2C_write8(si1132, Si1132_REG_COMMAND, cmd) < 0)
+        return -1;
+    return Si1132_I2C_waitResponse(si1132, prev);
+}
+
+int si1132_begin(struct si1132_t *si1132, struct sensor_bus_t *bus, unsigned char mode, int irq_gpio) {
+    si1132->bus = bus;
+    si1132->addr = Si1132_ADDR;
+    si1132->mode = mode;
+    si1132->irq_fd = -1;
+    si1132->conv_usec = 0;
+
+    if (Si1132_I2C_read8(si1132, Si1132_REG_PARTID) != 0x32) {
         daemon_log(LOG_ERR,"ERROR: si1132 read failed the PART ID");
         return -1;
     }
 
-    initialize();
-    return 0;
+    /* INT is open drain, active low */
+    if ((mode == Si1132_MODE_FORCED) && (irq_gpio >= 0) &&
+            ((si1132->irq_fd = gpio_irq_open(irq_gpio, "falling")) < 0)) {
+        daemon_log(LOG_WARNING, "si1132 INT on gpio %d unusable, polling IRQ_STATUS", irq_gpio);
+    }
+
+    return initialize(si1132);
+}
+
+void si1132_end(struct si1132_t *si1132) {
+    gpio_irq_close(si1132->irq_fd);
+    si1132->irq_fd = -1;
 }
 
-void initialize(void) {
-    reset();
+int initialize(struct si1132_t *si1132) {
+    static const unsigned char ucoef[] = {0x7B, 0x6B, 0x01, 0x00};
+    int rslt = 0;
 
-    wiringPiI2CWriteReg8(si1132Fd, Si1132_REG_UCOEF0, 0x7B);
-    wiringPiI2CWriteReg8(si1132Fd, Si1132_REG_UCOEF1, 0x6B);
-    wiringPiI2CWriteReg8(si1132Fd, Si1132_REG_UCOEF2, 0x01);
-    wiringPiI2CWriteReg8(si1132Fd, Si1132_REG_UCOEF3, 0x00);
+    if (reset(si1132) < 0)
+        return -1;
 
-    Si1132_I2C_writeParam(Si1132_PARAM_CHLIST, Si1132_PARAM_CHLIST_ENUV |
-                          Si1132_PARAM_CHLIST_ENALSIR | Si1132_PARAM_CHLIST_ENALSVIS);
-    usleep(10000);
+    rslt |= Si1132_I2C_writeBlock(si1132, Si1132_REG_UCOEF0, ucoef, sizeof(ucoef));
 
-    wiringPiI2CWriteReg8(si1132Fd, Si1132_REG_INTCFG,
-                         Si1132_REG_INTCFG_INTOE);
-    usleep(10000);
-    wiringPiI2CWriteReg8(si1132Fd, Si1132_REG_IRQEN,
-                         Si1132_REG_IRQEN_ALSEVERYSAMPLE);
-    usleep(10000);
+    rslt |= Si1132_I2C_writeParam(si1132, Si1132_PARAM_CHLIST, Si1132_PARAM_CHLIST_ENUV |
+                                  Si1132_PARAM_CHLIST_ENALSIR | Si1132_PARAM_CHLIST_ENALSVIS);
+    si1132->channels = 3;
 
-    Si1132_I2C_writeParam(Si1132_PARAM_ALSIRADCMUX,
-                          Si1132_PARAM_ADCMUX_SMALLIR);
-    usleep(10000);
+    rslt |= Si1132_I2C_write8(si1132, Si1132_REG_INTCFG, Si1132_REG_INTCFG_INTOE);
+    rslt |= Si1132_I2C_write8(si1132, Si1132_REG_IRQEN, Si1132_REG_IRQEN_ALSEVERYSAMPLE);
+
+    rslt |= Si1132_I2C_writeParam(si1132, Si1132_PARAM_ALSIRADCMUX, Si1132_PARAM_ADCMUX_SMALLIR);
     // fastest clocks, clock div 1
-    Si1132_I2C_writeParam(Si1132_PARAM_ALSIRADCGAIN, 0);
-    usleep(10000);
+    rslt |= Si1132_I2C_writeParam(si1132, Si1132_PARAM_ALSIRADCGAIN, 0);
     // take 511 clocks to measure
-    Si1132_I2C_writeParam(Si1132_PARAM_ALSIRADCCOUNTER,
-                          Si1132_PARAM_ADCCOUNTER_511CLK);
+    rslt |= Si1132_I2C_writeParam(si1132, Si1132_PARAM_ALSIRADCCOUNTER, Si1132_PARAM_ADCCOUNTER_511CLK);
     // in high range mode
-    Si1132_I2C_writeParam(Si1132_PARAM_ALSIRADCMISC,
-                          Si1132_PARAM_ALSIRADCMISC_RANGE);
-    usleep(10000);
+    rslt |= Si1132_I2C_writeParam(si1132, Si1132_PARAM_ALSIRADCMISC, Si1132_PARAM_ALSIRADCMISC_RANGE);
     // fastest clocks
-    Si1132_I2C_writeParam(Si1132_PARAM_ALSVISADCGAIN, 0);
-    usleep(10000);
+    rslt |= Si1132_I2C_writeParam(si1132, Si1132_PARAM_ALSVISADCGAIN, 0);
     // take 511 clocks to measure
-    Si1132_I2C_writeParam(Si1132_PARAM_ALSVISADCCOUNTER,
-                          Si1132_PARAM_ADCCOUNTER_511CLK);
+    rslt |= Si1132_I2C_writeParam(si1132, Si1132_PARAM_ALSVISADCCOUNTER, Si1132_PARAM_ADCCOUNTER_511CLK);
     //in high range mode (not normal signal)
-    Si1132_I2C_writeParam(Si1132_PARAM_ALSVISADCMISC,
-                          Si1132_PARAM_ALSVISADCMISC_VISRANGE);
-    usleep(10000);
+    rslt |= Si1132_I2C_writeParam(si1132, Si1132_PARAM_ALSVISADCMISC, Si1132_PARAM_ALSVISADCMISC_VISRANGE);
 
-    wiringPiI2CWriteReg8(si1132Fd, Si1132_REG_MEASRATE0, 0xFF);
-    wiringPiI2CWriteReg8(si1132Fd, Si1132_REG_COMMAND, Si1132_ALS_AUTO);
+    /* in forced mode MEASRATE stays 0 from the reset and the chip
+       sits idle until Si1132_force */
+    if (si1132->mode == Si1132_MODE_AUTO) {
+        rslt |= Si1132_I2C_write8(si1132, Si1132_REG_MEASRATE0, 0xFF);
+        rslt |= Si1132_I2C_command(si1132, Si1132_ALS_AUTO);
+    }
+    return rslt < 0 ? -1 : 0;
 }
 
-void reset() {
-    wiringPiI2CWriteReg8(si1132Fd, Si1132_REG_MEASRATE0, 0);
-    usleep(10000);
-    wiringPiI2CWriteReg8(si1132Fd, Si1132_REG_MEASRATE1, 0);
-    usleep(10000);
-    wiringPiI2CWriteReg8(si1132Fd, Si1132_REG_IRQEN, 0);
-    usleep(10000);
-    wiringPiI2CWriteReg8(si1132Fd, Si1132_REG_IRQMODE1, 0);
-    usleep(10000);
-    wiringPiI2CWriteReg8(si1132Fd, Si1132_REG_IRQMODE2, 0);
-    usleep(10000);
-    wiringPiI2CWriteReg8(si1132Fd, Si1132_REG_INTCFG, 0);
-    usleep(10000);
-    wiringPiI2CWriteReg8(si1132Fd, Si1132_REG_IRQSTAT, 0xFF);
-    usleep(10000);
+int reset(struct si1132_t *si1132) {
+    static const unsigned char measrate[] = {0, 0};
+    /* INTCFG, IRQEN, IRQMODE1, IRQMODE2 */
+    static const unsigned char irq[] = {0, 0, 0, 0};
+    uint64_t deadline;
+    int rslt = 0;
 
-    wiringPiI2CWriteReg8(si1132Fd, Si1132_REG_COMMAND, Si1132_RESET);
-    usleep(10000);
-    wiringPiI2CWriteReg8(si1132Fd, Si1132_REG_HWKEY, 0x17);
+    rslt |= Si1132_I2C_writeBlock(si1132, Si1132_REG_MEASRATE0, measrate, sizeof(measrate));
+    rslt |= Si1132_I2C_writeBlock(si1132, Si1132_REG_INTCFG, irq, sizeof(irq));
+    rslt |= Si1132_I2C_write8(si1132, Si1132_REG_IRQSTAT, 0xFF);
+    rslt |= Si1132_I2C_write8(si1132, Si1132_REG_COMMAND, Si1132_RESET);
+    if (rslt < 0)
+        return -1;
 
-    usleep(10000);
+    /* HW_KEY reads back once the chip is out of reset */
+    deadline = sensor_bus_clock(si1132->bus) + Si1132_RESET_TIMEOUT_US;
+    for (;;) {
+        if ((Si1132_I2C_write8(si1132, Si1132_REG_HWKEY, Si1132_HWKEY) == 0) &&
+                (Si1132_I2C_read8(si1132, Si1132_REG_HWKEY) == Si1132_HWKEY))
+            return 0;
+        if (sensor_bus_clock(si1132->bus) >= deadline) {
+            daemon_log(LOG_ERR, "ERROR: si1132 reset timeout");
+            return -1;
+        }
+        sensor_bus_delay(si1132->bus, Si1132_POLL_INTERVAL_US);
+    }
+}
+
+float Si1132_readVisible(struct si1132_t *si1132) {
+    return ((Si1132_I2C_read16(si1132, Si1132_REG_ALSVISDATA0) - 256) / 0.282) * 14.5;
+}
+
+float Si1132_readIR(struct si1132_t *si1132) {
+    return ((Si1132_I2C_read16(si1132, Si1132_REG_ALSIRDATA0) - 250) / 2.44) * 14.5;
+}
+
+float Si1132_readUV(struct si1132_t *si1132) {
+    return Si1132_I2C_read16(si1132, Si1132_REG_UVINDEX0);
+}
+
+/* Wait for the ALS interrupt after ALS_FORCE. The INT line, when wired,
+   saves the bus traffic, IRQ_STATUS is read once anyway to confirm */
+static int Si1132_waitAls(struct si1132_t *si1132, uint64_t start) {
+    uint64_t deadline = start + Si1132_FORCE_TIMEOUT_US;
+    int irqstat;
+
+    if (si1132->irq_fd >= 0) {
+        if (gpio_irq_wait(si1132->irq_fd, Si1132_FORCE_TIMEOUT_US / 1000) < 0) {
+            daemon_log(LOG_WARNING, "si1132 INT wait failed, polling IRQ_STATUS");
+        }
+    } else {
+        sensor_bus_delay(si1132->bus, Si1132_ALS_CHANNEL_TYP_US * si1132->channels);
+    }
+
+    for (;;) {
+        if ((irqstat = Si1132_I2C_read8(si1132, Si1132_REG_IRQSTAT)) < 0)
+            return -1;
+        if (irqstat & Si1132_REG_IRQSTAT_ALS)
+            return 0;
+        if (sensor_bus_clock(si1132->bus) >= deadline) {
+            daemon_log(LOG_ERR, "ERROR: si1132 forced measurement timeout");
+            return -1;
+        }
+        sensor_bus_delay(si1132->bus, Si1132_POLL_INTERVAL_US);
+    }
+}
+
+/* One measurement of every enabled channel, returns once the results
+   are in the data registers */
+int Si1132_force(struct si1132_t *si1132) {
+    uint64_t start;
+
+    /* a stale ALS flag would end the wait early, clearing it also
+       releases INT */
+    if (Si1132_I2C_write8(si1132, Si1132_REG_IRQSTAT, Si1132_REG_IRQSTAT_ALS) < 0)
+        return -1;
+    if (si1132->irq_fd >= 0)
+        gpio_irq_level(si1132->irq_fd);
+
+    start = sensor_bus_clock(si1132->bus);
+    if ((Si1132_I2C_command(si1132, Si1132_ALS_FORCE) < 0) || (Si1132_waitAls(si1132, start) < 0))
+        return -1;
+    si1132->conv_usec = sensor_bus_clock(si1132->bus) - start;
+    daemon_log(LOG_DEBUG, "si1132 forced measurement in %u us", si1132->conv_usec);
+    return 0;
 }
 
-float Si1132_readVisible() {
-    usleep(10000);
-    return ((wiringPiI2CReadReg16(si1132Fd, 0x22) - 256) / 0.282) * 14.5;
+/* ALS_VIS_DATA0 .. UVINDEX1 are contiguous, the chip auto-increments
+   the register address, so a whole sample is one bus transaction */
+int Si1132_read_all(struct si1132_t *si1132, struct si1132_data_t *data) {
+    unsigned char buf[Si1132_RESULT_DATA_SIZE];
+
+    if (Si1132_read_raw(si1132, buf) < 0)
+        return -1;
+    Si1132_convert(buf, data);
+    return 0;
 }
 
-float Si1132_readIR() {
-    usleep(10000);
-    return ((wiringPiI2CReadReg16(si1132Fd, 0x24) - 250) / 2.44) * 14.5;
+/* The result block as it is in the registers, forced first in forced mode */
+int Si1132_read_raw(struct si1132_t *si1132, unsigned char *buf) {
+    if ((si1132->mode == Si1132_MODE_FORCED) && (Si1132_force(si1132) < 0))
+        return -1;
+
+    return sensor_bus_read(si1132->bus, si1132->addr, Si1132_REG_ALSVISDATA0, buf, Si1132_RESULT_DATA_SIZE) < 0 ? -1 : 0;
 }
 
-float Si1132_readUV() {
-    usleep(10000);
-    return wiringPiI2CReadReg16(si1132Fd, 0x2c);
+void Si1132_convert(const unsigned char *buf, struct si1132_data_t *data) {
+    data->visible = (((buf[Si1132_RESULT_VIS_BYTE] | (buf[Si1132_RESULT_VIS_BYTE + 1] << 8)) - 256) / 0.282) * 14.5;
+    data->ir = (((buf[Si1132_RESULT_IR_BYTE] | (buf[Si1132_RESULT_IR_BYTE + 1] << 8)) - 250) / 2.44) * 14.5;
+    data->uv = (buf[Si1132_RESULT_UV_BYTE] | (buf[Si1132_RESULT_UV_BYTE + 1] << 8)) / 100.0;
 }
 
-void Si1132_I2C_writeParam(unsigned char param, unsigned char val) {
-    wiringPiI2CWriteReg8(si1132Fd, Si1132_REG_PARAMWR, val);
-    wiringPiI2CWriteReg8(si1132Fd, Si1132_REG_COMMAND, param |
-                         Si1132_PARAM_SET);
+/* PARAMWR and COMMAND are adjacent, the value and the PARAM_SET
+   command go out in one transaction */
+int Si1132_I2C_writeParam(struct si1132_t *si1132, unsigned char param, unsigned char val) {
+    unsigned char buf[] = {val, param | Si1132_PARAM_SET};
+    int prev;
+
+    if ((prev = Si1132_I2C_read8(si1132, Si1132_REG_RESPONSE)) < 0)
+        return -1;
+    if (Si1132_I2C_writeBlock(si1132, Si1132_REG_PARAMWR, buf, sizeof(buf)) < 0)
+        return -1;
+    return Si1132_I2C_waitResponse(si1132, prev);
 }
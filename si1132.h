@@ -1,3 +1,5 @@
+#ifndef SI1132_H_INCLUDED
+#define SI1132_H_INCLUDED
 /* COMMANDS */
 #define Si1132_PARAM_QUERY	0x80
 #define Si1132_PARAM_SET	0xA0
@@ -47,6 +49,7 @@
 
 #define Si1132_REG_IRQEN	0x04
 #define Si1132_REG_IRQEN_ALSEVERYSAMPLE 0x01
+#define Si1132_REG_IRQSTAT_ALS	0x01
 
 #define Si1132_REG_IRQMODE1	0x05
 #define Si1132_REG_IRQMODE2	0x06
@@ -74,14 +77,60 @@
 
 #define Si1132_ADDR 0x60
 
-int si1132Fd;
-
-int si1132_begin(const char *device);
-void initialize(void);
-void reset();
-
-float Si1132_readVisible();
-float Si1132_readIR();
-float Si1132_readUV();
-
-void Si1132_I2C_writeParam(unsigned char param, unsigned char val);
+#define Si1132_HWKEY		0x17
+#define Si1132_RESPONSE_ERROR	0x80
+
+/* Command completion is polled, not slept for */
+#define Si1132_POLL_INTERVAL_US	100
+#define Si1132_CMD_TIMEOUT_US	25000
+#define Si1132_RESET_TIMEOUT_US	25000
+
+/* Forced measurements: ALS_FORCE, then wait for the ALS interrupt,
+   from the INT line when there is one, else by polling IRQ_STATUS */
+#define Si1132_MODE_AUTO	0
+#define Si1132_MODE_FORCED	1
+/* one ALS channel with the 511 clock ADC counter */
+#define Si1132_ALS_CHANNEL_TYP_US	1000
+#define Si1132_FORCE_TIMEOUT_US	50000
+
+#include "sensor-bus.h"
+
+/* Result block read by Si1132_read_all, ALS_VIS_DATA0 to UVINDEX1 */
+#define Si1132_RESULT_DATA_SIZE	(Si1132_REG_UVINDEX1 - Si1132_REG_ALSVISDATA0 + 1)
+#define Si1132_RESULT_VIS_BYTE	(Si1132_REG_ALSVISDATA0 - Si1132_REG_ALSVISDATA0)
+#define Si1132_RESULT_IR_BYTE	(Si1132_REG_ALSIRDATA0 - Si1132_REG_ALSVISDATA0)
+#define Si1132_RESULT_UV_BYTE	(Si1132_REG_UVINDEX0 - Si1132_REG_ALSVISDATA0)
+
+struct si1132_data_t {
+    float visible;  /* Lux */
+    float ir;       /* Lux */
+    float uv;       /* UV index */
+};
+
+struct si1132_t {
+    struct sensor_bus_t *bus;
+    unsigned char addr;
+    unsigned char mode;         /* Si1132_MODE_AUTO or Si1132_MODE_FORCED */
+    unsigned char channels;     /* enabled in CHLIST */
+    int irq_fd;                 /* INT line value fd, -1 without */
+    uint32_t conv_usec;         /* duration of the last forced measurement */
+};
+
+/* irq_gpio is the sysfs GPIO wired to INT, -1 to poll IRQ_STATUS instead */
+int si1132_begin(struct si1132_t *si1132, struct sensor_bus_t *bus, unsigned char mode, int irq_gpio);
+void si1132_end(struct si1132_t *si1132);
+int initialize(struct si1132_t *si1132);
+int reset(struct si1132_t *si1132);
+
+float Si1132_readVisible(struct si1132_t *si1132);
+float Si1132_readIR(struct si1132_t *si1132);
+float Si1132_readUV(struct si1132_t *si1132);
+int Si1132_read_all(struct si1132_t *si1132, struct si1132_data_t *data);
+/* Si1132_RESULT_DATA_SIZE bytes from ALS_VIS_DATA0, and their conversion */
+int Si1132_read_raw(struct si1132_t *si1132, unsigned char *buf);
+void Si1132_convert(const unsigned char *buf, struct si1132_data_t *data);
+int Si1132_force(struct si1132_t *si1132);
+
+int Si1132_I2C_writeParam(struct si1132_t *si1132, unsigned char param, unsigned char val);
+
+#endif // SI1132_H_INCLUDED
@@ -0,0 +1,543 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <math.h>
+#include <pthread.h>
+
+#include "sim-bus.h"
+#include "bme280.h"
+#include "si1132.h"
+#include "dmem.h"
+#include "dlog.h"
+
+#define SIM_BME280_COUNT        2
+#define SIM_BME280_NVM_COPY_US  2000
+/* one ALS channel conversion with the 511 clock ADC counter */
+#define SIM_SI1132_CHANNEL_US   1000
+
+struct sim_bme280_t {
+    uint8_t addr;
+    uint8_t regs[256];
+    uint64_t nvm_end;       /* NVM copy (im_update) busy until */
+    uint64_t conv_end;      /* conversion busy until, 0 when idle */
+    uint64_t next_cycle;    /* normal mode: start of the next conversion */
+    uint32_t samples;
+};
+
+struct sim_si1132_t {
+    uint8_t regs[0x40];
+    uint8_t params[0x20];
+    uint64_t conv_end;      /* forced conversion busy until, 0 when idle */
+    uint64_t next_auto;     /* autonomous mode: next conversion */
+    bool autonomous;
+};
+
+struct sim_bus_t {
+    struct sensor_bus_t bus;
+    pthread_mutex_t lock;
+    uint32_t latency;
+    uint32_t byte_time;
+    bool fast;
+    uint64_t vclock;
+    struct sim_bme280_t bme280[SIM_BME280_COUNT];
+    struct sim_si1132_t si1132;
+    /* the device at fault_addr stops answering for a while and comes
+       back out of a power-on reset */
+    uint8_t fault_addr;
+    uint64_t fault_start;
+    uint64_t fault_end;
+};
+
+/* Datasheet example trimming values, laid out as in 0x88..0xA1 and 0xE1..0xE7 */
+static const uint8_t sim_bme280_calib_tp[BME280_CALIB_DATA_SIZE] = {
+    0x70, 0x6B, 0x43, 0x67, 0x18, 0xFC,             /* T1 27504, T2 26435, T3 -1000 */
+    0x7D, 0x8E, 0x43, 0xD6, 0xD0, 0x0B,             /* P1 36477, P2 -10685, P3 3024 */
+    0x27, 0x0B, 0x8C, 0x00, 0xF9, 0xFF,             /* P4 2855, P5 140, P6 -7 */
+    0x8C, 0x3C, 0xF8, 0xC6, 0x70, 0x17,             /* P7 15500, P8 -14600, P9 6000 */
+    0x00, 0x4B                                      /* reserved, H1 75 */
+};
+
+static const uint8_t sim_bme280_calib_h[BME280_HUMIDITY_CALIB_DATA_LENGTH] = {
+    0x6A, 0x01, 0x00,                               /* H2 362, H3 0 */
+    0x13, 0x29, 0x03,                               /* H4 313, H5 50 */
+    0x1E                                            /* H6 30 */
+};
+
+static const uint32_t sim_bme280_standby_us[8] = {
+    500, 62500, 125000, 250000, 500000, 1000000, 10000, 20000
+};
+
+static uint64_t sim_now(struct sim_bus_t * sim) {
+    return sim->fast ? sim->vclock : sensor_bus_monotonic(&sim->bus);
+}
+
+static void sim_spend(struct sim_bus_t * sim, uint32_t usec) {
+    if (!usec)
+        return;
+    if (sim->fast)
+        sim->vclock += usec;
+    else
+        sensor_bus_sleep(&sim->bus, usec);
+}
+
+//------------------------------------------------------------------------------------------------------------
+//
+// BME280
+//
+//------------------------------------------------------------------------------------------------------------
+
+static uint32_t sim_bme280_osr(uint8_t code) {
+    static const uint8_t osr[8] = {0, 1, 2, 4, 8, 16, 16, 16};
+    return osr[code & 0x07];
+}
+
+/* typical measurement time, datasheet 9.1 */
+static uint64_t sim_bme280_meas_us(struct sim_bme280_t * dev) {
+    uint32_t osr_t = sim_bme280_osr(dev->regs[BME280_CTRL_MEAS_REG] >> 5);
+    uint32_t osr_p = sim_bme280_osr(dev->regs[BME280_CTRL_MEAS_REG] >> 2);
+    uint32_t osr_h = sim_bme280_osr(dev->regs[BME280_CTRL_HUMIDITY_REG]);
+
+    return 1000 + 2000 * osr_t + (osr_p ? 2000 * osr_p + 500 : 0) + (osr_h ? 2000 * osr_h + 500 : 0);
+}
+
+static void sim_bme280_latch(struct sim_bme280_t * dev, uint64_t when) {
+    double t = when / 1000000.0;
+    uint8_t * r = dev->regs;
+    int32_t noise = (int32_t)((dev->samples++ * 7919) % 17) - 8;
+    int32_t adc_t = 0x80000, adc_p = 0x80000, adc_h = 0x8000;
+
+    if (sim_bme280_osr(r[BME280_CTRL_MEAS_REG] >> 5))
+        adc_t = 519888 + (int32_t)(2000.0 * sin(t / 300.0)) + noise;
+    if (sim_bme280_osr(r[BME280_CTRL_MEAS_REG] >> 2))
+        adc_p = 415148 + (int32_t)(400.0 * sin(t / 120.0)) + 4 * noise;
+    if (sim_bme280_osr(r[BME280_CTRL_HUMIDITY_REG]))
+        adc_h = 30000 + (int32_t)(1500.0 * sin(t / 600.0)) + noise;
+
+    r[BME280_PRESSURE_MSB_REG] = adc_p >> 12;
+    r[BME280_PRESSURE_LSB_REG] = adc_p >> 4;
+    r[BME280_PRESSURE_XLSB_REG] = (adc_p << 4) & 0xF0;
+    r[BME280_TEMPERATURE_MSB_REG] = adc_t >> 12;
+    r[BME280_TEMPERATURE_LSB_REG] = adc_t >> 4;
+    r[BME280_TEMPERATURE_XLSB_REG] = (adc_t << 4) & 0xF0;
+    r[BME280_HUMIDITY_MSB_REG] = adc_h >> 8;
+    r[BME280_HUMIDITY_LSB_REG] = adc_h;
+}
+
+static void sim_bme280_reset(struct sim_bme280_t * dev, uint64_t now) {
+    uint8_t * r = dev->regs;
+
+    memset(r, 0, sizeof(dev->regs));
+    r[BME280_CHIP_ID_REG] = 0x60;
+    memcpy(&r[BME280_TEMPERATURE_CALIB_DIG_T1_LSB_REG], sim_bme280_calib_tp, sizeof(sim_bme280_calib_tp));
+    memcpy(&r[BME280_HUMIDITY_CALIB_DIG_H2_LSB_REG], sim_bme280_calib_h, sizeof(sim_bme280_calib_h));
+    r[BME280_PRESSURE_MSB_REG] = 0x80;
+    r[BME280_TEMPERATURE_MSB_REG] = 0x80;
+    r[BME280_HUMIDITY_MSB_REG] = 0x80;
+    dev->nvm_end = now + SIM_BME280_NVM_COPY_US;
+    dev->conv_end = 0;
+    dev->next_cycle = 0;
+}
+
+static void sim_bme280_update(struct sim_bme280_t * dev, uint64_t now) {
+    uint8_t mode = dev->regs[BME280_CTRL_MEAS_REG] & BME280_CTRL_MEAS_REG_POWER_MODE__MSK;
+
+    if ((dev->conv_end) && (now >= dev->conv_end)) {
+        sim_bme280_latch(dev, dev->conv_end);
+        dev->conv_end = 0;
+        if (mode != BME280_NORMAL_MODE)
+            dev->regs[BME280_CTRL_MEAS_REG] &= ~BME280_CTRL_MEAS_REG_POWER_MODE__MSK;
+    }
+    if ((mode == BME280_NORMAL_MODE) && (!dev->conv_end) && (now >= dev->next_cycle)) {
+        uint64_t meas = sim_bme280_meas_us(dev);
+        uint64_t period = meas + sim_bme280_standby_us[dev->regs[BME280_CONFIG_REG] >> 5];
+        uint64_t start = dev->next_cycle + ((now - dev->next_cycle) / period) * period;
+
+        dev->conv_end = start + meas;
+        dev->next_cycle = start + period;
+        if (now >= dev->conv_end) {
+            sim_bme280_latch(dev, dev->conv_end);
+            dev->conv_end = 0;
+        }
+    }
+    dev->regs[BME280_STAT_REG] = (dev->conv_end ? BME280_STAT_REG_MEASURING__MSK : 0) |
+                                 ((now < dev->nvm_end) ? BME280_STAT_REG_IM_UPDATE__MSK : 0);
+}
+
+/* writes are (register, value) pairs */
+static void sim_bme280_write(struct sim_bme280_t * dev, const uint8_t * data, uint16_t len, uint64_t now) {
+    sim_bme280_update(dev, now);
+    for (uint16_t i = 0; i + 1 < len; i += 2) {
+        uint8_t reg = data[i], val = data[i + 1];
+
+        switch (reg) {
+        case BME280_RST_REG:
+            if (val == BME280_SOFT_RESET_CODE)
+                sim_bme280_reset(dev, now);
+            break;
+        case BME280_CTRL_HUMIDITY_REG:
+            dev->regs[reg] = val & BME280_CTRL_HUMIDITY_REG_OVERSAMP_HUMIDITY__MSK;
+            break;
+        case BME280_CTRL_MEAS_REG:
+            dev->regs[reg] = val;
+            switch (val & BME280_CTRL_MEAS_REG_POWER_MODE__MSK) {
+            case BME280_SLEEP_MODE:
+                dev->conv_end = 0;
+                break;
+            case BME280_NORMAL_MODE:
+                dev->conv_end = 0;
+                dev->next_cycle = now;
+                break;
+            default:
+                dev->conv_end = now + sim_bme280_meas_us(dev);
+                break;
+            }
+            break;
+        case BME280_CONFIG_REG:
+            /* config writes are ignored in normal mode */
+            if ((dev->regs[BME280_CTRL_MEAS_REG] & BME280_CTRL_MEAS_REG_POWER_MODE__MSK) != BME280_NORMAL_MODE)
+                dev->regs[reg] = val & 0xFD;
+            break;
+        default:
+            break;
+        }
+    }
+    sim_bme280_update(dev, now);
+}
+
+static void sim_bme280_read(struct sim_bme280_t * dev, uint8_t reg, uint8_t * data, uint16_t len, uint64_t now) {
+    sim_bme280_update(dev, now);
+    for (uint16_t i = 0; i < len; i++) {
+        data[i] = (reg + i <= 0xFF) ? dev->regs[reg + i] : 0;
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------
+//
+// Si1132
+//
+//------------------------------------------------------------------------------------------------------------
+
+static void sim_si1132_reset(struct sim_si1132_t * dev) {
+    memset(dev->regs, 0, sizeof(dev->regs));
+    memset(dev->params, 0, sizeof(dev->params));
+    dev->regs[Si1132_REG_PARTID] = 0x32;
+    dev->regs[Si1132_REG_SEQID] = 0x08;
+    dev->params[Si1132_PARAM_I2CADDR] = Si1132_ADDR;
+    dev->conv_end = 0;
+    dev->autonomous = false;
+}
+
+static uint32_t sim_si1132_channels(struct sim_si1132_t * dev) {
+    uint8_t chlist = dev->params[Si1132_PARAM_CHLIST];
+
+    return !!(chlist & Si1132_PARAM_CHLIST_ENALSVIS) + !!(chlist & Si1132_PARAM_CHLIST_ENALSIR) +
+           !!(chlist & Si1132_PARAM_CHLIST_ENUV);
+}
+
+static void sim_si1132_latch(struct sim_si1132_t * dev, uint64_t when) {
+    double t = when / 1000000.0;
+    uint8_t chlist = dev->params[Si1132_PARAM_CHLIST];
+    uint16_t vis = 300 + (int)(40.0 * sin(t / 900.0));
+    uint16_t ir = 280 + (int)(20.0 * sin(t / 900.0));
+    uint16_t uv = 150 + (int)(50.0 * sin(t / 1800.0));
+
+    if (chlist & Si1132_PARAM_CHLIST_ENALSVIS) {
+        dev->regs[Si1132_REG_ALSVISDATA0] = vis;
+        dev->regs[Si1132_REG_ALSVISDATA1] = vis >> 8;
+    }
+    if (chlist & Si1132_PARAM_CHLIST_ENALSIR) {
+        dev->regs[Si1132_REG_ALSIRDATA0] = ir;
+        dev->regs[Si1132_REG_ALSIRDATA1] = ir >> 8;
+    }
+    if (chlist & Si1132_PARAM_CHLIST_ENUV) {
+        dev->regs[Si1132_REG_UVINDEX0] = uv;
+        dev->regs[Si1132_REG_UVINDEX1] = uv >> 8;
+    }
+    if (dev->regs[Si1132_REG_IRQEN] & Si1132_REG_IRQEN_ALSEVERYSAMPLE)
+        dev->regs[Si1132_REG_IRQSTAT] |= Si1132_REG_IRQEN_ALSEVERYSAMPLE;
+}
+
+static void sim_si1132_update(struct sim_si1132_t * dev, uint64_t now) {
+    if ((dev->conv_end) && (now >= dev->conv_end)) {
+        sim_si1132_latch(dev, dev->conv_end);
+        dev->conv_end = 0;
+    }
+    if (dev->autonomous) {
+        /* MEASRATE is in 31.25 usec steps */
+        uint64_t period = ((dev->regs[Si1132_REG_MEASRATE1] << 8) | dev->regs[Si1132_REG_MEASRATE0]) * 125 / 4;
+
+        if ((period) && (now >= dev->next_auto)) {
+            sim_si1132_latch(dev, now);
+            dev->next_auto = now + period;
+        }
+    }
+}
+
+static void sim_si1132_command(struct sim_si1132_t * dev, uint8_t cmd, uint64_t now) {
+    uint8_t response = dev->regs[Si1132_REG_RESPONSE];
+
+    if (cmd == Si1132_NOP) {
+        dev->regs[Si1132_REG_RESPONSE] = 0;
+        return;
+    }
+    if (cmd == Si1132_RESET) {
+        sim_si1132_reset(dev);
+        return;
+    }
+    /* the sequencer runs only after the hardware key is written */
+    if (dev->regs[Si1132_REG_HWKEY] != Si1132_HWKEY)
+        return;
+
+    switch (cmd & 0xE0) {
+    case Si1132_PARAM_QUERY:
+        dev->regs[Si1132_REG_PARAMRD] = dev->params[cmd & 0x1F];
+        break;
+    case Si1132_PARAM_SET:
+        dev->params[cmd & 0x1F] = dev->regs[Si1132_REG_PARAMWR];
+        dev->regs[Si1132_REG_PARAMRD] = dev->params[cmd & 0x1F];
+        break;
+    default:
+        switch (cmd) {
+        case Si1132_ALS_FORCE:
+            dev->conv_end = now + SIM_SI1132_CHANNEL_US * sim_si1132_channels(dev);
+            break;
+        case Si1132_ALS_AUTO:
+            dev->autonomous = true;
+            dev->next_auto = now;
+            break;
+        case Si1132_ALS_PAUSE:
+            dev->autonomous = false;
+            break;
+        case Si1132_BUSADDR:
+        case Si1132_GET_CAL:
+            break;
+        default:
+            /* invalid command */
+            dev->regs[Si1132_REG_RESPONSE] = 0x80;
+            return;
+        }
+        break;
+    }
+    dev->regs[Si1132_REG_RESPONSE] = (response + 1) & 0x0F;
+}
+
+/* writes are a register address followed by data, auto-incremented */
+static void sim_si1132_write(struct sim_si1132_t * dev, const uint8_t * data, uint16_t len, uint64_t now) {
+    sim_si1132_update(dev, now);
+    for (uint16_t i = 1; i < len; i++) {
+        uint8_t reg = (data[0] + i - 1) & 0x3F;
+
+        switch (reg) {
+        case Si1132_REG_PARTID:
+        case Si1132_REG_REVID:
+        case Si1132_REG_SEQID:
+        case Si1132_REG_RESPONSE:
+            break;
+        case Si1132_REG_IRQSTAT:
+            dev->regs[reg] &= ~data[i];
+            break;
+        case Si1132_REG_COMMAND:
+            dev->regs[reg] = data[i];
+            sim_si1132_command(dev, data[i], now);
+            break;
+        default:
+            if (reg < Si1132_REG_RESPONSE)
+                dev->regs[reg] = data[i];
+            break;
+        }
+    }
+}
+
+static void sim_si1132_read(struct sim_si1132_t * dev, uint8_t reg, uint8_t * data, uint16_t len, uint64_t now) {
+    sim_si1132_update(dev, now);
+    for (uint16_t i = 0; i < len; i++) {
+        data[i] = dev->regs[(reg + i) & 0x3F];
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------
+//
+// Bus
+//
+//------------------------------------------------------------------------------------------------------------
+
+static struct sim_bme280_t * sim_find_bme280(struct sim_bus_t * sim, uint8_t dev_addr) {
+    for (int i = 0; i < SIM_BME280_COUNT; i++) {
+        if (sim->bme280[i].addr == dev_addr)
+            return &sim->bme280[i];
+    }
+    return NULL;
+}
+
+/* call with sim->lock held */
+static bool sim_faulty(struct sim_bus_t * sim, uint8_t dev_addr) {
+    uint64_t now = sim_now(sim);
+    struct sim_bme280_t * bme280;
+
+    if ((!sim->fault_end) || (dev_addr != sim->fault_addr) || (now < sim->fault_start))
+        return false;
+    if (now < sim->fault_end) {
+        errno = EREMOTEIO;
+        return true;
+    }
+    if ((bme280 = sim_find_bme280(sim, dev_addr)) != NULL) {
+        sim_bme280_reset(bme280, now);
+    } else if (dev_addr == Si1132_ADDR) {
+        sim_si1132_reset(&sim->si1132);
+    }
+    sim->fault_end = 0;
+    return false;
+}
+
+/* call with sim->lock held */
+static int sim_read_locked(struct sim_bus_t * sim, uint8_t dev_addr, uint8_t reg_addr, uint8_t * data, uint16_t len) {
+    struct sim_bme280_t * bme280;
+
+    sim_spend(sim, sim->byte_time * (len + 2));
+    if (sim_faulty(sim, dev_addr))
+        return -1;
+    if ((bme280 = sim_find_bme280(sim, dev_addr)) != NULL) {
+        sim_bme280_read(bme280, reg_addr, data, len, sim_now(sim));
+    } else if (dev_addr == Si1132_ADDR) {
+        sim_si1132_read(&sim->si1132, reg_addr, data, len, sim_now(sim));
+    } else {
+        errno = ENXIO;
+        return -1;
+    }
+    return 0;
+}
+
+static int sim_bus_read(struct sensor_bus_t * bus, uint8_t dev_addr, uint8_t reg_addr, uint8_t * data, uint16_t len) {
+    struct sim_bus_t * sim = (struct sim_bus_t *)bus;
+    int ret;
+
+    pthread_mutex_lock(&sim->lock);
+    sim_spend(sim, sim->latency);
+    ret = sim_read_locked(sim, dev_addr, reg_addr, data, len);
+    pthread_mutex_unlock(&sim->lock);
+    return ret;
+}
+
+/* a batch costs the transaction latency once, like one I2C_RDWR */
+static int sim_bus_read_many(struct sensor_bus_t * bus, struct sensor_bus_xfer_t ** xfers, int count) {
+    struct sim_bus_t * sim = (struct sim_bus_t *)bus;
+    int ret = 0;
+
+    pthread_mutex_lock(&sim->lock);
+    sim_spend(sim, sim->latency);
+    for (int i = 0; (i < count) && (ret == 0); i++) {
+        ret = sim_read_locked(sim, xfers[i]->dev_addr, xfers[i]->reg_addr, xfers[i]->data, xfers[i]->len);
+    }
+    pthread_mutex_unlock(&sim->lock);
+    return ret;
+}
+
+static int sim_bus_write(struct sensor_bus_t * bus, uint8_t dev_addr, const uint8_t * data, uint16_t len) {
+    struct sim_bus_t * sim = (struct sim_bus_t *)bus;
+    struct sim_bme280_t * bme280;
+    int ret = 0;
+
+    pthread_mutex_lock(&sim->lock);
+    sim_spend(sim, sim->latency + sim->byte_time * (len + 1));
+    if (sim_faulty(sim, dev_addr)) {
+        ret = -1;
+    } else if ((bme280 = sim_find_bme280(sim, dev_addr)) != NULL) {
+        sim_bme280_write(bme280, data, len, sim_now(sim));
+    } else if (dev_addr == Si1132_ADDR) {
+        sim_si1132_write(&sim->si1132, data, len, sim_now(sim));
+    } else {
+        errno = ENXIO;
+        ret = -1;
+    }
+    pthread_mutex_unlock(&sim->lock);
+    return ret;
+}
+
+static void sim_bus_delay(struct sensor_bus_t * bus, uint32_t usec) {
+    struct sim_bus_t * sim = (struct sim_bus_t *)bus;
+
+    if (sim->fast) {
+        pthread_mutex_lock(&sim->lock);
+        sim->vclock += usec;
+        pthread_mutex_unlock(&sim->lock);
+    } else {
+        sensor_bus_sleep(bus, usec);
+    }
+}
+
+static uint64_t sim_bus_clock(struct sensor_bus_t * bus) {
+    struct sim_bus_t * sim = (struct sim_bus_t *)bus;
+    uint64_t now;
+
+    pthread_mutex_lock(&sim->lock);
+    now = sim_now(sim);
+    pthread_mutex_unlock(&sim->lock);
+    return now;
+}
+
+static void sim_bus_close(struct sensor_bus_t * bus) {
+    struct sim_bus_t * sim = (struct sim_bus_t *)bus;
+
+    pthread_mutex_destroy(&sim->lock);
+    FREE(bus->name);
+    xfree(sim);
+}
+
+static const struct sensor_bus_ops_t sim_bus_ops = {
+    read: sim_bus_read,
+    write: sim_bus_write,
+    read_many: sim_bus_read_many,
+    delay: sim_bus_delay,
+    clock: sim_bus_clock,
+    close: sim_bus_close,
+};
+
+struct sensor_bus_t * sim_bus_open(const char * options) {
+    struct sim_bus_t * sim = xmalloc(sizeof(*sim));
+    char * opts = xstrdup(options);
+    char * save = NULL;
+
+    memset(sim, 0, sizeof(*sim));
+    for (char * opt = strtok_r(opts, ",", &save); opt; opt = strtok_r(NULL, ",", &save)) {
+        if (strncmp(opt, "latency=", 8) == 0) {
+            sim->latency = strtoul(opt + 8, NULL, 0);
+        } else if (strncmp(opt, "byte=", 5) == 0) {
+            sim->byte_time = strtoul(opt + 5, NULL, 0);
+        } else if (strcmp(opt, "fast") == 0) {
+            sim->fast = true;
+        } else if (strncmp(opt, "fault=", 6) == 0) {
+            unsigned int addr, start, len;
+
+            if (sscanf(opt + 6, "%i/%u/%u", &addr, &start, &len) == 3) {
+                sim->fault_addr = addr;
+                sim->fault_start = start * 1000ULL;
+                sim->fault_end = (start + len) * 1000ULL;
+            } else {
+                daemon_log(LOG_WARNING, "%s bad fault %s", __FUNCTION__, opt);
+            }
+        } else {
+            daemon_log(LOG_WARNING, "%s unknown option %s", __FUNCTION__, opt);
+        }
+    }
+    FREE(opts);
+
+    sim->bus.ops = &sim_bus_ops;
+    sim->bus.name = xstrdup(options[0] ? options : "sim");
+    pthread_mutex_init(&sim->lock, NULL);
+    sim->vclock = sensor_bus_monotonic(&sim->bus);
+    sim->fault_start += sim->vclock;
+    sim->fault_end += sim->fault_end ? sim->vclock : 0;
+    sim->bme280[0].addr = BME280_I2C_ADDRESS1;
+    sim->bme280[1].addr = BME280_I2C_ADDRESS2;
+    for (int i = 0; i < SIM_BME280_COUNT; i++) {
+        sim_bme280_reset(&sim->bme280[i], 0);
+    }
+    sim_si1132_reset(&sim->si1132);
+
+    daemon_log(LOG_INFO, "simulated bus latency %u us, %u us/byte%s", sim->latency, sim->byte_time,
+               sim->fast ? ", virtual time" : "");
+    return &sim->bus;
+}
@@ -0,0 +1,21 @@
+#ifndef SIM_BUS_H_INCLUDED
+#define SIM_BUS_H_INCLUDED
+#include "sensor-bus.h"
+
+/* In-memory bus with a BME280 on 0x76 and 0x77 and a Si1132 on 0x60.
+ * The devices emulate their register maps, calibration data, status
+ * bits and conversion times, so the whole sampling pipeline runs on
+ * a plain Linux box.
+ *
+ * Options, comma separated:
+ *   latency=<usec>   time spent on every transaction (default 0)
+ *   byte=<usec>      additional time per transferred byte (default 0)
+ *   fast             virtual time: delays and latency advance the bus
+ *                    clock instead of sleeping
+ *   fault=<addr>/<start>/<len>
+ *                    the device at addr NACKs from start ms after open
+ *                    for len ms, then comes back out of reset
+ */
+struct sensor_bus_t * sim_bus_open(const char * options);
+
+#endif // SIM_BUS_H_INCLUDED
@@ -0,0 +1,179 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "capture.h"
+#include "bme280-altitude.h"
+#include "metrics.h"
+
+/* Offline compensation of a raw capture (weather_board -F raw:file),
+ * one JSON line per BME280 frame, in the format of -F json.
+ *
+ *   wb_raw [-c int32|int64|double] [-s sea_level_hPa] [-M metrics] [-A station_altitude] [file]
+ */
+
+struct device_t {
+    struct bme280_t bme280;
+    struct metrics_cache_t metrics_cache;
+    int valid;
+};
+
+static struct capture_header_t header;
+static struct device_t devices[CAPTURE_MAX_SLOTS][CAPTURE_MAX_BME280];
+/* records leave out the devices that had no channel due, the light
+   values carry over to the frames that follow */
+static struct si1132_data_t light[CAPTURE_MAX_SLOTS];
+static u8 compensation = BME280_COMPENSATION_DEFAULT;
+static float sea_level = 1024.25;
+static unsigned int metrics_mask = 0;
+static float sea_level_factor = 1;
+
+static void usage(const char * progname) {
+    fprintf(stderr, "Usage: %s [-c int32|int64|double] [-s sea_level_hPa] [-M dew_point,heat_index,absolute_humidity,sea_level|all] [-A station_altitude] [file]\n", progname);
+    exit(1);
+}
+
+/* the devices of a new segment, record frames are compensated with these */
+static int load_header() {
+    if ((header.version != CAPTURE_VERSION) || (header.header_size != sizeof(header)) ||
+            (header.record_size != sizeof(struct capture_record_t)) || (header.slot_count > CAPTURE_MAX_SLOTS)) {
+        fprintf(stderr, "unsupported capture version %u\n", header.version);
+        return -1;
+    }
+    memset(devices, 0, sizeof(devices));
+    memset(light, 0, sizeof(light));
+    for (int s = 0; s < header.slot_count; s++) {
+        header.slot[s].bus[CAPTURE_BUS_SIZE - 1] = 0;
+        for (int i = 0; (i < header.slot[s].bme280_count) && (i < CAPTURE_MAX_BME280); i++) {
+            struct device_t * device = &devices[s][i];
+
+            if (!header.slot[s].bme280[i].valid)
+                continue;
+            device->bme280.dev_addr = header.slot[s].bme280[i].addr;
+            device->bme280.chip_id = header.slot[s].bme280[i].chip_id;
+            capture_calib_unpack(&device->bme280.cal_param, &header.slot[s].bme280[i].calib);
+            bme280_compute_coefficients(&device->bme280);
+            if (bme280_set_compensation(&device->bme280, compensation) != SUCCESS) {
+                fprintf(stderr, "compensation backend %u not built in\n", compensation);
+                return -1;
+            }
+            device->valid = 1;
+        }
+    }
+    return 0;
+}
+
+static void out_record(const struct capture_record_t * record) {
+    const struct capture_slot_t * slot;
+    char buffer[32];
+    char derived[160];
+
+    if (record->slot >= header.slot_count)
+        return;
+    slot = &header.slot[record->slot];
+    if (record->flags & CAPTURE_SI1132_OK)
+        Si1132_convert(record->si1132, &light[record->slot]);
+    capture_format_time(buffer, sizeof(buffer), record->time_usec, record->flags & CAPTURE_TIME_MSEC);
+
+    for (int i = 0; (i < slot->bme280_count) && (i < CAPTURE_MAX_BME280); i++) {
+        struct device_t * device = &devices[record->slot][i];
+        struct metrics_t metrics = {};
+        s32 up, ut, uh, temperature;
+        u32 pressure, humidity;
+
+        if ((!(record->flags & CAPTURE_BME280_OK(i))) || (!device->valid))
+            continue;
+        bme280_decode_data_frame(record->bme280[i], &up, &ut, &uh);
+        bme280_compensate_pressure_temperature_humidity(&device->bme280, up, ut, uh,
+            &pressure, &temperature, &humidity);
+        if (metrics_mask)
+            metrics_compute(&device->metrics_cache, metrics_mask, sea_level_factor, temperature, humidity, pressure,
+                            &metrics);
+        metrics_json(derived, sizeof(derived), metrics_mask, &metrics);
+        printf("{\"time\": \"%s\", \"brand\": \"ODROID\", \"model\": \"WB2\", \"id\": 0, \"channel\": 1, \"battery\": \"OK\", \
+\"bus\": \"%s\", \"address\": \"0x%02x\", \
+\"temperature_C\": %.2lf, \"humidity\": %.2lf, \"pressure\": %.2lf, \"altitude\": %f, \
+\"uv_index\": %.2f, \"visible\": %.0f, \"ir\": %.0f%s}\n", buffer, slot->bus, device->bme280.dev_addr,
+               (double)temperature / 100.0, (double)humidity / 1024.0, (double)pressure / 100.0,
+               bme280_altitude(pressure, sea_level), light[record->slot].uv, light[record->slot].visible, light[record->slot].ir, derived);
+    }
+}
+
+int main(int argc, char ** argv) {
+    FILE * in = stdin;
+    uint32_t magic;
+    unsigned long records = 0, skipped = 0;
+    int flags;
+    int mask;
+    int complete;
+
+    while ((flags = getopt(argc, argv, "c:s:M:A:")) != -1) {
+        switch (flags) {
+        case 'c':
+            if (strcmp(optarg, "int32") == 0) {
+                compensation = BME280_COMPENSATION_INT32;
+            } else if (strcmp(optarg, "int64") == 0) {
+                compensation = BME280_COMPENSATION_INT64;
+            } else if (strcmp(optarg, "double") == 0) {
+                compensation = BME280_COMPENSATION_DOUBLE;
+            } else {
+                usage(argv[0]);
+            }
+            break;
+        case 's':
+            sea_level = atof(optarg);
+            break;
+        case 'M':
+            if ((mask = metrics_parse(optarg)) < 0)
+                usage(argv[0]);
+            metrics_mask = mask;
+            break;
+        case 'A':
+            sea_level_factor = metrics_sea_level_factor(atof(optarg));
+            break;
+        default:
+            usage(argv[0]);
+        }
+    }
+    if ((optind < argc) && (strcmp(argv[optind], "-") != 0) && ((in = fopen(argv[optind], "rb")) == NULL)) {
+        perror(argv[optind]);
+        return 1;
+    }
+
+    while (fread(&magic, sizeof(magic), 1, in) == 1) {
+        if (magic == CAPTURE_MAGIC_HEADER) {
+            header.magic = magic;
+            if ((fread((char *)&header + sizeof(magic), sizeof(header) - sizeof(magic), 1, in) != 1) ||
+                    (load_header() < 0))
+                break;
+        } else if (magic == CAPTURE_MAGIC_RECORD) {
+            struct capture_record_t record = {magic: magic};
+
+            if (fread((char *)&record + sizeof(magic), sizeof(record) - sizeof(magic), 1, in) != 1)
+                break;
+            if (header.magic != CAPTURE_MAGIC_HEADER) {
+                skipped++;
+                continue;
+            }
+            out_record(&record);
+            records++;
+        } else {
+            if ((magic == __builtin_bswap32(CAPTURE_MAGIC_HEADER)) || (magic == __builtin_bswap32(CAPTURE_MAGIC_RECORD)))
+                fprintf(stderr, "capture is in the other byte order\n");
+            else
+                fprintf(stderr, "not a capture, or a truncated one\n");
+            break;
+        }
+    }
+    complete = feof(in);
+    if (!complete)
+        fprintf(stderr, "stopped after %lu records\n", records);
+    if (skipped)
+        fprintf(stderr, "%lu records before the first header skipped\n", skipped);
+    if (in != stdin)
+        fclose(in);
+    return complete ? 0 : 1;
+}
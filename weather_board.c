@@ -5,6 +5,7 @@
 #include <unistd.h>
 #include <errno.h>
 #include <time.h>
+#include <math.h>
 #include <signal.h>
 #include <stdbool.h>
 #include <pthread.h>
@@ -15,9 +16,15 @@
 #include <sys/wait.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/timerfd.h>
+#include <sys/eventfd.h>
 
-#include "bme280-i2c.h"
-#include "si1132.h"
+#include "board.h"
+#include "bme280-altitude.h"
+#include "metrics.h"
+#include "capture.h"
+#include "reactor.h"
+#include "control.h"
 
 #include "dpid.h"
 #include "dmem.h"
@@ -26,17 +33,56 @@
 #include "dsignal.h"
 #include "version.h"
 
-static int pressure;
-static int temperature;
-static int humidity;
+static struct board_config_t board_config = {
+    power_mode: BME280_NORMAL_MODE,
+    forced_wait: BME280_FORCED_WAIT_FIXED,
+    calib_dir: "/var/cache/weather_board",
+    si1132_mode: Si1132_MODE_FORCED,
+    compensation: BME280_COMPENSATION_DEFAULT,
+    profile: BME280_PROFILE_DEFAULT,
+};
+static struct board_t ** boards = NULL;
+static int boards_count = 0;
+static int pending_gpio = -1;
+static uint64_t sample_period = 20000000ULL;   /* usec, -p */
+/* per channel, -P, the ones left at 0 take sample_period */
+static uint64_t channel_period[BOARD_CH_COUNT] = {};
+/* adaptive sampling, -a is the fastest period, 0 keeps the periods
+   fixed, the slowest is the -p or -P one. -t, in the units of the
+   output, what counts as a move over the slowest period */
+static uint64_t adapt_min_period = 0;
+/* a period under a second, the output time has milliseconds */
+static bool out_msec = false;
+static float channel_threshold[BOARD_CH_COUNT] = {
+    [BOARD_CH_TEMPERATURE] = 0.2,
+    [BOARD_CH_PRESSURE] = 0.2,
+    [BOARD_CH_HUMIDITY] = 2,
+    [BOARD_CH_VISIBLE] = 100,
+    [BOARD_CH_IR] = 100,
+    [BOARD_CH_UV] = 0.5,
+};
+/* readable once the workers are to stop */
+static int exit_fd = -1;
+static struct reactor_t * main_reactor = NULL;
+static char * control_socket = NULL;
+static int control_fd = -1;
 
 #define  O_TEXT 0
 #define  O_JSON 1
+#define  O_RAW  2
 
 float SEALEVELPRESSURE_HPA = 1024.25;
+/* derived metrics in the output, -M, and the station altitude for QNH, -A */
+static unsigned int metrics_mask = 0;
+static float station_altitude = 0;
+static float sea_level_factor = 1;
 static int out_format = O_TEXT;
 static char * out_filename = NULL;
 static FILE * out_file = NULL;
+static pthread_mutex_t out_lock = PTHREAD_MUTEX_INITIALIZER;
+/* the header of the capture segment being written, under out_lock */
+static struct capture_header_t capture_header;
+static bool capture_header_written = false;
 
 #define HOSTNAME_SIZE 256
 #define CDIR "./"
@@ -48,7 +94,7 @@ static const char * const application = "weather_board";
 static int do_exit = 0;
 
 static void usage() {
-    fprintf(stderr, "Usage: %s [-d ] [-f] [-p integer] [-k command] [-w integer] \n", progname);
+    fprintf(stderr, "Usage: %s [-d ] [-f] [-F text|json|raw[:file]] [-p period[ms|s|m|h|Hz]] [-P temperature|pressure|humidity|visible|ir|uv=period,...] [-a period] [-t channel=threshold,...] [-k command] [-w integer] [-D /dev/i2c-N|sim[:options]][@0x76[,0x77]] ... [-S normal|forced|poll] [-C calib_dir|-] [-L auto|forced] [-g gpio] [-c int32|int64|double] [-o default|low-latency|low-noise|indoor|weather] [-M dew_point,heat_index,absolute_humidity,sea_level|all] [-A station_altitude]\n", progname);
     exit(1);
 }
 
@@ -65,6 +111,7 @@ enum command_int_t {
     CMD_SHUTDOWN,
     CMD_RESTART,
     CMD_CHECK,
+    CMD_PROFILE,
     CMD_NOT_FOUND = -1,
 };
 
@@ -112,11 +159,34 @@ int restart_callback(void * UNUSED(param)) {
     return(0);
 }
 
+/* -k profile:name, switches the BME280 of every board */
+int profile_callback(void * param) {
+    const char * name = param;
+    char command[CONTROL_MAX_COMMAND];
+    char * path;
+
+    if ((!name) || (!bme280_profile_find(name))) {
+        daemon_log(LOG_ERR, "Unknown profile %s", name ? name : "");
+        return(11);
+    }
+    snprintf(command, sizeof(command), "profile %s", name);
+    path = control_path(daemon_pid_file_proc());
+    if (control_send(path, command) < 0) {
+        daemon_log(LOG_WARNING, "Failed to send %s to %s (%d) %s", command, path, errno, strerror(errno));
+        FREE(path);
+        return(11);
+    }
+    daemon_log(LOG_INFO, "OK");
+    FREE(path);
+    return(10);
+}
+
 DAEMON_COMMAND_T daemon_commands[] = {
     {command_name: "reconfigure", command_callback: reconfigure_callback, command_int: CMD_RECONFIGURE},
     {command_name: "shutdown", command_callback: shutdown_callback, command_int: CMD_SHUTDOWN},
     {command_name: "restart", command_callback: restart_callback, command_int: CMD_RESTART},
     {command_name: "check", command_callback: check_callback, command_int: CMD_CHECK},
+    {command_name: "profile", command_callback: profile_callback, command_int: CMD_PROFILE},
 };
 
 char *arg_param(char *arg) {
@@ -132,7 +202,20 @@ void open_outfile() {
     if ((!out_filename) || (!*out_filename) || (strcmp(out_filename, "-") == 0)) { /* Write samples to stdout */
         out_file = stdout;
     } else {
-        out_file = fopen(out_filename, "a");
+        out_file = fopen(out_filename, (out_format == O_RAW) ? "ab" : "a");
+    }
+    if (out_format == O_RAW) {
+        /* a new file starts with a header of its own */
+        capture_header_init(&capture_header);
+        capture_header.slot_count = boards_count;
+        for (int i = 0; i < boards_count; i++) {
+            struct capture_slot_t * slot = &capture_header.slot[i];
+            snprintf(slot->bus, sizeof(slot->bus), "%s", boards[i]->device);
+            slot->bme280_count = boards[i]->bme280_count;
+            for (int j = 0; j < boards[i]->bme280_count; j++)
+                slot->bme280[j].addr = boards[i]->bme280[j].dev_addr;
+        }
+        capture_header_written = false;
     }
     if (!out_file) {
         daemon_log(LOG_ERR, "Unable to open out file %s %d %s", out_filename, errno, strerror(errno));
@@ -144,85 +227,533 @@ void open_outfile() {
 }
 
 void close_outfile() {
-    fclose(out_file);
+    if (out_file)
+        fclose(out_file);
     out_file = NULL;
 }
 
-void out_text() {
-    fprintf(out_file, "\e[H======== si1132 ========\n");
-    fprintf(out_file, "UV_index : %.2f\e[K\n", Si1132_readUV() / 100.0);
-    fprintf(out_file, "Visible : %.0f Lux\e[K\n", Si1132_readVisible());
-    fprintf(out_file, "IR : %.0f Lux\e[K\n", Si1132_readIR());
-
-    if (bme280_read_pressure_temperature_humidity(
-                (u32*)&pressure, &temperature, (u32*)&humidity) == -1) {
-        daemon_log(LOG_ERR, "%s Error communication with bme280", __FUNCTION__);
-    }
-    fprintf(out_file, "======== bme280 ========\n");
-    fprintf(out_file, "temperature : %.2lf 'C\e[K\n", (double)temperature / 100.0);
-    fprintf(out_file, "humidity : %.2lf %%\e[K\n",	(double)humidity / 1024.0);
-    fprintf(out_file, "pressure : %.2lf hPa\e[K\n", (double)pressure / 100.0);
-    fprintf(out_file, "altitude : %f m\e[K\n", bme280_readAltitude(pressure,
-            SEALEVELPRESSURE_HPA));
-    fflush(out_file);
+static int set_channel_period(int c, const char * value) {
+    return ((channel_period[c] = schedule_parse_period(value)) == 0) ? -1 : 0;
 }
 
-void out_json() {
-    time_t timer;
-    char buffer[26] = {};
-    struct tm* tm_info;
-
-    time(&timer);
-    tm_info = localtime(&timer);
-    strftime(buffer, sizeof(buffer) - 1, "%Y-%m-%d %H:%M:%S", tm_info);
-    if (bme280_read_pressure_temperature_humidity(
-                (u32*)&pressure, &temperature, (u32*)&humidity) == -1) {
-        daemon_log(LOG_ERR, "%s Error communication with bme280", __FUNCTION__);
-        return;
+static int set_channel_threshold(int c, const char * value) {
+    char * end = NULL;
+
+    channel_threshold[c] = strtof(value, &end);
+    return ((end == value) || (*end) || (channel_threshold[c] < 0)) ? -1 : 0;
+}
+
+/* "pressure=1s,uv=10s", set is given every channel and its value */
+static int parse_channel_list(const char * list, int (* set)(int c, const char * value)) {
+    char * copy = xstrdup(list);
+    char * save = NULL;
+    int result = 0;
+
+    for (char * item = strtok_r(copy, ",", &save); item; item = strtok_r(NULL, ",", &save)) {
+        char * value = strchr(item, '=');
+        int c;
+
+        if (value)
+            *value++ = 0;
+        if ((!value) || ((c = board_channel_parse(item)) < 0) || (set(c, value) < 0)) {
+            result = -1;
+            break;
+        }
     }
+    FREE(copy);
+    return result;
+}
+
+static void add_board(const char * spec) {
+    struct board_t * board;
+
+    if ((board = board_new(spec, &board_config)) == NULL)
+        usage();
+    board->si1132_gpio = pending_gpio;
+    pending_gpio = -1;
+    boards = xrealloc(boards, (boards_count + 1) * sizeof(*boards));
+    boards[boards_count++] = board;
+}
+
+/* The last value of every channel of a board, the channels that are
+   not due in a burst keep theirs. fresh has the channels of every device
+   slot read in the current burst, at when each was read last. */
+struct board_values_t {
+    bool light_valid;
+    struct si1132_data_t light;
+    struct bme280_sample_t samples[BOARD_MAX_BME280];
+    int result[BOARD_MAX_BME280];
+    struct metrics_cache_t metrics_cache[BOARD_MAX_BME280];
+    unsigned int fresh[BOARD_MAX_DEV];
+    uint64_t at[BOARD_MAX_DEV][BOARD_CH_COUNT];     /* usec, monotonic */
+};
+
+/* "" for a value read in this burst, else how old it is */
+static const char * out_age(char * buf, size_t size, const struct board_values_t * values, int d, int c,
+                            uint64_t now) {
+    if (values->fresh[d] & BOARD_CH(c))
+        return "";
+    snprintf(buf, size, " (%llu s ago)", (unsigned long long)(now - values->at[d][c]) / 1000000);
+    return buf;
+}
 
-    if (fprintf(out_file,
-            "{\"time\": \"%s\", \"brand\": \"ODROID\", \"model\": \"WB2\", \"id\": 0, \"channel\": 1, \"battery\": \"OK\", \
-\"temperature_C\": %.2lf, \"humidity\": %.2lf, \"pressure\": %.2lf, \"altitude\": %f, \
-\"uv_index\": %.2f, \"visible\": %.0f, \"ir\": %.0f}\n", buffer,
-            (double)temperature / 100.0, (double)humidity / 1024.0, (double)pressure / 100.0, bme280_readAltitude(pressure, SEALEVELPRESSURE_HPA),
-            Si1132_readUV() / 100.0, Si1132_readVisible(), Si1132_readIR() ) < 0) {
-       daemon_log(LOG_ERR, "%s Error write to file (%d) %s", __FUNCTION__, errno, strerror(errno));
+/* Call with out_lock held, all boards share the one out file. The
+   screen shows every channel, the ones not read in this burst with
+   their age. now and wall are when the burst started, monotonic and
+   CLOCK_REALTIME. */
+static void out_text(struct board_t * board, const struct board_values_t * values,
+                     const struct metrics_t * metrics, uint64_t now, uint64_t wall) {
+    const struct si1132_data_t * light = &values->light;
+    char buffer[32];
+    char age[32];
+
+    capture_format_time(buffer, sizeof(buffer), wall, out_msec);
+    if (boards_count == 1) {
+        fprintf(out_file, "\e[H");
     } else {
-	 daemon_log(LOG_INFO, "write ok");
+        fprintf(out_file, "######## %s ########\e[K\n", board->device);
+    }
+    fprintf(out_file, "time : %s\e[K\n", buffer);
+    fprintf(out_file, "======== si1132 ========\n");
+    fprintf(out_file, "UV_index : %.2f%s\e[K\n", light->uv,
+            out_age(age, sizeof(age), values, BOARD_DEV_SI1132, BOARD_CH_UV, now));
+    fprintf(out_file, "Visible : %.0f Lux%s\e[K\n", light->visible,
+            out_age(age, sizeof(age), values, BOARD_DEV_SI1132, BOARD_CH_VISIBLE, now));
+    fprintf(out_file, "IR : %.0f Lux%s\e[K\n", light->ir,
+            out_age(age, sizeof(age), values, BOARD_DEV_SI1132, BOARD_CH_IR, now));
+
+    for (int i = 0; i < board->bme280_count; i++) {
+        const struct bme280_sample_t * sample = &values->samples[i];
+        int d = BOARD_DEV_BME280(i);
+
+        if (board->bme280_count > 1) {
+            fprintf(out_file, "======== bme280 0x%02x ========\n", board->bme280[i].dev_addr);
+        } else {
+            fprintf(out_file, "======== bme280 ========\n");
+        }
+        fprintf(out_file, "temperature : %.2lf 'C%s\e[K\n", (double)sample->temperature / 100.0,
+                out_age(age, sizeof(age), values, d, BOARD_CH_TEMPERATURE, now));
+        fprintf(out_file, "humidity : %.2lf %%%s\e[K\n", (double)sample->humidity / 1024.0,
+                out_age(age, sizeof(age), values, d, BOARD_CH_HUMIDITY, now));
+        fprintf(out_file, "pressure : %.2lf hPa%s\e[K\n", (double)sample->pressure / 100.0,
+                out_age(age, sizeof(age), values, d, BOARD_CH_PRESSURE, now));
+        fprintf(out_file, "altitude : %f m\e[K\n", bme280_altitude(sample->pressure,
+                SEALEVELPRESSURE_HPA));
+        if (metrics_mask & METRIC_DEW_POINT)
+            fprintf(out_file, "dew point : %.2f 'C\e[K\n", metrics[i].dew_point);
+        if (metrics_mask & METRIC_HEAT_INDEX)
+            fprintf(out_file, "heat index : %.2f 'C\e[K\n", metrics[i].heat_index);
+        if (metrics_mask & METRIC_ABS_HUMIDITY)
+            fprintf(out_file, "absolute humidity : %.2f g/m3\e[K\n", metrics[i].abs_humidity);
+        if (metrics_mask & METRIC_SEA_LEVEL)
+            fprintf(out_file, "sea level pressure : %.2f hPa\e[K\n", metrics[i].sea_level);
+    }
+    fflush(out_file);
+}
+
+/* A record has the members of the channels read in this burst only,
+   so stored data never repeats an older value. A BME280 record carries
+   the fresh light values too, when no BME280 was read they go out in a
+   record of their own, without an address. */
+static void out_json(struct board_t * board, const struct board_values_t * values,
+                     const struct metrics_t * metrics, uint64_t wall) {
+    unsigned int light_fresh = values->fresh[BOARD_DEV_SI1132];
+    const struct si1132_data_t * light = &values->light;
+    bool written = false;
+    char buffer[32];
+    char head[256];
+    char light_json[96] = "";
+    char derived[160];
+    int n = 0;
+
+    capture_format_time(buffer, sizeof(buffer), wall, out_msec);
+    snprintf(head, sizeof(head),
+             "{\"time\": \"%s\", \"brand\": \"ODROID\", \"model\": \"WB2\", \"id\": 0, \"channel\": 1, \"battery\": \"OK\", \
+\"bus\": \"%s\"", buffer, board->device);
+
+    if (light_fresh & BOARD_CH(BOARD_CH_UV))
+        n += snprintf(light_json + n, sizeof(light_json) - n, ", \"uv_index\": %.2f", light->uv);
+    if (light_fresh & BOARD_CH(BOARD_CH_VISIBLE))
+        n += snprintf(light_json + n, sizeof(light_json) - n, ", \"visible\": %.0f", light->visible);
+    if (light_fresh & BOARD_CH(BOARD_CH_IR))
+        snprintf(light_json + n, sizeof(light_json) - n, ", \"ir\": %.0f", light->ir);
+
+    for (int i = 0; i < board->bme280_count; i++) {
+        unsigned int fresh = values->fresh[BOARD_DEV_BME280(i)];
+        const struct bme280_sample_t * sample = &values->samples[i];
+        unsigned int mask = metrics_mask;
+        char bme280_json[160] = "";
+
+        if ((!fresh) || (values->result[i] < 0))
+            continue;
+        n = 0;
+        if (fresh & BOARD_CH(BOARD_CH_TEMPERATURE))
+            n += snprintf(bme280_json + n, sizeof(bme280_json) - n, ", \"temperature_C\": %.2lf",
+                          (double)sample->temperature / 100.0);
+        if (fresh & BOARD_CH(BOARD_CH_HUMIDITY))
+            n += snprintf(bme280_json + n, sizeof(bme280_json) - n, ", \"humidity\": %.2lf",
+                          (double)sample->humidity / 1024.0);
+        if (fresh & BOARD_CH(BOARD_CH_PRESSURE))
+            snprintf(bme280_json + n, sizeof(bme280_json) - n, ", \"pressure\": %.2lf, \"altitude\": %f",
+                     (double)sample->pressure / 100.0, bme280_altitude(sample->pressure, SEALEVELPRESSURE_HPA));
+        /* a derived value goes out with a fresh input */
+        if (!(fresh & (BOARD_CH(BOARD_CH_TEMPERATURE) | BOARD_CH(BOARD_CH_HUMIDITY))))
+            mask &= ~(METRIC_DEW_POINT | METRIC_HEAT_INDEX | METRIC_ABS_HUMIDITY);
+        if (!(fresh & BOARD_CH(BOARD_CH_PRESSURE)))
+            mask &= ~METRIC_SEA_LEVEL;
+        metrics_json(derived, sizeof(derived), mask, &metrics[i]);
+        if (fprintf(out_file, "%s, \"address\": \"0x%02x\"%s%s%s}\n", head, board->bme280[i].dev_addr,
+                    bme280_json, light_json, derived) < 0) {
+            daemon_log(LOG_ERR, "%s Error write to file (%d) %s", __FUNCTION__, errno, strerror(errno));
+        } else {
+            daemon_log(LOG_INFO, "write ok");
+        }
+        written = true;
+    }
+    if ((!written) && (light_fresh)) {
+        if (fprintf(out_file, "%s%s}\n", head, light_json) < 0) {
+            daemon_log(LOG_ERR, "%s Error write to file (%d) %s", __FUNCTION__, errno, strerror(errno));
+        } else {
+            daemon_log(LOG_INFO, "write ok");
+        }
     }
     fflush(out_file);
 }
 
+/* Raw capture: register frames only, no compensation here, the devices
+   with no channel due are left out of the record */
+static void board_capture(struct board_t * board, unsigned int due, uint64_t wall) {
+    struct capture_record_t record = {magic: CAPTURE_MAGIC_RECORD, flags: out_msec ? CAPTURE_TIME_MSEC : 0,
+                                      time_usec: wall};
+    struct capture_slot_t * slot;
+    bool changed = false;
+
+    for (record.slot = 0; (record.slot < boards_count) && (boards[record.slot] != board); record.slot++);
+    if ((due & BOARD_CH_SI1132) && (board_read_si1132_raw(board, record.si1132) == 0))
+        record.flags |= CAPTURE_SI1132_OK;
+    for (int i = 0; (due & BOARD_CH_BME280) && (i < board->bme280_count); i++) {
+        if (board_read_bme280_raw(board, i, record.bme280[i]) == 0)
+            record.flags |= CAPTURE_BME280_OK(i);
+    }
 
-static
-void * main_loop (void * p) {
-    daemon_log(LOG_INFO, "%s started", __FUNCTION__);
-    while (!do_exit) {
+    pthread_mutex_lock(&out_lock);
+    if ((out_file != stdout) && (access(out_filename, F_OK) == -1)) {
+        close_outfile();
+        open_outfile();
+    }
+    /* a device seen for the first time, or with other trimming
+       parameters than in the header, starts a new segment */
+    slot = &capture_header.slot[record.slot];
+    for (int i = 0; i < board->bme280_count; i++) {
+        struct capture_device_t device = {addr: board->bme280[i].dev_addr, chip_id: board->bme280[i].chip_id, valid: 1};
+
+        if (!(record.flags & CAPTURE_BME280_OK(i)))
+            continue;
+        capture_calib_pack(&device.calib, &board->bme280[i].cal_param);
+        if (memcmp(&device, &slot->bme280[i], sizeof(device)) != 0) {
+            slot->bme280[i] = device;
+            changed = true;
+        }
+    }
+    if ((out_file) && ((changed) || (!capture_header_written))) {
+        capture_header_written = (fwrite(&capture_header, sizeof(capture_header), 1, out_file) == 1);
+        if (!capture_header_written)
+            daemon_log(LOG_ERR, "%s Error write to file (%d) %s", __FUNCTION__, errno, strerror(errno));
+    }
+    if ((out_file) && (capture_header_written)) {
+        if (fwrite(&record, sizeof(record), 1, out_file) != 1)
+            daemon_log(LOG_ERR, "%s Error write to file (%d) %s", __FUNCTION__, errno, strerror(errno));
+        fflush(out_file);
+    }
+    pthread_mutex_unlock(&out_lock);
+}
 
-        if ((out_file != stdout) && (access(out_filename, F_OK) == -1)) {
-            close_outfile();
-            open_outfile();
+/* Sampling talks to the bus without the out lock, so a slow adapter
+   never holds up the others, only the writes are serialized. A device
+   is read once per burst whichever of its channels are due, only those
+   channels take the new values. The channels that had a value before
+   are returned, with how far they moved in change (the most of the
+   BME280 on the board) and the time since the reading before in
+   interval. Everything of the burst is stamped with when it
+   started, now on the monotonic clock, wall on CLOCK_REALTIME. */
+static unsigned int board_sample(struct board_t * board, unsigned int due, struct board_values_t * values,
+                                 float * change, uint64_t * interval, uint64_t now, uint64_t wall) {
+    struct si1132_data_t light;
+    struct bme280_sample_t sample;
+    struct metrics_t metrics[BOARD_MAX_BME280] = {};
+    unsigned int changed = 0;
+
+    if (out_format == O_RAW) {
+        board_capture(board, due, wall);
+        return 0;
+    }
+    memset(values->fresh, 0, sizeof(values->fresh));
+    if (due & BOARD_CH_SI1132) {
+        int result = board_read_si1132(board, &light);
+
+        if (result == -1) {
+            daemon_log(LOG_ERR, "%s %s Error communication with si1132", __FUNCTION__, board->device);
+        } else if (result >= 0) {
+            if (values->light_valid) {
+                change[BOARD_CH_VISIBLE] = fabsf(light.visible - values->light.visible);
+                change[BOARD_CH_IR] = fabsf(light.ir - values->light.ir);
+                change[BOARD_CH_UV] = fabsf(light.uv - values->light.uv);
+                for (int c = BOARD_CH_VISIBLE; c <= BOARD_CH_UV; c++)
+                    interval[c] = now - values->at[BOARD_DEV_SI1132][c];
+                changed |= due & BOARD_CH_SI1132;
+            }
+            values->light_valid = true;
+            values->fresh[BOARD_DEV_SI1132] = due & BOARD_CH_SI1132;
+            if (due & BOARD_CH(BOARD_CH_VISIBLE))
+                values->light.visible = light.visible;
+            if (due & BOARD_CH(BOARD_CH_IR))
+                values->light.ir = light.ir;
+            if (due & BOARD_CH(BOARD_CH_UV))
+                values->light.uv = light.uv;
+        }
+    }
+    for (int i = 0; (due & BOARD_CH_BME280) && (i < board->bme280_count); i++) {
+        bool valid = (values->result[i] >= 0);
+
+        if ((values->result[i] = board_read_bme280(board, i, &sample)) == -1) {
+            daemon_log(LOG_ERR, "%s %s Error communication with bme280 0x%02x", __FUNCTION__, board->device,
+                       board->bme280[i].dev_addr);
+        } else if (values->result[i] >= 0) {
+            if (valid) {
+                float moved[] = {
+                    [BOARD_CH_TEMPERATURE] = fabsf((sample.temperature - values->samples[i].temperature) / 100.0f),
+                    [BOARD_CH_PRESSURE] = fabsf(((float)sample.pressure - values->samples[i].pressure) / 100.0f),
+                    [BOARD_CH_HUMIDITY] = fabsf(((float)sample.humidity - values->samples[i].humidity) / 1024.0f),
+                };
+
+                for (int c = BOARD_CH_TEMPERATURE; c <= BOARD_CH_HUMIDITY; c++) {
+                    if (!(changed & BOARD_CH(c)) || (moved[c] > change[c])) {
+                        change[c] = moved[c];
+                        interval[c] = now - values->at[BOARD_DEV_BME280(i)][c];
+                    }
+                }
+                changed |= due & BOARD_CH_BME280;
+            }
+            values->fresh[BOARD_DEV_BME280(i)] = due & BOARD_CH_BME280;
+            if (due & BOARD_CH(BOARD_CH_TEMPERATURE))
+                values->samples[i].temperature = sample.temperature;
+            if (due & BOARD_CH(BOARD_CH_PRESSURE))
+                values->samples[i].pressure = sample.pressure;
+            if (due & BOARD_CH(BOARD_CH_HUMIDITY))
+                values->samples[i].humidity = sample.humidity;
+        }
+    }
+    for (int d = 0; d < board->dev_count; d++) {
+        for (int c = 0; c < BOARD_CH_COUNT; c++) {
+            if (values->fresh[d] & BOARD_CH(c))
+                values->at[d][c] = now;
         }
+    }
+    for (int i = 0; (metrics_mask) && (i < board->bme280_count); i++) {
+        if (values->result[i] >= 0)
+            metrics_compute(&values->metrics_cache[i], metrics_mask, sea_level_factor, values->samples[i].temperature,
+                            values->samples[i].humidity, values->samples[i].pressure, &metrics[i]);
+    }
 
+    pthread_mutex_lock(&out_lock);
+    if ((out_file != stdout) && (access(out_filename, F_OK) == -1)) {
+        close_outfile();
+        open_outfile();
+    }
+    if (out_file) {
         if (out_format == O_TEXT) {
-            out_text();
+            out_text(board, values, metrics, now, wall);
         } else {
-            out_json();
+            out_json(board, values, metrics, wall);
         }
+    }
+    pthread_mutex_unlock(&out_lock);
+    return changed;
+}
 
-        int c_delay = 0;
-        while ((!do_exit) && (c_delay < 20)) {
-            sleep(1);
-            c_delay++;
-        }
+struct board_worker_t {
+    struct board_t * board;
+    int timer_fd;
+    struct board_values_t values;
+};
+
+static void board_timer_event(struct reactor_t * reactor, int fd, uint32_t events, void * arg) {
+    struct board_worker_t * worker = arg;
+    struct board_t * board = worker->board;
+    uint64_t expirations;
+    uint64_t started, wall;
+    struct timespec ts;
+    unsigned int due, changed;
+    float change[BOARD_CH_COUNT];
+    uint64_t interval[BOARD_CH_COUNT];
+
+    if (read(fd, &expirations, sizeof(expirations)) < 0)
+        return;
+    started = schedule_monotonic();
+    /* the deadlines are on wall clock multiples, time() reads the coarse
+       clock and can stamp a sample a tick after :00 with the second before */
+    clock_gettime(CLOCK_REALTIME, &ts);
+    wall = ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+    if ((due = schedule_due(&board->schedule, started)) != 0) {
+        if (due & BOARD_CH_BME280)
+            board_verify(board);
+        changed = board_sample(board, due, &worker->values, change, interval, started, wall);
+        schedule_next(&board->schedule, started);
+        board_adapt(board, changed, change, interval);
+    }
+    if (schedule_arm(&board->schedule, fd) < 0) {
+        daemon_log(LOG_ERR, "%s %s timerfd_settime error (%d) %s", __FUNCTION__, board->device, errno, strerror(errno));
+        reactor_stop(reactor);
+    }
+}
+
+static void board_wake_event(struct reactor_t * reactor, int fd, uint32_t events, void * arg) {
+    struct board_worker_t * worker = arg;
+
+    board_apply_profile(worker->board);
+    /* a shorter period may have brought a deadline forward */
+    if (schedule_arm(&worker->board->schedule, worker->timer_fd) < 0) {
+        daemon_log(LOG_ERR, "%s %s timerfd_settime error (%d) %s", __FUNCTION__, worker->board->device, errno, strerror(errno));
+        reactor_stop(reactor);
+    }
+}
+
+static void board_exit_event(struct reactor_t * reactor, int fd, uint32_t events, void * arg) {
+    reactor_stop(reactor);
+}
 
+/* One worker per adapter, boards on different buses never wait
+   for each other. The worker sleeps in its own reactor on the sampling
+   timer and exit_fd, a burst may hold the bus for a while and must not
+   hold up the main loop or the other boards. */
+static
+void * board_loop (void * p) {
+    struct board_worker_t worker = {board: p, timer_fd: -1};
+    struct board_t * board = worker.board;
+    struct reactor_t * reactor;
+
+    daemon_log(LOG_INFO, "%s %s started", __FUNCTION__, board->device);
+    if ((worker.timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK)) < 0) {
+        daemon_log(LOG_ERR, "%s %s timerfd_create error (%d) %s", __FUNCTION__, board->device, errno, strerror(errno));
+        return NULL;
+    }
+    if ((reactor = reactor_new()) == NULL) {
+        close(worker.timer_fd);
+        return NULL;
+    }
+    for (int i = 0; i < BOARD_MAX_BME280; i++)
+        worker.values.result[i] = BOARD_DEVICE_DOWN;
+    board_begin(board);
+    schedule_start(&board->schedule);
+    if (schedule_arm(&board->schedule, worker.timer_fd) < 0) {
+        daemon_log(LOG_ERR, "%s %s timerfd_settime error (%d) %s", __FUNCTION__, board->device, errno, strerror(errno));
+    } else if ((reactor_add(reactor, worker.timer_fd, EPOLLIN, board_timer_event, &worker) == 0) &&
+               (reactor_add(reactor, board->wake_fd, EPOLLIN, board_wake_event, &worker) == 0) &&
+               (reactor_add(reactor, exit_fd, EPOLLIN, board_exit_event, NULL) == 0)) {
+        reactor_run(reactor);
     }
 
-    daemon_log(LOG_INFO, "%s finished", __FUNCTION__);
+    reactor_free(reactor);
+    close(worker.timer_fd);
+    board_end(board);
+    daemon_log(LOG_INFO, "%s %s finished", __FUNCTION__, board->device);
     return NULL;
 }
 
+//------------------------------------------------------------------------------------------------------------
+//
+// Main loop:
+//
+//------------------------------------------------------------------------------------------------------------
+
+/* The main thread only waits for signals, with no timeout it does
+   not wake up at all between them */
+static void signal_event(struct reactor_t * reactor, int fd, uint32_t events, void * arg) {
+    int sig;
+
+    while ((sig = daemon_signal_next()) > 0) {
+        switch (sig) {
+        case SIGCHLD: {
+            int ret = 0;
+            daemon_log(LOG_INFO, "SIG_CHLD");
+            wait(&ret);
+            daemon_log(LOG_INFO, "RET=%d", ret);
+        }
+        break;
+
+        case SIGINT:
+        case SIGQUIT:
+        case SIGTERM:
+            daemon_log(LOG_WARNING, "Got SIGINT, SIGQUIT or SIGTERM");
+            do_exit = true;
+            reactor_stop(reactor);
+            break;
+
+        case SIGUSR1: {
+            daemon_log(LOG_WARNING, "Got SIGUSR1");
+            daemon_log(LOG_WARNING, "Enter in debug mode, to stop send me USR2 signal");
+            daemon_log_upto(LOG_DEBUG);
+            break;
+        }
+        case SIGUSR2: {
+            daemon_log(LOG_WARNING, "Got SIGUSR2");
+            daemon_log(LOG_WARNING, "Leave debug mode");
+            daemon_log_upto(LOG_INFO);
+            break;
+        }
+        case SIGHUP:
+            daemon_log(LOG_WARNING, "Got SIGHUP");
+            for (int i = 0; i < boards_count; i++) {
+                board_log_stats(boards[i]);
+                schedule_log_stats(&boards[i]->schedule, boards[i]->device);
+                for (int c = 0; c < BOARD_CH_COUNT; c++)
+                    adapt_log_stats(&boards[i]->adapt, boards[i]->device, c, board_channel_name[c]);
+            }
+            daemon_log(LOG_INFO, "main loop woke up %llu times", (unsigned long long)reactor_wakeups(reactor));
+            break;
+
+        case SIGSEGV:
+            daemon_log(LOG_ERR, "Seg fault. Core dumped to /tmp/core.");
+            if (chdir("/tmp") < 0) {
+                daemon_log(LOG_ERR, "Chdir to /tmp error: %s", strerror(errno));
+            }
+            signal(sig, SIG_DFL);
+            kill(getpid(), sig);
+            break;
+
+        default:
+            daemon_log(LOG_ERR, "UNKNOWN SIGNAL:%s", strsignal(sig));
+            break;
+
+        }
+    }
+    if (sig < 0) {
+        daemon_log(LOG_ERR, "daemon_signal_next() failed.");
+        reactor_stop(reactor);
+    }
+}
+
+/* "profile name" */
+static void control_event(struct reactor_t * reactor, int fd, uint32_t events, void * arg) {
+    char command[CONTROL_MAX_COMMAND];
+
+    while (control_recv(fd, command, sizeof(command)) > 0) {
+        const struct bme280_profile_t * profile;
+
+        if (strncmp(command, "profile ", 8) == 0) {
+            if ((profile = bme280_profile_find(command + 8)) == NULL) {
+                daemon_log(LOG_WARNING, "Control: unknown profile %s", command + 8);
+                continue;
+            }
+            daemon_log(LOG_INFO, "Control: switching to the %s profile", profile->name);
+            for (int i = 0; i < boards_count; i++)
+                board_request_profile(boards[i], profile);
+        } else {
+            daemon_log(LOG_WARNING, "Control: unknown command %s", command);
+        }
+    }
+}
+
 //------------------------------------------------------------------------------------------------------------
 //
 // Start Program:
@@ -236,10 +767,7 @@ main (int argc, char *const *argv) {
     int debug = 0;
     char * command = NULL;
     pid_t pid;
-    pthread_t main_th = 0;
-    char *device = "/dev/i2c-1";
 
-    int    fd, sel_res;
 
     daemon_pid_file_ident = daemon_log_ident = application;
 
@@ -271,7 +799,7 @@ main (int argc, char *const *argv) {
     daemon_log_upto(LOG_INFO);
     daemon_log(LOG_INFO, "%s %s", pathname, progname);
 
-    while ((flags = getopt(argc, argv, "i:fF:D:dk:")) != -1) {
+    while ((flags = getopt(argc, argv, "i:fF:D:S:C:L:g:c:o:M:A:p:P:a:t:dk:")) != -1) {
         switch (flags) {
 
         case 'k': {
@@ -293,6 +821,9 @@ main (int argc, char *const *argv) {
             } else if (strncmp(optarg, "text", 4) == 0) {
                 out_format = O_TEXT;
                 out_filename = arg_param(optarg);
+            } else if (strncmp(optarg, "raw", 3) == 0) {
+                out_format = O_RAW;
+                out_filename = arg_param(optarg);
             } else {
                 daemon_log(LOG_ERR, "Invalid output format %s", optarg);
                 usage();
@@ -305,7 +836,107 @@ main (int argc, char *const *argv) {
             break;
         }
         case 'D': {
-            device = strdup(optarg);
+            add_board(optarg);
+            break;
+        }
+        case 'C': {
+            board_config.calib_dir = (strcmp(optarg, "-") == 0) ? NULL : xstrdup(optarg);
+            break;
+        }
+        case 'L': {
+            if (strcmp(optarg, "auto") == 0) {
+                board_config.si1132_mode = Si1132_MODE_AUTO;
+            } else if (strcmp(optarg, "forced") == 0) {
+                board_config.si1132_mode = Si1132_MODE_FORCED;
+            } else {
+                daemon_log(LOG_ERR, "Invalid light sensor mode %s", optarg);
+                usage();
+            }
+            break;
+        }
+        case 'g': {
+            /* INT of the board given by the last -D, or of the default one */
+            if (boards_count) {
+                boards[boards_count - 1]->si1132_gpio = atoi(optarg);
+            } else {
+                pending_gpio = atoi(optarg);
+            }
+            break;
+        }
+        case 'p': {
+            if ((sample_period = schedule_parse_period(optarg)) == 0) {
+                daemon_log(LOG_ERR, "Invalid sampling period %s", optarg);
+                usage();
+            }
+            break;
+        }
+        case 'P': {
+            if (parse_channel_list(optarg, set_channel_period) < 0) {
+                daemon_log(LOG_ERR, "Invalid channel periods %s", optarg);
+                usage();
+            }
+            break;
+        }
+        case 'a': {
+            if ((adapt_min_period = schedule_parse_period(optarg)) == 0) {
+                daemon_log(LOG_ERR, "Invalid adaptive sampling period %s", optarg);
+                usage();
+            }
+            break;
+        }
+        case 't': {
+            if (parse_channel_list(optarg, set_channel_threshold) < 0) {
+                daemon_log(LOG_ERR, "Invalid thresholds %s", optarg);
+                usage();
+            }
+            break;
+        }
+        case 'M': {
+            int mask = metrics_parse(optarg);
+            if (mask < 0) {
+                daemon_log(LOG_ERR, "Invalid metrics %s", optarg);
+                usage();
+            }
+            metrics_mask = mask;
+            break;
+        }
+        case 'A': {
+            station_altitude = atof(optarg);
+            break;
+        }
+        case 'o': {
+            if ((board_config.profile = bme280_profile_find(optarg)) == NULL) {
+                daemon_log(LOG_ERR, "Invalid bme280 profile %s", optarg);
+                usage();
+            }
+            break;
+        }
+        case 'c': {
+            if (strcmp(optarg, "int32") == 0) {
+                board_config.compensation = BME280_COMPENSATION_INT32;
+            } else if (strcmp(optarg, "int64") == 0) {
+                board_config.compensation = BME280_COMPENSATION_INT64;
+            } else if (strcmp(optarg, "double") == 0) {
+                board_config.compensation = BME280_COMPENSATION_DOUBLE;
+            } else {
+                daemon_log(LOG_ERR, "Invalid compensation %s", optarg);
+                usage();
+            }
+            break;
+        }
+        case 'S': {
+            if (strcmp(optarg, "normal") == 0) {
+                board_config.power_mode = BME280_NORMAL_MODE;
+            } else if (strcmp(optarg, "forced") == 0) {
+                board_config.power_mode = BME280_FORCED_MODE;
+                board_config.forced_wait = BME280_FORCED_WAIT_FIXED;
+            } else if (strcmp(optarg, "poll") == 0) {
+                board_config.power_mode = BME280_FORCED_MODE;
+                board_config.forced_wait = BME280_FORCED_WAIT_POLL;
+            } else {
+                daemon_log(LOG_ERR, "Invalid sampling mode %s", optarg);
+                usage();
+            }
             break;
         }
         default: {
@@ -315,6 +946,23 @@ main (int argc, char *const *argv) {
         }
     }
 
+    if (!boards_count) {
+        add_board("/dev/i2c-1");
+    }
+    sea_level_factor = metrics_sea_level_factor(station_altitude);
+    for (int c = 0; c < BOARD_CH_COUNT; c++) {
+        if (!channel_period[c])
+            channel_period[c] = sample_period;
+        if (channel_period[c] < 1000000ULL)
+            out_msec = true;
+    }
+    if ((adapt_min_period) && (adapt_min_period < 1000000ULL))
+        out_msec = true;
+    if ((out_format == O_RAW) && (boards_count > CAPTURE_MAX_SLOTS)) {
+        daemon_log(LOG_ERR, "Raw capture takes at most %d boards", CAPTURE_MAX_SLOTS);
+        usage();
+    }
+
     if (debug) {
         daemon_log(LOG_DEBUG,    "**************************");
         daemon_log(LOG_DEBUG,    "* WARNING !!! Debug mode *");
@@ -326,9 +974,14 @@ main (int argc, char *const *argv) {
     daemon_log(LOG_INFO, "pid file: %s", daemon_pid_file_proc());
     if (command) {
         int r = CMD_NOT_FOUND;
+        /* "name" or "name:argument" */
         for (unsigned int i = 0; i < (sizeof(daemon_commands) / sizeof(daemon_commands[0])); i++) {
-            if ((strcasecmp(command, daemon_commands[i].command_name) == 0) && (daemon_commands[i].command_callback)) {
-                if ((r = daemon_commands[i].command_callback(pathname)) != 0) exit(abs(r - 10));
+            size_t len = strlen(daemon_commands[i].command_name);
+
+            if ((strncasecmp(command, daemon_commands[i].command_name, len) == 0) &&
+                    ((command[len] == 0) || (command[len] == ':')) && (daemon_commands[i].command_callback)) {
+                if ((r = daemon_commands[i].command_callback(command[len] ? arg_param(command) : pathname)) != 0)
+                    exit(abs(r - 10));
             }
         }
         if (r == CMD_NOT_FOUND) {
@@ -397,95 +1050,63 @@ main (int argc, char *const *argv) {
 
         main_pid = syscall(SYS_gettid);
 
-        si1132_begin(device);
-        bme280_begin(device);
+        for (int i = 0; i < boards_count; i++) {
+            if (board_open(boards[i]) < 0)
+                goto finish;
+        }
+        if ((board_config.calib_dir) && (mkdir(board_config.calib_dir, 0755) < 0) && (errno != EEXIST)) {
+            daemon_log(LOG_WARNING, "Unable to create %s (%d) %s", board_config.calib_dir, errno, strerror(errno));
+        }
 	umask(0022);
         open_outfile();
 
-        pthread_create( &main_th, NULL, main_loop, NULL);
-// main
-
-        fd_set fds;
-        FD_ZERO(&fds);
-        fd = daemon_signal_fd();
-        FD_SET(fd,  &fds);
-
-        while (!do_exit) {
-            struct timeval tv;
-            tv.tv_sec  = 0;
-            tv.tv_usec = 100000;
-            fd_set fds2 = fds;
-            if ((sel_res = select(FD_SETSIZE, &fds2, 0, 0, &tv)) < 0) {
-
-                if (errno == EINTR)
-                    continue;
-
-                daemon_log(LOG_ERR, "select() error:%d %s", errno,  strerror(errno));
-                break;
-            }
-            if (FD_ISSET(fd, &fds2)) {
-                int sig;
-
-                if ((sig = daemon_signal_next()) <= 0) {
-                    daemon_log(LOG_ERR, "daemon_signal_next() failed.");
-                    break;
-                }
-
-                switch (sig) {
-                case SIGCHLD: {
-                    int ret = 0;
-                    daemon_log(LOG_INFO, "SIG_CHLD");
-                    wait(&ret);
-                    daemon_log(LOG_INFO, "RET=%d", ret);
-                }
-                break;
-
-                case SIGINT:
-                case SIGQUIT:
-                case SIGTERM:
-                    daemon_log(LOG_WARNING, "Got SIGINT, SIGQUIT or SIGTERM");
-                    do_exit = true;
-                    break;
-
-                case SIGUSR1: {
-                    daemon_log(LOG_WARNING, "Got SIGUSR1");
-                    daemon_log(LOG_WARNING, "Enter in debug mode, to stop send me USR2 signal");
-                    daemon_log_upto(LOG_DEBUG);
-                    break;
-                }
-                case SIGUSR2: {
-                    daemon_log(LOG_WARNING, "Got SIGUSR2");
-                    daemon_log(LOG_WARNING, "Leave debug mode");
-                    daemon_log_upto(LOG_INFO);
-                    break;
-                }
-                case SIGHUP:
-                    daemon_log(LOG_WARNING, "Got SIGHUP");
-                    break;
-
-                case SIGSEGV:
-                    daemon_log(LOG_ERR, "Seg fault. Core dumped to /tmp/core.");
-                    if (chdir("/tmp") < 0) {
-                        daemon_log(LOG_ERR, "Chdir to /tmp error: %s", strerror(errno));
-                    }
-                    signal(sig, SIG_DFL);
-                    kill(getpid(), sig);
-                    break;
-
-                default:
-                    daemon_log(LOG_ERR, "UNKNOWN SIGNAL:%s", strsignal(sig));
-                    break;
-
-                }
+        if ((exit_fd = eventfd(0, EFD_CLOEXEC)) < 0) {
+            daemon_log(LOG_ERR, "eventfd error (%d) %s", errno, strerror(errno));
+            goto finish;
+        }
+        for (int i = 0; i < boards_count; i++) {
+            board_schedule_init(boards[i], channel_period);
+            board_adapt_init(boards[i], adapt_min_period, channel_threshold);
+            if (pthread_create(&boards[i]->th, NULL, board_loop, boards[i]) != 0) {
+                daemon_log(LOG_ERR, "%s pthread_create error (%d) %s", boards[i]->device, errno, strerror(errno));
+                boards[i]->th = 0;
             }
         }
+// main
 
+        if ((main_reactor = reactor_new()) == NULL)
+            goto finish;
+        if (reactor_add(main_reactor, daemon_signal_fd(), EPOLLIN, signal_event, NULL) < 0)
+            goto finish;
+        control_socket = control_path(daemon_pid_file_proc());
+        if (((control_fd = control_open(control_socket)) < 0) ||
+                (reactor_add(main_reactor, control_fd, EPOLLIN, control_event, NULL) < 0))
+            daemon_log(LOG_WARNING, "No control socket, the profile is fixed");
+        reactor_run(main_reactor);
     }
 
 finish:
     daemon_log(LOG_INFO, "Exiting...");
-    pthread_join(main_th, NULL);
+    do_exit = true;
+    if (exit_fd >= 0) {
+        uint64_t one = 1;
+        if (write(exit_fd, &one, sizeof(one)) < 0)
+            daemon_log(LOG_ERR, "eventfd write error (%d) %s", errno, strerror(errno));
+    }
+    for (int i = 0; i < boards_count; i++) {
+        if (boards[i]->th)
+            pthread_join(boards[i]->th, NULL);
+    }
+    if (exit_fd >= 0)
+        close(exit_fd);
+    reactor_free(main_reactor);
+    control_close(control_fd, control_socket);
+    FREE(control_socket);
     close_outfile();
+    for (int i = 0; i < boards_count; i++) {
+        board_free(boards[i]);
+    }
+    FREE(boards);
     FREE(hostname);
     FREE(pathname);
     daemon_retval_send(-1);